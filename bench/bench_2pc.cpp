@@ -0,0 +1,87 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:37:15
+ */
+
+// Description: Measures how coalescing two-phase commit messages amortizes round trips. Commits
+// groups of concurrently ending transactions with and without batching and reports simulated
+// messaging time and round trips per transaction under the coordinator's latency model.
+// Usage: bench_2pc [transactions] [round trip us] [per-message us]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CommitCoordinator.h"
+#include "DataManager.h"
+#include "Transaction.h"
+using namespace std;
+
+namespace
+{
+    const int WRITES_PER_TXN = 3;
+
+    struct Result
+    {
+        double simulatedMicros; // Simulated messaging time per transaction
+        double roundTrips;      // Site exchanges per transaction
+        double wallMicros;      // Real time per transaction spent in the protocol
+    };
+
+    Result run(int transactions, int groupSize, bool batching, const MessageLatencyModel &model)
+    {
+        auto dataManager = make_shared<DataManager>();
+        CommitCoordinator coordinator(dataManager);
+        coordinator.setBatching(batching);
+        coordinator.setLatencyModel(model);
+
+        double wallMicros = 0;
+        for (int t = 0; t < transactions; t += groupSize)
+        {
+            vector<shared_ptr<Transaction>> group;
+            for (int g = 0; g < groupSize && t + g < transactions; ++g)
+            {
+                auto transaction = make_shared<Transaction>("T" + to_string(t + g), false);
+                for (int w = 0; w < WRITES_PER_TXN; ++w)
+                {
+                    // Mostly non-replicated variables, so transactions touch a few sites each
+                    transaction->addWriteVariable("x" + to_string(1 + (t + g + w * 7) % 20), t);
+                }
+                transaction->setCommitTime(chrono::system_clock::now().time_since_epoch().count());
+                group.push_back(transaction);
+            }
+            auto start = chrono::steady_clock::now();
+            coordinator.commit(group);
+            wallMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+        const CommitStats &stats = coordinator.getStats();
+        return {stats.simulatedMicros / transactions, (double)stats.roundTrips / transactions, wallMicros / transactions};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int transactions = argc > 1 ? atoi(argv[1]) : 4096;
+    MessageLatencyModel model = {argc > 2 ? atof(argv[2]) : 200.0, argc > 3 ? atof(argv[3]) : 2.0};
+    if (transactions <= 0 || model.roundTripMicros < 0 || model.perMessageMicros < 0)
+    {
+        fprintf(stderr, "usage: %s [transactions] [round trip us] [per-message us]\n", argv[0]);
+        return 1;
+    }
+
+    printf("transactions: %d, %d writes each, round trip %.1f us, %.1f us per message\n", transactions,
+           WRITES_PER_TXN, model.roundTripMicros, model.perMessageMicros);
+    printf("%6s %16s %16s %14s %14s %12s\n", "group", "unbatched us/txn", "batched us/txn", "unbatched rt", "batched rt",
+           "wall us/txn");
+    const int groupSizes[] = {1, 2, 4, 8, 16, 32, 64};
+    for (int groupSize : groupSizes)
+    {
+        Result plain = run(transactions, groupSize, false, model);
+        Result batched = run(transactions, groupSize, true, model);
+        printf("%6d %16.1f %16.1f %14.2f %14.2f %12.2f\n", groupSize, plain.simulatedMicros, batched.simulatedMicros,
+               plain.roundTrips, batched.roundTrips, batched.wallMicros);
+    }
+    return 0;
+}
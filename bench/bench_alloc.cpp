@@ -0,0 +1,207 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:26:10
+ */
+
+// Description: Measures heap allocations and time per transaction lifecycle. Compares the
+// previous layout (make_shared transaction with std containers, vector<Version> per replica)
+// against the pooled transaction with its arena and the per-site version slabs.
+// Usage: bench_alloc [transactions]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "SlabPool.h"
+#include "Transaction.h"
+#include "Variable.h"
+using namespace std;
+
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    ++allocationCount;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+    const int SITES = 10;
+    const int VARIABLES = 20;
+    const int READS_PER_TXN = 10;
+    const int WRITES_PER_TXN = 5;
+
+    // Transaction bookkeeping as it was laid out before pooling
+    struct LegacyTransaction
+    {
+        string name;
+        set<string> dependencySet;
+        set<string> readSet;
+        map<string, int> writeSet;
+        unordered_set<int> sitesWrittenTo;
+    };
+
+    struct Result
+    {
+        double txnAllocs;     // Heap allocations per transaction for bookkeeping
+        double versionAllocs; // Heap allocations per transaction for version records
+        double nanos;         // Wall time per transaction
+    };
+
+    vector<string> makeNames(char prefix, int count)
+    {
+        vector<string> names;
+        for (int i = 1; i <= count; ++i)
+        {
+            names.push_back(prefix + to_string(i));
+        }
+        return names;
+    }
+
+    Result runLegacy(int transactions)
+    {
+        vector<string> vars = makeNames('x', VARIABLES);
+        vector<vector<vector<Version>>> replicas(SITES, vector<vector<Version>>(VARIABLES, vector<Version>(1, Version{10, 0})));
+        vector<shared_ptr<LegacyTransaction>> live;
+        live.reserve(transactions);
+        size_t txnAllocs = 0;
+        size_t versionAllocs = 0;
+
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < transactions; ++t)
+        {
+            size_t before = allocationCount;
+            auto txn = make_shared<LegacyTransaction>();
+            txn->name = "T" + to_string(t % 1000);
+            for (int r = 0; r < READS_PER_TXN; ++r)
+            {
+                txn->readSet.insert(vars[(t + r * 3) % VARIABLES]);
+            }
+            for (int w = 0; w < WRITES_PER_TXN; ++w)
+            {
+                txn->writeSet[vars[(t + w * 7) % VARIABLES]] = t;
+                for (int s = 1; s <= SITES; ++s)
+                {
+                    txn->sitesWrittenTo.insert(s);
+                }
+            }
+            live.push_back(txn);
+            size_t middle = allocationCount;
+            for (const auto &write : txn->writeSet)
+            {
+                int index = stoi(write.first.substr(1)) - 1;
+                for (int s = 0; s < SITES; ++s)
+                {
+                    replicas[s][index].push_back(Version{write.second, (long)t + 1});
+                }
+            }
+            txnAllocs += middle - before;
+            versionAllocs += allocationCount - middle;
+        }
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return {(double)txnAllocs / transactions, (double)versionAllocs / transactions, (double)elapsed / transactions};
+    }
+
+    Result runPooled(int transactions)
+    {
+        vector<string> vars = makeNames('x', VARIABLES);
+        vector<unique_ptr<SlabPool>> slabs;
+        vector<vector<Variable>> replicas(SITES);
+        for (int s = 0; s < SITES; ++s)
+        {
+            slabs.emplace_back(new SlabPool(sizeof(VersionBlock)));
+            for (int v = 0; v < VARIABLES; ++v)
+            {
+                replicas[s].emplace_back(vars[v], 10, slabs.back().get());
+            }
+        }
+        SlabPool transactionPool(sizeof(Transaction) + 64);
+        vector<shared_ptr<Transaction>> live;
+        live.reserve(transactions);
+        vector<int> allSites;
+        for (int s = 1; s <= SITES; ++s)
+        {
+            allSites.push_back(s);
+        }
+        size_t txnAllocs = 0;
+        size_t versionAllocs = 0;
+
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < transactions; ++t)
+        {
+            size_t before = allocationCount;
+            auto txn = allocate_shared<Transaction>(PoolAllocator<Transaction>(transactionPool), "T" + to_string(t % 1000), false);
+            for (int r = 0; r < READS_PER_TXN; ++r)
+            {
+                txn->addReadVariable(vars[(t + r * 3) % VARIABLES]);
+            }
+            for (int w = 0; w < WRITES_PER_TXN; ++w)
+            {
+                txn->addWriteVariable(vars[(t + w * 7) % VARIABLES], t);
+                txn->addSitesWritten(allSites);
+            }
+            live.push_back(txn);
+            size_t middle = allocationCount;
+            for (const auto &write : txn->getWriteSet())
+            {
+                int index = stoi(write.first.substr(1)) - 1;
+                for (int s = 0; s < SITES; ++s)
+                {
+                    replicas[s][index].writeValue(write.second, (long)t + 1);
+                }
+            }
+            size_t after = allocationCount;
+            txn->retire();
+            txnAllocs += middle - before;
+            versionAllocs += after - middle;
+        }
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return {(double)txnAllocs / transactions, (double)versionAllocs / transactions, (double)elapsed / transactions};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int transactions = argc > 1 ? atoi(argv[1]) : 200000;
+    if (transactions <= 0)
+    {
+        fprintf(stderr, "usage: %s [transactions]\n", argv[0]);
+        return 1;
+    }
+
+    Result legacy = runLegacy(transactions);
+    Result pooled = runPooled(transactions);
+
+    printf("transactions: %d (%d reads, %d writes, %d replicas)\n", transactions, READS_PER_TXN, WRITES_PER_TXN, SITES);
+    printf("%-10s %16s %16s %12s\n", "layout", "txn allocs/txn", "ver allocs/txn", "ns/txn");
+    printf("%-10s %16.3f %16.3f %12.1f\n", "legacy", legacy.txnAllocs, legacy.versionAllocs, legacy.nanos);
+    printf("%-10s %16.3f %16.3f %12.1f\n", "pooled", pooled.txnAllocs, pooled.versionAllocs, pooled.nanos);
+    double legacyTotal = legacy.txnAllocs + legacy.versionAllocs;
+    double pooledTotal = pooled.txnAllocs + pooled.versionAllocs;
+    printf("allocation reduction: %.1fx, time ratio: %.2fx\n",
+           pooledTotal > 0 ? legacyTotal / pooledTotal : 0.0,
+           pooled.nanos > 0 ? legacy.nanos / pooled.nanos : 0.0);
+    return 0;
+}
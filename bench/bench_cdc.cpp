@@ -0,0 +1,179 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:50:10
+ */
+
+// Description: Measures what change capture costs a commit: commit latency with the feed off,
+// on, and on with a file sink. Then publishes from one thread while several subscriber threads
+// poll, one of them deliberately slow, to show publishing never waits for a reader and how the
+// slow reader lags or is dropped. Finally decodes the sink file back.
+// Usage: bench_cdc [commits]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChangeFeed.h"
+#include "DataManager.h"
+#include "Transaction.h"
+using namespace std;
+
+namespace
+{
+    const int WRITES_PER_COMMIT = 4;
+    const char *SINK_PATH = "bench_cdc.changes";
+
+    double commitMicros(int commits, bool capture, bool sink)
+    {
+        DataManager dataManager;
+        if (capture)
+        {
+            dataManager.setChangeCapture(true);
+            if (sink)
+            {
+                remove(SINK_PATH);
+                dataManager.getChangeFeed()->openSink(SINK_PATH);
+            }
+        }
+        double micros = 0;
+        for (int c = 0; c < commits; ++c)
+        {
+            auto transaction = make_shared<Transaction>("T" + to_string(c), false);
+            for (int w = 0; w < WRITES_PER_COMMIT; ++w)
+            {
+                transaction->addWriteVariable("x" + to_string(1 + (c + w) % 20), c);
+            }
+            transaction->setCommitTime(chrono::system_clock::now().time_since_epoch().count());
+
+            auto start = chrono::steady_clock::now();
+            dataManager.commitTransaction(transaction);
+            micros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+        return micros / commits;
+    }
+
+    struct Reader
+    {
+        uint64_t received;
+        uint64_t missed;
+        PollStatus last;
+    };
+
+    // Publishes records while the readers poll; the slow reader takes small batches and sleeps between them
+    void fanOut(int records, LagPolicy slowPolicy)
+    {
+        const int fastReaders = 3;
+        ChangeFeed feed(1024);
+        atomic<bool> done(false);
+        atomic<int> subscribed(0);
+        vector<Reader> readers(fastReaders + 1, Reader{0, 0, PollStatus::OK});
+        vector<thread> threads;
+        for (int r = 0; r <= fastReaders; ++r)
+        {
+            threads.emplace_back([&, r]()
+            {
+                bool slow = r == fastReaders;
+                // The slow reader handles a small batch at a time
+                size_t batchLimit = slow ? 64 : SIZE_MAX;
+                ChangeSubscriber subscriber(feed, slow ? slowPolicy : LagPolicy::REPORT);
+                ++subscribed;
+                vector<ChangeRecord> batch;
+                while (true)
+                {
+                    bool finished = done.load();
+                    batch.clear();
+                    PollStatus status = subscriber.poll(batch, batchLimit);
+                    readers[r].received += batch.size();
+                    if (status != PollStatus::OK)
+                    {
+                        readers[r].last = status;
+                    }
+                    if ((finished && batch.size() < batchLimit) || status == PollStatus::DROPPED)
+                    {
+                        break;
+                    }
+                    if (slow)
+                    {
+                        this_thread::sleep_for(chrono::microseconds(500));
+                    }
+                    else if (batch.empty())
+                    {
+                        this_thread::yield();
+                    }
+                }
+                readers[r].missed = subscriber.getMissed();
+            });
+        }
+
+        while (subscribed.load() <= fastReaders)
+        {
+            this_thread::yield();
+        }
+        // Time spent publishing only; between commits the publisher lets readers run
+        double nanos = 0;
+        for (int i = 0; i < records; i += WRITES_PER_COMMIT)
+        {
+            string name = "T" + to_string(i);
+            auto start = chrono::steady_clock::now();
+            for (int w = 0; w < WRITES_PER_COMMIT; ++w)
+            {
+                feed.publish(name, i, 1 + (i + w) % 20, i, 0x3ff);
+            }
+            nanos += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            this_thread::yield();
+        }
+        nanos /= records;
+        done = true;
+        for (thread &t : threads)
+        {
+            t.join();
+        }
+
+        printf("\n%d records, ring of %zu, slow reader %s: publish %.1f ns/record with %d readers polling\n",
+               records, feed.getCapacity(), slowPolicy == LagPolicy::DROP ? "dropped" : "reported", nanos,
+               fastReaders + 1);
+        printf("%-8s %12s %12s %10s\n", "reader", "received", "missed", "status");
+        const char *statusNames[] = {"ok", "lagged", "dropped"};
+        for (int r = 0; r <= fastReaders; ++r)
+        {
+            printf("%-8s %12llu %12llu %10s\n", r == fastReaders ? "slow" : "fast",
+                   (unsigned long long)readers[r].received, (unsigned long long)readers[r].missed,
+                   statusNames[static_cast<int>(readers[r].last)]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int commits = argc > 1 ? atoi(argv[1]) : 20000;
+    if (commits <= 0)
+    {
+        fprintf(stderr, "usage: %s [commits]\n", argv[0]);
+        return 1;
+    }
+
+    printf("commits: %d, %d writes each\n", commits, WRITES_PER_COMMIT);
+    printf("%-16s %14s\n", "capture", "us/commit");
+    printf("%-16s %14.2f\n", "off", commitMicros(commits, false, false));
+    printf("%-16s %14.2f\n", "ring", commitMicros(commits, true, false));
+    printf("%-16s %14.2f\n", "ring + file", commitMicros(commits, true, true));
+
+    auto start = chrono::steady_clock::now();
+    vector<ChangeRecord> records = ChangeFeed::readFile(SINK_PATH);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    FILE *file = fopen(SINK_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    fclose(file);
+    remove(SINK_PATH);
+    printf("\nsink: %zu records in %ld bytes (%.1f B/record), decoded in %.0f us\n", records.size(), bytes,
+           (double)bytes / records.size(), micros);
+
+    fanOut(commits * WRITES_PER_COMMIT, LagPolicy::REPORT);
+    fanOut(commits * WRITES_PER_COMMIT, LagPolicy::DROP);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:48:40
+ */
+
+// Description: Measures the memory of long version histories on a 10-site node, stored in
+// slab blocks, compressed per replica, and compressed with replicas sharing identical full
+// blocks, and the cost of a lookup at a random past timestamp in each form. Commits write the
+// ten replicated variables everywhere, with commit times a few microseconds apart and values
+// that either count up (small deltas) or are random.
+// Usage: bench_compression [commits] [lookups]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "DataManager.h"
+using namespace std;
+
+namespace
+{
+    const int NUM_VARIABLES = 20;
+
+    // Applies the same committed writes to every live replica, as a commit does
+    vector<long> fill(DataManager &dataManager, int commits, bool randomValues)
+    {
+        mt19937 random(9);
+        uniform_int_distribution<long> gap(1000, 50000);
+        uniform_int_distribution<int> anyValue(-1000000, 1000000);
+        vector<long> commitTimes;
+        long time = chrono::system_clock::now().time_since_epoch().count();
+        for (int commit = 0; commit < commits; ++commit)
+        {
+            time += gap(random);
+            commitTimes.push_back(time);
+            for (int v = 2; v <= NUM_VARIABLES; v += 2)
+            {
+                int value = randomValues ? anyValue(random) : v * 10 + commit;
+                for (int siteId = 1; siteId <= dataManager.getSiteCount(); ++siteId)
+                {
+                    dataManager.getSite(siteId)->writeVariable("x" + to_string(v), value, time);
+                }
+            }
+        }
+        return commitTimes;
+    }
+
+    double lookupNanos(DataManager &dataManager, const vector<long> &commitTimes, int lookups, long &checksum)
+    {
+        mt19937 random(3);
+        uniform_int_distribution<size_t> pick(0, commitTimes.size() - 1);
+        uniform_int_distribution<int> pickSite(1, dataManager.getSiteCount());
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < lookups; ++i)
+        {
+            auto site = dataManager.getSite(pickSite(random));
+            checksum += site->readVersion("x" + to_string(2 * (i % 10 + 1)), commitTimes[pick(random)]).value;
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int commits = argc > 1 ? atoi(argv[1]) : 20000;
+    int lookups = argc > 2 ? atoi(argv[2]) : 200000;
+    long checksum = 0;
+
+    printf("%d commits of 10 replicated variables at 10 sites\n", commits);
+    printf("%-8s %-20s %12s %10s %14s\n", "values", "store", "bytes", "B/version", "lookup ns/op");
+    for (bool randomValues : {false, true})
+    {
+        const char *label = randomValues ? "random" : "counter";
+        DataManager dataManager;
+        vector<long> commitTimes = fill(dataManager, commits, randomValues);
+
+        VersionStorageStats storage = dataManager.getVersionStorage();
+        double nanos = lookupNanos(dataManager, commitTimes, lookups, checksum);
+        printf("%-8s %-20s %12zu %10.2f %14.1f\n", label, "slab blocks", storage.bytes,
+               (double)storage.bytes / storage.versions, nanos);
+
+        dataManager.setCompression(true);
+        storage = dataManager.getVersionStorage();
+        nanos = lookupNanos(dataManager, commitTimes, lookups, checksum);
+        printf("%-8s %-20s %12zu %10.2f %14s\n", label, "compressed", storage.unsharedBytes,
+               (double)storage.unsharedBytes / storage.versions, "");
+        printf("%-8s %-20s %12zu %10.2f %14.1f\n", label, "compressed, shared", storage.bytes,
+               (double)storage.bytes / storage.versions, nanos);
+    }
+    printf("\n(checksum %ld)\n", checksum);
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:52:30
+ */
+
+// Description: Measures input ingestion. Writes a trace of short transactions to a file, then
+// parses it with getline on one thread and with TraceReader at several thread counts, checking
+// that every reader yields the same commands. Finally runs a shorter trace both ways, once
+// parsing each line before executing it and once with parsing overlapped with execution, to
+// show how much of a run is left to execution. Execution keeps every finished transaction for
+// validation, so its cost per command grows with the trace; hence the shorter trace.
+// Usage: bench_ingest [transactions parsed] [transactions executed]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include "CommandParser.h"
+#include "DataManager.h"
+#include "TraceReader.h"
+#include "TransactionManager.h"
+using namespace std;
+
+namespace
+{
+    const char *TRACE_PATH = "bench_ingest.trace";
+    const char *RUN_PATH = "bench_ingest_run.trace";
+
+    // Swallows everything written to it
+    class NullBuffer : public streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    struct Parsed
+    {
+        size_t commands;  // Commands read
+        size_t checksum;  // Mix of command types and argument lengths, to compare readers
+        double micros;    // Time to read the whole file
+    };
+
+    void writeTrace(const char *path, int transactions)
+    {
+        ofstream out(path);
+        mt19937 random(11);
+        uniform_int_distribution<int> variable(1, 20);
+        out << "// Generated by bench_ingest\n";
+        for (int t = 1; t <= transactions; ++t)
+        {
+            string name = "T" + to_string(t);
+            out << "begin(" << name << ")\n";
+            out << "R(" << name << ",x" << variable(random) << ")\n";
+            if (t % 4 == 0)
+            {
+                out << "R(" << name << ", x1..x6)\n";
+            }
+            out << "W(" << name << ",x" << variable(random) << "," << t << ")\n";
+            if (t % 8 == 0)
+            {
+                out << "W(" << name << ", x2=" << t << ", x4..x6=" << t + 1 << ")\n";
+            }
+            out << "end(" << name << ")\n";
+            if (t % 1000 == 0)
+            {
+                out << "\n// checkpoint\n";
+            }
+        }
+    }
+
+    void mix(Parsed &parsed, const Command &command)
+    {
+        ++parsed.commands;
+        parsed.checksum = parsed.checksum * 31 + static_cast<size_t>(command.type) + command.name.size() +
+                          command.names.size() + command.writes.size() + static_cast<size_t>(command.number);
+    }
+
+    Parsed parseSequential()
+    {
+        Parsed parsed = {0, 0, 0.0};
+        auto start = chrono::steady_clock::now();
+        ifstream in(TRACE_PATH);
+        string line;
+        while (getline(in, line))
+        {
+            if (!CommandParser::isSkipped(line.data(), line.size()))
+            {
+                mix(parsed, CommandParser::parse(line));
+            }
+        }
+        parsed.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        return parsed;
+    }
+
+    Parsed parseParallel(int threads, size_t chunkBytes)
+    {
+        Parsed parsed = {0, 0, 0.0};
+        auto start = chrono::steady_clock::now();
+        TraceReader reader(TRACE_PATH, threads, chunkBytes);
+        Command command;
+        while (reader.next(command))
+        {
+            mix(parsed, command);
+        }
+        parsed.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        return parsed;
+    }
+
+    // Runs the trace with every line parsed just before it executes
+    double runSequential(size_t &commands)
+    {
+        auto start = chrono::steady_clock::now();
+        auto dataManager = make_shared<DataManager>();
+        TransactionManager transactionManager(dataManager);
+        ifstream in(RUN_PATH);
+        string line;
+        while (getline(in, line))
+        {
+            if (!CommandParser::isSkipped(line.data(), line.size()))
+            {
+                transactionManager.processCommand(line);
+                ++commands;
+            }
+        }
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Runs the trace with parser threads working ahead of execution
+    double runPipelined(TraceReaderStats &stats)
+    {
+        auto start = chrono::steady_clock::now();
+        auto dataManager = make_shared<DataManager>();
+        TransactionManager transactionManager(dataManager);
+        TraceReader reader(RUN_PATH);
+        Command command;
+        while (reader.next(command))
+        {
+            transactionManager.processCommand(command);
+        }
+        stats = reader.getStats();
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int transactions = argc > 1 ? atoi(argv[1]) : 200000;
+    int executed = argc > 2 ? atoi(argv[2]) : 3000;
+    if (transactions <= 0 || executed <= 0)
+    {
+        fprintf(stderr, "usage: %s [transactions parsed] [transactions executed]\n", argv[0]);
+        return 1;
+    }
+    writeTrace(TRACE_PATH, transactions);
+    writeTrace(RUN_PATH, executed);
+
+    Parsed baseline = parseSequential();
+    printf("trace: %d transactions, %zu commands\n\n", transactions, baseline.commands);
+    printf("%-24s %10s %14s %8s\n", "parse only", "ms", "commands/s", "same");
+    printf("%-24s %10.1f %14.0f %8s\n", "getline, 1 thread", baseline.micros / 1000,
+           baseline.commands / baseline.micros * 1e6, "-");
+    const int threadCounts[] = {1, 2, 4, 8};
+    for (int threads : threadCounts)
+    {
+        Parsed parsed = parseParallel(threads, 1 << 20);
+        string label = "mmap, " + to_string(threads) + " thread" + (threads > 1 ? "s" : "");
+        printf("%-24s %10.1f %14.0f %8s\n", label.c_str(), parsed.micros / 1000, parsed.commands / parsed.micros * 1e6,
+               parsed.commands == baseline.commands && parsed.checksum == baseline.checksum ? "yes" : "NO");
+    }
+    // Tiny chunks put many boundaries mid-file; the commands must not change
+    Parsed tiny = parseParallel(4, 64);
+    printf("%-24s %10.1f %14.0f %8s\n", "mmap, 4 threads, 64 B", tiny.micros / 1000, tiny.commands / tiny.micros * 1e6,
+           tiny.commands == baseline.commands && tiny.checksum == baseline.checksum ? "yes" : "NO");
+
+    // Every command prints; keep only the table
+    NullBuffer discarded;
+    streambuf *console = cout.rdbuf(&discarded);
+    size_t commands = 0;
+    double sequential = runSequential(commands);
+    TraceReaderStats stats;
+    double pipelined = runPipelined(stats);
+    cout.rdbuf(console);
+
+    printf("\n%-24s %10s %14s   (%d transactions, %zu commands)\n", "parse and execute", "ms", "commands/s", executed,
+           commands);
+    printf("%-24s %10.1f %14.0f\n", "parse, then execute", sequential / 1000, commands / sequential * 1e6);
+    printf("%-24s %10.1f %14.0f\n", "overlapped", pipelined / 1000, commands / pipelined * 1e6);
+    printf("(%d parser threads, %zu chunks, %.1f ms parsing off the executing thread, executor stalled %.1f ms)\n",
+           stats.parserThreads, stats.chunks, stats.parseMicros / 1000, stats.stallMicros / 1000);
+    remove(TRACE_PATH);
+    remove(RUN_PATH);
+    return 0;
+}
@@ -0,0 +1,311 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:53:30
+ */
+
+// Description: Drives the database through the typed API of librepcrec. Groups of overlapping
+// transactions read and write a few hot variables while a site fails and recovers now and then;
+// each result is counted by status and abort reason straight from the API, with no output to
+// parse. The same schedule is then run as command text, its output captured and searched for
+// commits the way a host without the library would have to, to show what formatting and parsing
+// cost next to the typed calls and to check both runs commit the same transactions. Execution slows as finished transactions
+// accumulate, so each round starts a fresh system. Before timing anything, a few fixed scenarios
+// check the results the API reports; the program fails if one is wrong.
+// Usage: bench_library [rounds] [groups per round]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Database.h"
+using namespace std;
+
+namespace
+{
+    const int GROUP_SIZE = 4;
+
+    // One operation of the schedule
+    struct Step
+    {
+        enum Kind
+        {
+            BEGIN,
+            READ,
+            WRITE,
+            COMMIT,
+            FAIL,
+            RECOVER
+        } kind;
+        string transaction; // Transaction it runs for, empty for site steps
+        int number;         // Variable, or site for site steps
+        int value;          // Value written
+    };
+
+    // Counts of the results seen
+    struct Tally
+    {
+        size_t reads;                    // Reads that returned a value
+        size_t waits;                    // Operations left waiting
+        size_t commits;                  // Transactions committed
+        map<AbortReason, size_t> aborts; // Aborts by reason, at the operation that reported them
+    };
+
+    const char *reasonName(AbortReason reason)
+    {
+        switch (reason)
+        {
+        case AbortReason::INVALID_OPERATION: return "invalid operation";
+        case AbortReason::NO_VALID_VERSION: return "no valid version";
+        case AbortReason::SITE_FAILURE: return "site failure";
+        case AbortReason::UNAVAILABLE: return "unavailable";
+        case AbortReason::WRITE_CONFLICT: return "write conflict";
+        case AbortReason::READ_INVALIDATED: return "read invalidated";
+        case AbortReason::DEPENDENCY_CYCLE: return "dependency cycle";
+        case AbortReason::VOTE_REJECTED: return "vote rejected";
+        case AbortReason::DEADLOCK: return "deadlock";
+        default: return "none";
+        }
+    }
+
+    // Overlapping groups: all begin, each reads one hot variable and writes another, all commit
+    vector<Step> makeSchedule(int groups, unsigned seed)
+    {
+        mt19937 random(seed);
+        uniform_int_distribution<int> hot(1, 6);
+        vector<Step> steps;
+        int next = 1;
+        for (int g = 0; g < groups; ++g)
+        {
+            vector<string> names;
+            for (int i = 0; i < GROUP_SIZE; ++i)
+            {
+                names.push_back("T" + to_string(next++));
+                steps.push_back(Step{Step::BEGIN, names.back(), 0, 0});
+            }
+            for (const auto &name : names)
+            {
+                steps.push_back(Step{Step::READ, name, hot(random), 0});
+                steps.push_back(Step{Step::WRITE, name, hot(random), next});
+            }
+            // A site fails between the writes and the commits now and then
+            bool failing = g % 8 == 7;
+            int site = 1 + g % 10;
+            if (failing)
+            {
+                steps.push_back(Step{Step::FAIL, "", site, 0});
+            }
+            for (const auto &name : names)
+            {
+                steps.push_back(Step{Step::COMMIT, name, 0, 0});
+            }
+            if (failing)
+            {
+                steps.push_back(Step{Step::RECOVER, "", site, 0});
+            }
+        }
+        return steps;
+    }
+
+    void count(Tally &tally, OperationStatus status, AbortReason reason)
+    {
+        if (status == OperationStatus::WAITING)
+        {
+            ++tally.waits;
+        }
+        else if (status == OperationStatus::ABORTED)
+        {
+            ++tally.aborts[reason];
+        }
+    }
+
+    bool check(const char *scenario, bool passed)
+    {
+        printf("%-52s %s\n", scenario, passed ? "yes" : "NO");
+        return passed;
+    }
+
+    // Fixed scenarios whose results are known; returns false if any result is not what it should be
+    bool checkResults()
+    {
+        bool passed = true;
+        {
+            // x2 has valid versions, but every copy is down
+            Database database;
+            database.beginReadOnly("T1");
+            for (int site = 1; site <= 10; ++site)
+            {
+                database.failSite(site);
+            }
+            ReadResult parked = database.read("T1", 2);
+            passed &= check("parked read returns WAITING", parked.status == OperationStatus::WAITING &&
+                                                                parked.reason == AbortReason::NONE);
+            database.recoverSite(1);
+            CommitResult commit = database.commit("T1");
+            passed &= check("read-only commit after the read is answered", commit.committed);
+        }
+        {
+            // T1 wrote x2 at site 1 before it failed
+            Database database;
+            database.begin("T1");
+            database.write("T1", 2, 5);
+            database.failSite(1);
+            CommitResult commit = database.commit("T1");
+            passed &= check("commit after a written site failed: SITE_FAILURE",
+                            !commit.committed && commit.status == OperationStatus::ABORTED &&
+                                commit.reason == AbortReason::SITE_FAILURE);
+        }
+        {
+            // First committer wins
+            Database database;
+            database.begin("T1");
+            database.begin("T2");
+            database.write("T1", 4, 1);
+            database.write("T2", 4, 2);
+            bool first = database.commit("T1").committed;
+            CommitResult second = database.commit("T2");
+            passed &= check("second writer of x4: WRITE_CONFLICT",
+                            first && !second.committed && second.reason == AbortReason::WRITE_CONFLICT);
+            passed &= check("commit of a finished transaction: REJECTED",
+                            database.commit("T2").status == OperationStatus::REJECTED);
+        }
+        {
+            // Parser messages go where the host sends messages, not to the console
+            Database database;
+            ostringstream output;
+            database.setOutput(&output);
+            database.execute("R(T1, x1..x300)");
+            database.execute("nonsense");
+            passed &= check("parser messages reach the output stream",
+                            output.str() == "Invalid command: R(T1, x1..x300)\nUnknown command: nonsense\n");
+        }
+        return passed;
+    }
+
+    // Returns the time to run the schedule through the typed API, in microseconds
+    double runTyped(const vector<Step> &steps, Tally &tally)
+    {
+        Database database;
+        auto start = chrono::steady_clock::now();
+        for (const auto &step : steps)
+        {
+            switch (step.kind)
+            {
+            case Step::BEGIN:
+                database.begin(step.transaction);
+                break;
+            case Step::READ:
+            {
+                ReadResult result = database.read(step.transaction, step.number);
+                tally.reads += result.status == OperationStatus::OK;
+                count(tally, result.status, result.reason);
+                break;
+            }
+            case Step::WRITE:
+            {
+                OperationResult result = database.write(step.transaction, step.number, step.value);
+                count(tally, result.status, result.reason);
+                break;
+            }
+            case Step::COMMIT:
+            {
+                CommitResult result = database.commit(step.transaction);
+                tally.commits += result.committed;
+                count(tally, result.status, result.reason);
+                break;
+            }
+            case Step::FAIL:
+                database.failSite(step.number);
+                break;
+            case Step::RECOVER:
+                database.recoverSite(step.number);
+                break;
+            }
+        }
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Returns the time to run the schedule as command text, in microseconds
+    double runText(const vector<Step> &steps, size_t &commits)
+    {
+        Database database;
+        ostringstream output;
+        database.setOutput(&output);
+        vector<string> lines;
+        for (const auto &step : steps)
+        {
+            const string &t = step.transaction;
+            string n = to_string(step.number);
+            switch (step.kind)
+            {
+            case Step::BEGIN: lines.push_back("begin(" + t + ")"); break;
+            case Step::READ: lines.push_back("R(" + t + ", x" + n + ")"); break;
+            case Step::WRITE: lines.push_back("W(" + t + ", x" + n + ", " + to_string(step.value) + ")"); break;
+            case Step::COMMIT: lines.push_back("end(" + t + ")"); break;
+            case Step::FAIL: lines.push_back("fail(" + n + ")"); break;
+            case Step::RECOVER: lines.push_back("recover(" + n + ")"); break;
+            }
+        }
+        auto start = chrono::steady_clock::now();
+        for (const auto &line : lines)
+        {
+            database.execute(line);
+        }
+        // Read-write commits print "T committed." and read-only ones "T committed (Read-Only)."
+        const string text = output.str();
+        for (size_t at = text.find(" committed"); at != string::npos; at = text.find(" committed", at + 1))
+        {
+            ++commits;
+        }
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    int groups = argc > 2 ? atoi(argv[2]) : 50;
+    if (rounds <= 0 || groups <= 0)
+    {
+        fprintf(stderr, "usage: %s [rounds] [groups per round]\n", argv[0]);
+        return 1;
+    }
+
+    if (!checkResults())
+    {
+        return 1;
+    }
+    printf("\n");
+
+    Tally tally = {0, 0, 0, map<AbortReason, size_t>()};
+    double typed = 0;
+    double text = 0;
+    size_t textCommits = 0;
+    size_t operations = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        vector<Step> steps = makeSchedule(groups, 17 + round);
+        operations += steps.size();
+        typed += runTyped(steps, tally);
+        text += runText(steps, textCommits);
+    }
+
+    size_t transactions = (size_t)rounds * groups * GROUP_SIZE;
+    printf("%d rounds of %d groups of %d transactions, %zu operations\n\n", rounds, groups, GROUP_SIZE, operations);
+    printf("%-26s %10zu   (command text: %zu, %s)\n", "committed", tally.commits, textCommits,
+           textCommits == tally.commits ? "same" : "DIFFERENT");
+    for (const auto &abort : tally.aborts)
+    {
+        string label = string("aborted: ") + reasonName(abort.first);
+        printf("%-26s %10zu\n", label.c_str(), abort.second);
+    }
+    printf("%-26s %10zu\n", "reads returned", tally.reads);
+    printf("%-26s %10zu\n", "operations waiting", tally.waits);
+    printf("\n%-26s %10s %10s\n", "interface", "us/txn", "us/op");
+    printf("%-26s %10.2f %10.3f\n", "typed API", typed / transactions, typed / operations);
+    printf("%-26s %10.2f %10.3f\n", "command text", text / transactions, text / operations);
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:51:30
+ */
+
+// Description: Shows how adaptive replication spreads load over the sites. The workload reads a
+// few odd variables far more than the rest, so under the fixed placement their single home sites
+// serve most reads, and writes a few even variables far more than the rest, so every commit pays
+// for ten copies. The same workload runs with the fixed placement and with adaptive replication,
+// which rebalances during a warm-up; then a measured window counts the reads served and the
+// writes applied by every site.
+// Usage: bench_placement [operations]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "DataManager.h"
+#include "Transaction.h"
+using namespace std;
+
+namespace
+{
+    const int NUM_VARIABLES = 20;
+    const int READ_PERCENT = 80;
+    const int HOT_PERCENT = 70; // Share of reads (writes) that go to the hot read (write) variables
+    const int HOT_READ_VARIABLES[] = {1, 3, 5};
+    const int HOT_WRITE_VARIABLES[] = {2, 4};
+
+    struct Window
+    {
+        vector<AccessCounts> sites; // Per site, by ID
+        size_t writes;              // Committed writes
+        double micros;              // Time for the window
+    };
+
+    // Runs one operation of the workload
+    void step(DataManager &dataManager, mt19937 &random, long &clock, int &commits)
+    {
+        uniform_int_distribution<int> percent(0, 99);
+        uniform_int_distribution<int> anyVariable(1, NUM_VARIABLES);
+        bool read = percent(random) < READ_PERCENT;
+        bool hot = percent(random) < HOT_PERCENT;
+        int variable = anyVariable(random);
+        if (hot && read)
+        {
+            variable = HOT_READ_VARIABLES[random() % 3];
+        }
+        else if (hot)
+        {
+            variable = HOT_WRITE_VARIABLES[random() % 2];
+        }
+        string name = "x" + to_string(variable);
+        if (read)
+        {
+            dataManager.read("B", name, clock);
+            return;
+        }
+        auto transaction = make_shared<Transaction>("T" + to_string(commits++), false);
+        transaction->addWriteVariable(name, commits);
+        transaction->setCommitTime(++clock);
+        dataManager.commitTransaction(transaction);
+    }
+
+    Window run(int operations, bool adaptive)
+    {
+        DataManager dataManager;
+        dataManager.setAdaptivePlacement(adaptive);
+        // A window of 1000 operations averages 50 accesses per variable; hot means well above that
+        dataManager.setPlacementPolicy(PlacementPolicy{100, 4, 1});
+        mt19937 random(5);
+        long clock = chrono::system_clock::now().time_since_epoch().count();
+        int commits = 0;
+
+        // Warm-up: adaptive replication rebalances every 1000 operations
+        for (int i = 1; i <= operations; ++i)
+        {
+            step(dataManager, random, clock, commits);
+            if (adaptive && i % 1000 == 0)
+            {
+                dataManager.rebalance();
+            }
+        }
+
+        Window window;
+        vector<AccessCounts> before;
+        for (int siteId = 0; siteId <= dataManager.getSiteCount(); ++siteId)
+        {
+            before.push_back(siteId ? dataManager.getHeatmap().getSite(siteId) : AccessCounts{0, 0});
+        }
+        int commitsBefore = commits;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < operations; ++i)
+        {
+            step(dataManager, random, clock, commits);
+        }
+        window.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        window.writes = commits - commitsBefore;
+        window.sites.push_back(AccessCounts{0, 0});
+        for (int siteId = 1; siteId <= dataManager.getSiteCount(); ++siteId)
+        {
+            const AccessCounts &after = dataManager.getHeatmap().getSite(siteId);
+            window.sites.push_back(AccessCounts{after.reads - before[siteId].reads, after.writes - before[siteId].writes});
+        }
+
+        if (adaptive)
+        {
+            printf("adaptive placement after warm-up:");
+            for (int v = 1; v <= NUM_VARIABLES; ++v)
+            {
+                printf(" x%d:%d", v, dataManager.getReplicaCount("x" + to_string(v)));
+            }
+            const PlacementStats &stats = dataManager.getPlacementStats();
+            printf("\n(%zu replicas added, %zu dropped, %zu versions copied)\n\n", stats.replicasAdded,
+                   stats.replicasDropped, stats.versionsCopied);
+        }
+        return window;
+    }
+
+    void report(const char *label, const Window &window, int operations)
+    {
+        uint64_t total = 0;
+        uint64_t busiest = 0;
+        uint64_t siteWrites = 0;
+        for (size_t siteId = 1; siteId < window.sites.size(); ++siteId)
+        {
+            uint64_t load = window.sites[siteId].reads + window.sites[siteId].writes;
+            total += load;
+            busiest = load > busiest ? load : busiest;
+            siteWrites += window.sites[siteId].writes;
+        }
+        double mean = (double)total / (window.sites.size() - 1);
+        printf("%-9s %10.2f %12.2f %10.2f %10.2f\n", label, busiest / mean, (double)siteWrites / window.writes,
+               (double)total / 1000, window.micros / operations);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int operations = argc > 1 ? atoi(argv[1]) : 20000;
+    if (operations <= 0)
+    {
+        fprintf(stderr, "usage: %s [operations]\n", argv[0]);
+        return 1;
+    }
+
+    Window fixed = run(operations, false);
+    Window adaptive = run(operations, true);
+
+    printf("load per site over %d operations (reads served / copies written)\n", operations);
+    printf("%-6s %14s %14s\n", "site", "fixed", "adaptive");
+    for (size_t siteId = 1; siteId < fixed.sites.size(); ++siteId)
+    {
+        printf("%-6zu %6llu / %-5llu %6llu / %-5llu\n", siteId, (unsigned long long)fixed.sites[siteId].reads,
+               (unsigned long long)fixed.sites[siteId].writes, (unsigned long long)adaptive.sites[siteId].reads,
+               (unsigned long long)adaptive.sites[siteId].writes);
+    }
+    printf("\n%-9s %10s %12s %10s %10s\n", "placement", "max/mean", "copies/write", "k accesses", "us/op");
+    report("fixed", fixed, operations);
+    report("adaptive", adaptive, operations);
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:53:00
+ */
+
+// Description: Measures what the command front end costs a transaction. The same transfers run
+// three ways: as five command lines each, as one CALL of a stored procedure each, and as direct
+// TransactionManager calls with no front end at all. The direct run is the cost of executing the
+// operations, so subtracting it leaves what parsing and dispatch add per transaction. Execution
+// slows as finished transactions accumulate, so each round starts a fresh system and the modes
+// take turns round by round.
+// Usage: bench_procedures [rounds] [transactions per round]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataManager.h"
+#include "TransactionManager.h"
+using namespace std;
+
+namespace
+{
+    // Swallows everything written to it
+    class NullBuffer : public streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    struct Transfer
+    {
+        string name; // Transaction
+        string from; // Variable debited
+        string to;   // Variable credited
+        int amount;  // Amount moved
+    };
+
+    enum class Mode
+    {
+        LINES,
+        CALL,
+        DIRECT
+    };
+
+    vector<Transfer> makeTransfers(int transactions)
+    {
+        vector<Transfer> transfers;
+        for (int t = 1; t <= transactions; ++t)
+        {
+            // Even variables, so every transfer touches replicated data
+            int from = 2 * (1 + t % 10);
+            int to = 2 * (1 + (t * 7 + 3) % 10);
+            transfers.push_back(Transfer{"T" + to_string(t), "x" + to_string(from), "x" + to_string(to), 1 + t % 9});
+        }
+        return transfers;
+    }
+
+    // Returns the time to run the transfers on a fresh system, in microseconds
+    double run(const vector<Transfer> &transfers, Mode mode)
+    {
+        auto dataManager = make_shared<DataManager>();
+        TransactionManager transactionManager(dataManager);
+        vector<string> definition = {"DEFINE transfer(T, from, to, amount)", "begin(T)", "R(T, from)",
+                                     "INC(T, from, -amount)", "INC(T, to, amount)", "end(T)", "END"};
+        for (const auto &line : definition)
+        {
+            transactionManager.processCommand(line);
+        }
+
+        // Command text is built up front so only the front end and execution are timed
+        vector<vector<string>> lines;
+        for (const auto &transfer : transfers)
+        {
+            const string &t = transfer.name;
+            string amount = to_string(transfer.amount);
+            if (mode == Mode::CALL)
+            {
+                lines.push_back({"CALL transfer(" + t + ", " + transfer.from + ", " + transfer.to + ", " + amount + ")"});
+            }
+            else
+            {
+                lines.push_back({"begin(" + t + ")", "R(" + t + ", " + transfer.from + ")",
+                                 "INC(" + t + ", " + transfer.from + ", -" + amount + ")",
+                                 "INC(" + t + ", " + transfer.to + ", " + amount + ")", "end(" + t + ")"});
+            }
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < transfers.size(); ++i)
+        {
+            const Transfer &transfer = transfers[i];
+            if (mode == Mode::DIRECT)
+            {
+                transactionManager.beginTransaction(transfer.name, false);
+                transactionManager.read(transfer.name, transfer.from);
+                transactionManager.increment(transfer.name, transfer.from, -transfer.amount);
+                transactionManager.increment(transfer.name, transfer.to, transfer.amount);
+                transactionManager.endTransaction(transfer.name);
+                continue;
+            }
+            for (const auto &line : lines[i])
+            {
+                transactionManager.processCommand(line);
+            }
+        }
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 50;
+    int transactions = argc > 2 ? atoi(argv[2]) : 100;
+    if (rounds <= 0 || transactions <= 0)
+    {
+        fprintf(stderr, "usage: %s [rounds] [transactions per round]\n", argv[0]);
+        return 1;
+    }
+    vector<Transfer> transfers = makeTransfers(transactions);
+
+    // Every operation prints; keep only the table
+    NullBuffer discarded;
+    streambuf *console = cout.rdbuf(&discarded);
+    double direct = 0;
+    double lines = 0;
+    double call = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        direct += run(transfers, Mode::DIRECT);
+        lines += run(transfers, Mode::LINES);
+        call += run(transfers, Mode::CALL);
+    }
+    cout.rdbuf(console);
+    double total = (double)rounds * transactions;
+    direct /= total;
+    lines /= total;
+    call /= total;
+
+    printf("%d rounds of %d transfers, 5 operations each\n", rounds, transactions);
+    printf("%-22s %12s %16s\n", "front end", "us/txn", "front end us/txn");
+    printf("%-22s %12.2f %16s\n", "none (direct calls)", direct, "-");
+    printf("%-22s %12.2f %16.2f\n", "5 command lines", lines, lines - direct);
+    printf("%-22s %12.2f %16.2f\n", "1 CALL", call, call - direct);
+    return 0;
+}
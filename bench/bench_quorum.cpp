@@ -0,0 +1,149 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:31:05
+ */
+
+// Description: Measures read and commit latency and availability of one replicated variable
+// under different read/write quorums while sites fail and recover at random. Write-all-available
+// (no quorum) is the baseline.
+// Usage: bench_quorum [operations] [failure percent]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include "DataManager.h"
+#include "Transaction.h"
+using namespace std;
+
+namespace
+{
+    const int SITES = 10;
+    const string VARIABLE = "x2";
+
+    struct Setting
+    {
+        int readQuorum;  // 0 means write-all-available
+        int writeQuorum;
+    };
+
+    struct Result
+    {
+        double readMicros;   // Mean latency of a successful read
+        double commitMicros; // Mean latency of a successful commit
+        double readAvailability;
+        double writeAvailability;
+    };
+
+    Result run(const Setting &setting, int operations, int failurePercent)
+    {
+        DataManager dataManager(SITES);
+        // Recovered sites become readable right away, so every setting sees the same live replicas
+        dataManager.setCatchUpEnabled(true);
+        if (setting.readQuorum > 0)
+        {
+            string error;
+            dataManager.setQuorum(VARIABLE, setting.readQuorum, setting.writeQuorum, error);
+        }
+        mt19937 random(42);
+        uniform_int_distribution<int> percent(0, 99);
+        uniform_int_distribution<int> pickSite(1, SITES);
+
+        double readMicros = 0, commitMicros = 0;
+        int reads = 0, readsServed = 0, writes = 0, writesCommitted = 0;
+        for (int op = 0; op < operations; ++op)
+        {
+            if (percent(random) < failurePercent)
+            {
+                int siteId = pickSite(random);
+                if (dataManager.getSite(siteId)->getStatus() == SiteStatus::DOWN)
+                {
+                    dataManager.recoverSite(siteId);
+                }
+                else
+                {
+                    dataManager.failSite(siteId);
+                }
+            }
+            long now = chrono::system_clock::now().time_since_epoch().count();
+            if (op % 2 == 0)
+            {
+                ++reads;
+                auto start = chrono::steady_clock::now();
+                try
+                {
+                    dataManager.read("R" + to_string(op), VARIABLE, now);
+                    readMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+                    ++readsServed;
+                }
+                catch (const runtime_error &)
+                {
+                }
+                continue;
+            }
+            ++writes;
+            auto transaction = make_shared<Transaction>("W" + to_string(op), false);
+            transaction->addWriteVariable(VARIABLE, op);
+            transaction->setCommitTime(now);
+            auto start = chrono::steady_clock::now();
+            bool available = setting.readQuorum > 0 ? dataManager.canWriteQuorum(VARIABLE) : false;
+            if (setting.readQuorum == 0)
+            { // Write-all-available commits as long as one replica is up
+                for (int s = 1; s <= SITES && !available; ++s)
+                {
+                    available = dataManager.getSite(s)->getStatus() != SiteStatus::DOWN;
+                }
+            }
+            if (available)
+            {
+                dataManager.commitTransaction(transaction);
+                commitMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+                ++writesCommitted;
+            }
+        }
+        return {readsServed ? readMicros / readsServed : 0.0, writesCommitted ? commitMicros / writesCommitted : 0.0,
+                reads ? (double)readsServed / reads : 0.0, writes ? (double)writesCommitted / writes : 0.0};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int operations = argc > 1 ? atoi(argv[1]) : 20000;
+    int failurePercent = argc > 2 ? atoi(argv[2]) : 5;
+    if (operations <= 0 || failurePercent < 0 || failurePercent > 100)
+    {
+        fprintf(stderr, "usage: %s [operations] [failure percent]\n", argv[0]);
+        return 1;
+    }
+
+    // Failures, recoveries and waiting reads print to cout; keep the table readable
+    ostringstream discarded;
+    streambuf *console = cout.rdbuf(discarded.rdbuf());
+
+    printf("operations: %d, %d replicas, %d%% chance of a failure/recovery per operation\n",
+           operations, SITES, failurePercent);
+    printf("%-10s %12s %14s %12s %12s\n", "quorum", "read us", "commit us", "read avail", "write avail");
+    const Setting settings[] = {{0, 0}, {1, 10}, {3, 8}, {6, 5}, {8, 3}, {10, 1}};
+    for (const Setting &setting : settings)
+    {
+        Result result = run(setting, operations, failurePercent);
+        discarded.str("");
+        char label[16];
+        if (setting.readQuorum == 0)
+        {
+            snprintf(label, sizeof(label), "all-avail");
+        }
+        else
+        {
+            snprintf(label, sizeof(label), "R%d/W%d", setting.readQuorum, setting.writeQuorum);
+        }
+        printf("%-10s %12.2f %14.2f %11.1f%% %11.1f%%\n", label, result.readMicros, result.commitMicros,
+               100 * result.readAvailability, 100 * result.writeAvailability);
+    }
+    cout.rdbuf(console);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:54:00
+ */
+
+// Description: Measures concurrent reads of one site while a writer keeps committing new versions
+// to the same variables. Reads of the latest version and of a snapshot a few versions back are
+// served from the published rings without the site lock; reads far in the past still take the
+// lock, as every read did before, and serve as the baseline. Throughput should grow with reader
+// threads for the first two as long as there are cores to run them.
+// Usage: bench_reads [milliseconds per run]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Site.h"
+using namespace std;
+
+namespace
+{
+    enum class Mode
+    {
+        LATEST,   // Reads at the current time
+        SNAPSHOT, // Reads three commits back, still inside the published ring
+        HISTORY   // Reads the first committed version, deep in the history
+    };
+
+    // Even variables, all stored at every site
+    vector<string> evenVariables()
+    {
+        vector<string> names;
+        for (int i = 2; i <= 20; i += 2)
+        {
+            names.push_back("x" + to_string(i));
+        }
+        return names;
+    }
+
+    // Returns reads per second summed over all reader threads
+    double run(Mode mode, int readers, int millis)
+    {
+        Site site(2);
+        vector<string> names = evenVariables();
+        atomic<long> clock(0);
+        atomic<bool> stop(false);
+
+        // Commit times come from a counter, so readers can name a version a few commits back
+        auto write = [&]() {
+            int value = 0;
+            while (!stop.load(memory_order_relaxed))
+            {
+                long commitTime = clock.load(memory_order_relaxed) + 1;
+                for (const auto &name : names)
+                {
+                    site.writeVariable(name, ++value, commitTime);
+                }
+                clock.store(commitTime, memory_order_relaxed);
+                this_thread::sleep_for(chrono::microseconds(50));
+            }
+        };
+        // Give the history some depth before timing
+        for (int i = 0; i < 64; ++i)
+        {
+            long commitTime = clock.load() + 1;
+            for (const auto &name : names)
+            {
+                site.writeVariable(name, i, commitTime);
+            }
+            clock.store(commitTime);
+        }
+
+        vector<size_t> counts(readers, 0);
+        auto read = [&](int reader) {
+            size_t reads = 0;
+            long sum = 0;
+            size_t next = reader;
+            while (!stop.load(memory_order_relaxed))
+            {
+                long timestamp = mode == Mode::LATEST     ? numeric_limits<long>::max()
+                                 : mode == Mode::SNAPSHOT ? clock.load(memory_order_relaxed) - 3
+                                                          : 1;
+                for (int i = 0; i < 64; ++i)
+                {
+                    sum += site.readVariable(names[next++ % names.size()], timestamp);
+                }
+                reads += 64;
+            }
+            // Keeps the reads from being optimized away
+            counts[reader] = reads + (sum == 42 ? 1 : 0);
+        };
+
+        thread writer(write);
+        vector<thread> threads;
+        for (int r = 0; r < readers; ++r)
+        {
+            threads.push_back(thread(read, r));
+        }
+        this_thread::sleep_for(chrono::milliseconds(millis));
+        stop = true;
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        writer.join();
+
+        size_t total = 0;
+        for (size_t count : counts)
+        {
+            total += count;
+        }
+        return total / (millis / 1000.0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int millis = argc > 1 ? atoi(argv[1]) : 200;
+    if (millis <= 0)
+    {
+        fprintf(stderr, "usage: %s [milliseconds per run]\n", argv[0]);
+        return 1;
+    }
+
+    printf("one site, 10 variables, a writer committing to all of them every 50 us; %u hardware threads\n",
+           thread::hardware_concurrency());
+    printf("%-10s %16s %16s %16s\n", "readers", "latest Mr/s", "snapshot Mr/s", "locked Mr/s");
+    const int readerCounts[] = {1, 2, 4, 8};
+    for (int readers : readerCounts)
+    {
+        double latest = run(Mode::LATEST, readers, millis);
+        double snapshot = run(Mode::SNAPSHOT, readers, millis);
+        double history = run(Mode::HISTORY, readers, millis);
+        printf("%-10d %16.2f %16.2f %16.2f\n", readers, latest / 1e6, snapshot / 1e6, history / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:26:40
+ */
+
+// Description: Compares commit latency of synchronous replication against lazy primary-copy
+// replication as the number of replicas grows, and reports how far lazy replicas lag.
+// Usage: bench_replication [commits]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "DataManager.h"
+#include "Transaction.h"
+using namespace std;
+
+namespace
+{
+    const int WRITES_PER_COMMIT = 4;
+
+    struct Result
+    {
+        double commitMicros; // Mean time spent inside commitTransaction
+        double drainMicros;  // Time for replicas to converge after the last commit
+        ReplicationStats replication;
+    };
+
+    Result run(int sites, int commits, bool lazy)
+    {
+        DataManager dataManager(sites);
+        dataManager.setLazyReplication(lazy);
+        double commitMicros = 0;
+
+        for (int c = 0; c < commits; ++c)
+        {
+            auto transaction = make_shared<Transaction>("T" + to_string(c), false);
+            for (int w = 0; w < WRITES_PER_COMMIT; ++w)
+            {
+                transaction->addWriteVariable("x" + to_string(2 + 2 * ((c + w) % 10)), c);
+            }
+            transaction->setCommitTime(chrono::system_clock::now().time_since_epoch().count());
+
+            auto start = chrono::steady_clock::now();
+            dataManager.commitTransaction(transaction);
+            commitMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+
+        auto drainStart = chrono::steady_clock::now();
+        dataManager.drainReplication();
+        double drainMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - drainStart).count();
+        return {commitMicros / commits, drainMicros, dataManager.getReplicationStats()};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int commits = argc > 1 ? atoi(argv[1]) : 20000;
+    if (commits <= 0)
+    {
+        fprintf(stderr, "usage: %s [commits]\n", argv[0]);
+        return 1;
+    }
+
+    printf("commits: %d, %d replicated writes each\n", commits, WRITES_PER_COMMIT);
+    printf("%8s %14s %14s %14s %14s %14s\n", "replicas", "sync us/commit", "lazy us/commit",
+           "lag avg us", "lag max us", "drain us");
+    const int replicaCounts[] = {2, 4, 8, 16, 32, 64};
+    for (int sites : replicaCounts)
+    {
+        Result sync = run(sites, commits, false);
+        Result lazy = run(sites, commits, true);
+        printf("%8d %14.2f %14.2f %14.1f %14.1f %14.1f\n", sites, sync.commitMicros, lazy.commitMicros,
+               lazy.replication.averageLagMicros, lazy.replication.maxLagMicros, lazy.drainMicros);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:55:00
+ */
+
+// Description: Measures spilling cold version history to disk. A site commits deep histories to
+// its ten variables, then spills every block older than the latest version. The table shows the
+// version bytes left in memory against those on disk, the time to spill, and what reads far in
+// the past cost: the first pass pages each block back in from the spill file, a second pass over
+// the same timestamps finds them in memory again and serves as the baseline.
+// Usage: bench_spill [reads per pass]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Site.h"
+#include "SpillFile.h"
+using namespace std;
+
+namespace
+{
+    // Even variables, all stored at every site
+    vector<string> evenVariables()
+    {
+        vector<string> names;
+        for (int i = 2; i <= 20; i += 2)
+        {
+            names.push_back("x" + to_string(i));
+        }
+        return names;
+    }
+
+    // Returns microseconds per read of random past timestamps, checking each value
+    double microsPerRead(Site &site, const vector<string> &names, long depth, int reads, unsigned seed, bool &correct)
+    {
+        mt19937 random(seed);
+        uniform_int_distribution<long> time(1, depth);
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < reads; ++i)
+        {
+            long timestamp = time(random);
+            // Version t of every variable holds t
+            correct = correct && site.readVariable(names[i % names.size()], timestamp) == timestamp;
+        }
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / reads;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int reads = argc > 1 ? atoi(argv[1]) : 20000;
+    if (reads <= 0)
+    {
+        fprintf(stderr, "usage: %s [reads per pass]\n", argv[0]);
+        return 1;
+    }
+
+    vector<string> names = evenVariables();
+    printf("one site, 10 variables; %d reads at random past times per pass\n", reads);
+    printf("%-10s %12s %12s %10s %14s %14s %8s\n", "versions", "before KB", "resident KB", "spill ms", "paging us/rd",
+           "memory us/rd", "correct");
+    const long depths[] = {1000, 10000, 100000};
+    for (long depth : depths)
+    {
+        Site site(2);
+        for (long t = 1; t <= depth; ++t)
+        {
+            for (const auto &name : names)
+            {
+                site.writeVariable(name, static_cast<int>(t), t);
+            }
+        }
+        size_t before = site.getVersionBytes();
+
+        auto file = make_shared<SpillFile>(sizeof(VersionBlock));
+        auto start = chrono::steady_clock::now();
+        site.spillVersions(depth, file, numeric_limits<size_t>::max());
+        double spillMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        size_t resident = site.getVersionBytes();
+
+        bool correct = site.getSpilledBytes() + resident >= before;
+        double paging = microsPerRead(site, names, depth, reads, 7, correct);
+        double memory = microsPerRead(site, names, depth, reads, 7, correct);
+        printf("%-10ld %12zu %12zu %10.1f %14.2f %14.2f %8s\n", depth, before / 1024, resident / 1024, spillMillis,
+               paging, memory, correct ? "yes" : "NO");
+    }
+    return 0;
+}
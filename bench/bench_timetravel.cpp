@@ -0,0 +1,145 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:47:20
+ */
+
+// Description: Measures time-travel reads on long version histories. Part one times lookups at
+// random past timestamps in a variable with up to millions of versions, against the previous
+// search that binary searched the block pointers and so touched one block per probe. Part two
+// applies the retention policy to the largest history with a number of registered snapshots
+// and reports what survives and how long the prune and the lookups afterwards take.
+// Usage: bench_timetravel [lookups]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "SlabPool.h"
+#include "Variable.h"
+using namespace std;
+
+namespace
+{
+    const long SIZES[] = {1000, 100000, 1000000, 4000000};
+    const int SNAPSHOTS[] = {0, 16, 1024};
+
+    // The previous lookup: binary search over the blocks by their first commit time
+    long pointerSearch(const vector<VersionBlock *> &blocks, long timestamp)
+    {
+        auto bit = upper_bound(blocks.begin(), blocks.end(), timestamp,
+                               [](long time, const VersionBlock *block) { return time < block->commitTimes[0]; });
+        const VersionBlock *block = *(bit - 1);
+        const long *end = block->commitTimes + block->count;
+        int index = static_cast<int>(upper_bound(block->commitTimes, end, timestamp) - block->commitTimes) - 1;
+        return block->values[index];
+    }
+
+    // Times lookups at the given timestamps; the checksum keeps the reads from being optimized away
+    template <typename Lookup>
+    double timeLookups(const vector<long> &timestamps, Lookup lookup, long &checksum)
+    {
+        auto start = chrono::steady_clock::now();
+        for (long timestamp : timestamps)
+        {
+            checksum += lookup(timestamp);
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / timestamps.size();
+    }
+
+    // Fills a variable with versions committed at times 1..count, value equal to the time
+    void fill(Variable &variable, long count)
+    {
+        for (long time = 1; time <= count; ++time)
+        {
+            variable.writeValue(static_cast<int>(time), time);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int lookups = argc > 1 ? atoi(argv[1]) : 1000000;
+    mt19937 random(5);
+    long checksum = 0;
+
+    printf("Lookups at random past timestamps, %d per history\n", lookups);
+    printf("%10s %18s %16s\n", "versions", "block ptrs ns/op", "dense ns/op");
+    for (long size : SIZES)
+    {
+        SlabPool slab(sizeof(VersionBlock));
+        Variable variable("x2", 20, &slab);
+        fill(variable, size);
+
+        // Rebuild the same history as bare blocks for the previous search
+        SlabPool baselineSlab(sizeof(VersionBlock));
+        vector<VersionBlock *> blocks;
+        for (long time = 0; time <= size; ++time)
+        {
+            if (blocks.empty() || blocks.back()->count == VERSIONS_PER_BLOCK)
+            {
+                blocks.push_back(static_cast<VersionBlock *>(baselineSlab.allocate()));
+                blocks.back()->count = 0;
+            }
+            VersionBlock *block = blocks.back();
+            block->commitTimes[block->count] = time;
+            block->values[block->count] = static_cast<int>(time);
+            ++block->count;
+        }
+
+        uniform_int_distribution<long> pickTime(0, size - 1);
+        vector<long> timestamps(lookups);
+        for (long &timestamp : timestamps)
+        {
+            timestamp = pickTime(random);
+        }
+        double pointerNanos = timeLookups(timestamps, [&](long t) { return pointerSearch(blocks, t); }, checksum);
+        double denseNanos = timeLookups(timestamps, [&](long t) { return (long)variable.readValue(t); }, checksum);
+        printf("%10ld %18.1f %16.1f\n", size, pointerNanos, denseNanos);
+        for (VersionBlock *block : blocks)
+        {
+            baselineSlab.deallocate(block);
+        }
+    }
+
+    long size = SIZES[sizeof(SIZES) / sizeof(SIZES[0]) - 1];
+    printf("\nRetention on %ld versions\n", size);
+    printf("%10s %10s %12s %16s\n", "snapshots", "kept", "prune ms", "lookup ns/op");
+    for (int count : SNAPSHOTS)
+    {
+        SlabPool slab(sizeof(VersionBlock));
+        Variable variable("x2", 20, &slab);
+        fill(variable, size);
+        vector<long> keepTimes;
+        uniform_int_distribution<long> pickTime(0, size - 1);
+        for (int i = 0; i < count; ++i)
+        {
+            keepTimes.push_back(pickTime(random));
+        }
+        sort(keepTimes.begin(), keepTimes.end());
+
+        auto start = chrono::steady_clock::now();
+        variable.pruneVersions(keepTimes);
+        double pruneMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        // Registered snapshots still read exactly what they read before the prune
+        vector<long> timestamps;
+        for (int i = 0; i < lookups; ++i)
+        {
+            timestamps.push_back(keepTimes.empty() ? size : keepTimes[i % keepTimes.size()]);
+        }
+        for (long timestamp : keepTimes)
+        {
+            if (variable.readValue(timestamp) != (timestamp == 0 ? 20 : timestamp))
+            {
+                printf("snapshot at %ld reads the wrong value\n", timestamp);
+                return 1;
+            }
+        }
+        double lookupNanos = timeLookups(timestamps, [&](long t) { return (long)variable.readValue(t); }, checksum);
+        printf("%10d %10zu %12.2f %16.1f\n", count, variable.getVersionCount(), pruneMillis, lookupNanos);
+    }
+    printf("\n(checksum %ld)\n", checksum);
+    return 0;
+}
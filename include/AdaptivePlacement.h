@@ -0,0 +1,97 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:51:00
+ */
+
+// Adaptive replication. An AccessHeatmap counts the reads and writes of every variable and the
+// reads served and writes applied by every site; counts are halved after each rebalance, so
+// they follow the recent workload. AdaptivePlacement turns a heatmap into replica moves: a
+// variable with many more reads than writes gains a replica at the least loaded site that
+// lacks one, and a variable with many more writes than reads loses the replica at the most
+// loaded site that holds one. The DataManager carries the moves out.
+#ifndef ADAPTIVE_PLACEMENT_H
+#define ADAPTIVE_PLACEMENT_H
+
+#include <cstdint>
+#include <vector>
+
+// Accesses of one variable, or served by one site
+struct AccessCounts
+{
+    uint64_t reads;  // Reads
+    uint64_t writes; // Committed writes (for a site: replica applies)
+};
+
+// Thresholds of the placement policy
+struct PlacementPolicy
+{
+    uint64_t hotAccesses; // Reads or writes in a window that make a variable hot
+    uint64_t dominance;   // A hot variable needs this many times more reads than writes, or the reverse
+    int minReplicas;      // Fewest copies a write-hot variable is cut down to
+};
+
+// One replica added or dropped
+struct PlacementMove
+{
+    int variableIndex; // Variable (i of xi)
+    int siteId;        // Site gaining or losing the copy
+    bool add;          // True to add a replica, false to drop one
+    uint64_t reads;    // Reads of the variable that led to the move
+    uint64_t writes;   // Writes of the variable that led to the move
+};
+
+class AccessHeatmap
+{
+public:
+    // Counts accesses of variables 1..numVariables at sites 1..numSites
+    AccessHeatmap(int numVariables, int numSites);
+
+    // Records a read of a variable served by a site
+    void recordRead(int variableIndex, int siteId);
+
+    // Records a committed write of a variable
+    void recordWrite(int variableIndex);
+
+    // Records a site applying a write to its copy
+    void recordSiteWrite(int siteId);
+
+    // Returns the accesses of a variable in the current window
+    const AccessCounts &getVariable(int variableIndex) const;
+
+    // Returns the accesses a site served in the current window
+    const AccessCounts &getSite(int siteId) const;
+
+    // Returns the number of sites counted
+    int getSiteCount() const;
+
+    // Halves every count, ending a window
+    void decay();
+
+private:
+    std::vector<AccessCounts> variables; // Counts by variable index
+    std::vector<AccessCounts> sites;     // Counts by site ID
+};
+
+class AdaptivePlacement
+{
+public:
+    // Creates an engine with the given thresholds
+    explicit AdaptivePlacement(const PlacementPolicy &policy = PlacementPolicy{16, 4, 1});
+
+    // Proposes at most one move per hot variable, hottest first. replicas lists the sites holding
+    // each variable by index; only sites marked usable receive or lose copies
+    std::vector<PlacementMove> plan(const AccessHeatmap &heatmap, const std::vector<std::vector<int>> &replicas,
+                                    const std::vector<bool> &usableSites) const;
+
+    // Replaces the thresholds
+    void setPolicy(const PlacementPolicy &policy);
+
+    // Returns the thresholds
+    const PlacementPolicy &getPolicy() const;
+
+private:
+    PlacementPolicy policy; // Thresholds
+};
+
+#endif // ADAPTIVE_PLACEMENT_H
@@ -0,0 +1,74 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:44:50
+ */
+
+// Contention-aware admission control in front of the TransactionManager. Every finished
+// transaction cools all variables by a decay factor, and each variable an aborted transaction
+// touched heats up by one, so a variable is hot while it keeps appearing in recent aborts. A
+// transaction is admitted only if none of the hot variables in its access set is claimed by
+// another admitted transaction; admitted transactions claim the hot variables they use until
+// they finish. Variables that are not hot never hold anyone back.
+#ifndef ADMISSION_SCHEDULER_H
+#define ADMISSION_SCHEDULER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Admission counters
+struct AdmissionStats
+{
+    size_t admitted;    // Transactions admitted, held ones included
+    size_t held;        // Transactions that had to wait for admission
+    size_t heldAborts;  // Aborts among transactions that were held
+    size_t otherAborts; // Aborts among transactions admitted right away
+};
+
+class AdmissionScheduler
+{
+public:
+    // Variables whose heat reaches hotThreshold are hot; heat is multiplied by decay per finished transaction
+    AdmissionScheduler(double hotThreshold = 0.5, double decay = 0.95);
+
+    // Admits a transaction unless a hot variable of its access set is claimed; reports the first one that is
+    bool tryAdmit(const std::string &transactionName, const std::vector<std::string> &accessSet,
+                  std::string &blockingVariable);
+
+    // Notes that an admitted transaction had to wait before it was admitted
+    void markHeld(const std::string &transactionName);
+
+    // Claims the unclaimed hot variables an admitted transaction goes on to use
+    void claim(const std::string &transactionName, const std::vector<std::string> &variables);
+
+    // Records how a transaction ended and releases its claims
+    void finish(const std::string &transactionName, bool committed, const std::vector<std::string> &variables);
+
+    // Checks if a variable is hot
+    bool isHot(const std::string &variableName) const;
+
+    // Returns the claimant of a variable, or "" if none
+    std::string getClaimant(const std::string &variableName) const;
+
+    // Changes the heat at which variables count as hot
+    void setHotThreshold(double threshold);
+
+    // Returns the current heat of every variable that has any
+    const std::map<std::string, double> &getHeat() const;
+
+    // Returns admission counters
+    const AdmissionStats &getStats() const;
+
+private:
+    double hotThreshold;                          // Heat at which a variable is hot
+    double decay;                                 // Factor applied to all heat per finished transaction
+    std::map<std::string, double> heat;           // Conflict heat per variable
+    std::map<std::string, std::string> claims;    // Hot variable -> admitted transaction using it
+    std::map<std::string, std::set<std::string>> claimed; // Transaction -> variables it claims
+    std::set<std::string> heldTransactions;       // Admitted transactions that had waited
+    AdmissionStats stats;                         // Counters
+};
+
+#endif // ADMISSION_SCHEDULER_H
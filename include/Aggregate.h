@@ -0,0 +1,50 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:15:12
+ */
+
+// Reduction and filter kernels used by scan and aggregate commands. Each kernel works on a
+// contiguous buffer of snapshot values gathered from the sites, using SSE2 when available.
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Aggregate operations supported over a range of variables
+enum class AggregateOp
+{
+    SUM,  // Sum of all values
+    MIN,  // Smallest value
+    MAX,  // Largest value
+    SCAN  // Every value matching a predicate
+};
+
+// Comparison used by SCAN to filter values
+enum class ScanPredicate
+{
+    ALL,      // Keep every value
+    LESS,     // Keep values < operand
+    GREATER,  // Keep values > operand
+    EQUAL     // Keep values == operand
+};
+
+// Returns the sum of values, accumulated in 64 bits
+long long sumValues(const int *values, size_t count);
+
+// Returns the smallest of a non-empty buffer of values
+int minValue(const int *values, size_t count);
+
+// Returns the largest of a non-empty buffer of values
+int maxValue(const int *values, size_t count);
+
+// Appends the positions of values matching the predicate to matches
+void filterValues(const int *values, size_t count, ScanPredicate predicate, int operand, std::vector<uint32_t> &matches);
+
+// Returns the command name of an aggregate operation
+std::string aggregateName(AggregateOp op);
+
+#endif // AGGREGATE_H
@@ -0,0 +1,89 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:14:20
+ */
+
+// Bump-pointer arena for per-transaction bookkeeping. Allocations are carved out of an
+// inline buffer first and then out of chained heap blocks; nothing is freed individually,
+// the whole region is released at once when the owning transaction retires.
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+
+class Arena
+{
+public:
+    // Size of the buffer embedded in the arena itself. Finished transactions stay in the
+    // transaction table with their arena, so this is kept to a few small sets' worth; larger
+    // read/write sets take one heap block that retire() frees
+    static const size_t INLINE_BYTES = 256;
+
+    // Creates an empty arena that grows by blocks of at least blockSize bytes
+    explicit Arena(size_t blockSize = 4096);
+
+    // Releases every block owned by the arena
+    ~Arena();
+
+    // Returns aligned storage for the given number of bytes
+    void *allocate(size_t bytes, size_t alignment);
+
+    // Frees all overflow blocks and rewinds to the inline buffer
+    void reset();
+
+    // Returns the number of heap blocks currently chained to the arena
+    size_t getOverflowBlockCount() const;
+
+private:
+    struct Block
+    {
+        Block *next;   // Previously filled block
+        size_t size;   // Usable bytes following this header
+    };
+
+    alignas(std::max_align_t) unsigned char inlineBuffer[INLINE_BYTES]; // First region, no allocation needed
+    unsigned char *cursor;     // Next free byte in the current region
+    unsigned char *limit;      // End of the current region
+    Block *blocks;             // Chain of heap blocks, newest first
+    size_t blockSize;          // Minimum size of a new heap block
+    size_t overflowBlocks;     // Number of heap blocks in the chain
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+};
+
+// STL allocator that draws from an Arena; deallocation is a no-op
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    // Binds the allocator to an arena
+    explicit ArenaAllocator(Arena &arena) : arena(&arena) {}
+
+    // Rebinding constructor required by node-based containers
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    // Returns storage for n objects of type T from the arena
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Memory is reclaimed only when the arena is reset
+    void deallocate(T *, size_t) {}
+
+    Arena *arena; // Arena the storage comes from
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena == b.arena; }
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena != b.arena; }
+
+#endif // ARENA_H
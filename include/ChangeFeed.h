@@ -0,0 +1,138 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:49:30
+ */
+
+// Change-data-capture feed of committed writes. The DataManager publishes one record per
+// committed write into a fixed-size broadcast ring. Publishing never waits: each slot carries
+// a stamp that is odd while the slot is being written, and the newest records overwrite the
+// oldest. Every subscriber keeps its own cursor and copies records out, checking the stamp
+// before and after so it notices when it fell a full ring behind. Such a subscriber is either
+// told how many records it missed and moved to the oldest record still held, or dropped.
+// Records can also be appended to a file in a compact binary form (see ChangeFeed::readFile).
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Longest transaction name kept in a record; longer names are cut
+const size_t CHANGE_NAME_LENGTH = 23;
+
+// One committed write
+struct ChangeRecord
+{
+    uint64_t sequence;                       // Position in the feed, from 1
+    long commitTime;                         // Commit time of the transaction
+    int variableIndex;                       // Variable written (i of xi)
+    int value;                               // Value committed
+    uint64_t siteMask;                       // Bit i-1 set if site i applies the write (sites 1..64)
+    char transaction[CHANGE_NAME_LENGTH + 1]; // Writing transaction, null-terminated
+};
+
+// What a subscriber does when it falls a whole ring behind
+enum class LagPolicy
+{
+    REPORT, // Skip to the oldest record still held and report the number missed
+    DROP    // Stop receiving records
+};
+
+// Result of a poll
+enum class PollStatus
+{
+    OK,     // Every record since the last poll was delivered
+    LAGGED, // Some records were overwritten before they could be read
+    DROPPED // The subscriber lagged under LagPolicy::DROP and receives nothing more
+};
+
+// Publishing counters
+struct ChangeFeedStats
+{
+    uint64_t published;   // Records published
+    uint64_t sinkRecords; // Records appended to the file sink
+    uint64_t sinkBytes;   // Bytes appended to the file sink
+};
+
+class ChangeFeed
+{
+public:
+    // Creates a feed holding the latest capacity records (rounded up to a power of two)
+    explicit ChangeFeed(size_t capacity = 1024);
+
+    // Flushes and closes the file sink
+    ~ChangeFeed();
+
+    // Publishes a committed write; never waits for subscribers
+    void publish(const std::string &transactionName, long commitTime, int variableIndex, int value,
+                 uint64_t siteMask);
+
+    // Appends every later record to a file, creating it if needed; false if it cannot be opened
+    bool openSink(const std::string &path);
+
+    // Flushes and closes the file sink, if any
+    void closeSink();
+
+    // Returns the number of records the ring holds
+    size_t getCapacity() const;
+
+    // Returns the sequence number the next record will get
+    uint64_t getNextSequence() const;
+
+    // Returns publishing counters
+    ChangeFeedStats getStats() const;
+
+    // Reads every record of a file written by a sink; throws runtime_error if it is not one
+    static std::vector<ChangeRecord> readFile(const std::string &path);
+
+private:
+    friend class ChangeSubscriber;
+
+    // Ring slot, one cache line
+    struct Slot
+    {
+        std::atomic<uint64_t> stamp; // 2 * sequence while readable, odd while being written
+        ChangeRecord record;         // The record
+    };
+
+    std::unique_ptr<Slot[]> slots;     // The ring
+    size_t mask;                       // Capacity - 1
+    std::atomic<uint64_t> next;        // Sequence of the next record
+    FILE *sink;                        // Append-only file, or null
+    long sinkLastTime;                 // Commit time of the last record in the sink, for deltas
+    uint64_t sinkLastSequence;         // Sequence of the last record in the sink, for deltas
+    ChangeFeedStats stats;             // Counters
+
+    // Appends a record to the sink
+    void writeToSink(const ChangeRecord &record);
+
+    ChangeFeed(const ChangeFeed &) = delete;
+    ChangeFeed &operator=(const ChangeFeed &) = delete;
+};
+
+// One consumer of a feed; owned by the consumer and used from one thread at a time
+class ChangeSubscriber
+{
+public:
+    // Subscribes to records published from now on
+    ChangeSubscriber(const ChangeFeed &feed, LagPolicy policy = LagPolicy::REPORT);
+
+    // Appends up to maxRecords new records to out, oldest first
+    PollStatus poll(std::vector<ChangeRecord> &out, size_t maxRecords = SIZE_MAX);
+
+    // Returns the number of records this subscriber missed by lagging
+    uint64_t getMissed() const;
+
+private:
+    const ChangeFeed *feed; // Feed read from
+    LagPolicy policy;       // What to do when lagging
+    uint64_t cursor;        // Sequence of the next record to read
+    uint64_t missed;        // Records skipped because they were overwritten
+    bool dropped;           // Lagged under LagPolicy::DROP
+};
+
+#endif // CHANGE_FEED_H
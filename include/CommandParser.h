@@ -1,26 +1,88 @@
 /**
  * @   Author: Ke Wang & Siwen Tao
  * @   Email: kw3484@nyu.edu & st5297@nyu.edu
- * @   Modified time: 2024-12-08 22:07:05
+ * @   Modified time: 2024-12-08 22:52:30
  */
 
 // Parses input commands for the distributed database system and converts them into
 // structured operations. Handles transaction commands (begin, read, write, end) and
-// system commands (fail, recover, dump).
+// system commands (fail, recover, dump). Parsing needs no state, so lines can be parsed
+// on any thread and the resulting commands executed later in input order. Stored procedure
+// bodies are compiled here too.
 #ifndef COMMAND_PARSER_H
 #define COMMAND_PARSER_H
 #include <string>
+#include <utility>
 #include <vector>
+#include "Aggregate.h"
+#include "StoredProcedure.h"
 class TransactionManager;
+// Kind of a parsed command
+enum class CommandType {
+ NONE,        // Blank line or comment, nothing to do
+ UNKNOWN,     // Not a command; text holds the line
+ INVALID,     // A number or variable range out of bounds; text holds the line
+ BEGIN,       // begin(T1) or begin(T1, x2, x4..x6)
+ BEGIN_RO,    // beginRO(T1)
+ BEGIN_AS_OF, // beginAsOf(T1, S1)
+ WRITE,       // W(T1, x2, 5)
+ WRITE_BATCH, // W(T1, x2=5, x4..x8=0)
+ INCREMENT,   // INC(T1, x2, 5)
+ READ,        // R(T1, x2)
+ READ_BATCH,  // R(T1, x1, x2) or R(T1, x1..x6)
+ AGGREGATE,   // SUM/MIN/MAX/SCAN(T1, x1..x20[, >100])
+ END,         // end(T1) or end(T1, T2, ...)
+ DUMP,        // dump()
+ STATS,       // stats()
+ SNAPSHOT,    // snapshot(S1)
+ RELEASE,     // release(S1)
+ SUBSCRIBE,   // subscribe(C1[, drop])
+ POLL,        // poll(C1)
+ UNSUBSCRIBE, // unsubscribe(C1)
+ REPLICATE,   // replicate(x3, 4)
+ UNREPLICATE, // unreplicate(x3, 4)
+ REBALANCE,   // rebalance()
+ PRUNE,       // prune()
+ CONFIG,      // config(option, value)
+ QUORUM,      // quorum(x2..x4, R, W)
+ FAIL,        // fail(3)
+ RECOVER,     // recover(3)
+ DEFINE,      // DEFINE transfer(T, from, to, amount), then the body lines, then END
+ DEFINE_END,  // END
+ CALL         // CALL transfer(T9, x2, x4, 10)
+};
+// A command line parsed into its arguments
+struct Command {
+ CommandType type;
+ std::string name;                                // Transaction, snapshot, subscriber, option or variable named first
+ std::string text;                                // Option value or as-of point; the whole line if unknown
+ std::string line;                                // The trimmed line, kept as the body of a procedure being defined
+ std::vector<std::string> names;                  // Variables listed (transactions for end, parameters or arguments of procedures)
+ std::vector<std::pair<std::string, int>> writes; // Variable and value of each write or increment
+ int number;                                      // Site ID, read quorum or scan operand
+ int secondNumber;                                // Write quorum
+ bool flag;                                       // subscribe: drop the subscriber when it lags
+ AggregateOp op;                                  // Aggregate operation
+ ScanPredicate predicate;                         // Aggregate filter
+};
 class CommandParser {
 public:
  // Initialize parser with transaction manager reference
 CommandParser(TransactionManager& tm);
  // Parse and execute a single command string
 void parseCommand(const std::string& command);
+ // Parse a command string without executing it; touches no shared state
+static Command parse(const std::string& command);
+ // Execute a parsed command
+void execute(const Command& command);
+ // Compile the body lines of a procedure; false with error set if a line cannot be compiled
+static bool compileProcedure(const std::string& name, const std::vector<std::string>& parameters,
+                             const std::vector<std::string>& body, StoredProcedure& procedure, std::string& error);
+ // Check if an input line is skipped before parsing (empty or a comment)
+static bool isSkipped(const char* line, size_t length);
 private:
 TransactionManager& transactionManager;
  // Split string into tokens based on delimiter
  std::vector<std::string> tokenize(const std::string& str, char delimiter);
 };
-#endif // COMMAND_PARSER_H
\ No newline at end of file
+#endif // COMMAND_PARSER_H
@@ -0,0 +1,94 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:36:30
+ */
+
+// Two-phase commit coordinator used by the TransactionManager. Sites are the participants:
+// each votes on a prepare request and installs its staged writes once told the decision,
+// which the coordinator logs before sending. Prepare and decide messages of transactions
+// committing together are coalesced into one batch per site, and every message exchange is
+// charged to a simulated clock so the savings from batching can be measured.
+#ifndef COMMIT_COORDINATOR_H
+#define COMMIT_COORDINATOR_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataManager.h"
+#include "Transaction.h"
+
+// Cost of one coordinator-to-site exchange in the simulated network
+struct MessageLatencyModel
+{
+    double roundTripMicros;  // Fixed cost of a request and its reply
+    double perMessageMicros; // Added cost of each message carried in a batch
+};
+
+// Protocol and simulated messaging counters
+struct CommitStats
+{
+    size_t transactions;     // Transactions run through two-phase commit
+    size_t aborted;          // Of those, transactions a participant voted against
+    size_t prepareMessages;  // Prepare requests, one per transaction and participant
+    size_t decideMessages;   // Decision messages delivered
+    size_t roundTrips;       // Batches exchanged with sites
+    double simulatedMicros;  // Simulated time spent in message exchanges
+};
+
+// Result of running one transaction through the protocol
+struct CommitOutcome
+{
+    bool committed;     // Decision of the coordinator
+    int rejectingSite;  // First participant that did not vote yes, -1 if none
+};
+
+class CommitCoordinator
+{
+public:
+    // Uses the data manager to reach the sites
+    explicit CommitCoordinator(std::shared_ptr<DataManager> dataManager);
+
+    // Commits validated transactions (with commit times set); outcomes follow the input order
+    std::vector<CommitOutcome> commit(const std::vector<std::shared_ptr<Transaction>> &group);
+
+    // Sends recorded decisions to a recovered site for the transactions it is in doubt about
+    void resolveInDoubt(int siteId);
+
+    // Turns coalescing of messages across a commit group on or off
+    void setBatching(bool enabled);
+
+    // Replaces the simulated message costs
+    void setLatencyModel(const MessageLatencyModel &model);
+
+    // Returns the current simulated message costs
+    const MessageLatencyModel &getLatencyModel() const;
+
+    // Fails a site when it receives the next prepare request (test hook)
+    void failOnPrepare(int siteId);
+
+    // Fails a site after it votes yes, before the decision reaches it (test hook)
+    void failBeforeDecide(int siteId);
+
+    // Returns protocol counters
+    const CommitStats &getStats() const;
+
+private:
+    std::shared_ptr<DataManager> dataManager; // Access to participant sites
+    std::map<std::string, bool> decisionLog;  // Logged decision per transaction, true for commit
+    bool batching;                            // Coalesce messages of a commit group per site
+    MessageLatencyModel latency;              // Simulated network costs
+    CommitStats stats;                        // Counters
+    int prepareFailureSite;                   // Site to fail on prepare, -1 for none
+    int decideFailureSite;                    // Site to fail before the decision, -1 for none
+
+    // Runs both phases for transactions whose messages share batches
+    void runGroup(const std::vector<std::shared_ptr<Transaction>> &group, std::vector<CommitOutcome> &outcomes,
+                  size_t firstOutcome);
+
+    // Charges one phase in which each site receives the given number of messages in parallel
+    void chargePhase(const std::map<int, size_t> &messagesBySite);
+};
+
+#endif // COMMIT_COORDINATOR_H
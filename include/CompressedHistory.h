@@ -0,0 +1,91 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:48:10
+ */
+
+// Compressed version store for one variable. Versions are packed into fixed-size blocks: the
+// header holds the first version in full, and each later version is stored as zigzag varint
+// deltas of its commit time and value from the one before. Binary search over the headers
+// skips whole blocks, so only the block that answers is decoded. Full blocks never change,
+// and they are interned in a BlockInterner shared by every site on the node, so replicas that
+// received the same writes hold one copy of each block.
+#ifndef COMPRESSED_HISTORY_H
+#define COMPRESSED_HISTORY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Variable.h"
+
+// Payload bytes in one compressed block
+const size_t COMPRESSED_BLOCK_BYTES = 64;
+
+// Fixed-size run of versions: the first in the header, the rest as deltas
+struct CompressedBlock
+{
+    long firstTime;                          // Commit time of the first version, what searches compare
+    int firstValue;                          // Value of the first version
+    uint16_t count;                          // Versions in the block, the first included
+    uint16_t used;                           // Payload bytes in use
+    uint8_t payload[COMPRESSED_BLOCK_BYTES]; // Time and value deltas of the later versions
+};
+
+// Deduplicates full compressed blocks so identical histories share their storage
+class BlockInterner
+{
+public:
+    // Returns a shared copy of the block, reusing an identical block that is still alive
+    std::shared_ptr<const CompressedBlock> intern(const CompressedBlock &block);
+
+    // Returns the number of blocks alive and the bytes sharing them saves
+    void getUsage(size_t &liveBlocks, size_t &savedBytes) const;
+
+private:
+    mutable std::mutex internMutex; // Sites seal blocks from the replication thread too
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const CompressedBlock>>> blocks; // Blocks by content hash
+};
+
+class CompressedHistory
+{
+public:
+    // Creates an empty history; full blocks are shared through interner if given
+    explicit CompressedHistory(BlockInterner *interner = nullptr);
+
+    // Appends a version; commit times must not decrease
+    void append(int value, long commitTime);
+
+    // Finds the version visible at timestamp; false if every version is newer
+    bool find(long timestamp, Version &version) const;
+
+    // Returns the most recent version; the history must not be empty
+    Version latest() const;
+
+    // Appends every version committed strictly after afterTime to out, oldest first
+    void collectAfter(long afterTime, std::vector<Version> &out) const;
+
+    // Drops versions not visible at any of the ascending keepTimes, except the latest; returns how many
+    size_t prune(const std::vector<long> &keepTimes);
+
+    // Returns the number of versions stored
+    size_t size() const;
+
+    // Returns the bytes this history holds, counting shared blocks in full
+    size_t getBytes() const;
+
+private:
+    BlockInterner *interner;                                    // Where full blocks are shared, or null
+    std::vector<std::shared_ptr<const CompressedBlock>> sealed; // Full blocks, oldest first
+    std::vector<long> sealedStarts;                             // First commit time of each full block
+    CompressedBlock tail;                                       // Block being filled
+    long lastTime;                                              // Commit time of the latest version
+    int lastValue;                                              // Value of the latest version
+    size_t versionCount;                                        // Versions in all blocks
+
+    // Moves the tail into the full blocks
+    void seal();
+};
+
+#endif // COMPRESSED_HISTORY_H
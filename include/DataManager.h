@@ -8,20 +8,98 @@
 // replication, site failures/recoveries, and transaction read/write operations.
 #ifndef DATA_MANAGER_H
 #define DATA_MANAGER_H
+#include <chrono>
+#include <functional>
 #include <string>
 #include <map>
 #include <vector>
 #include <memory>
+#include <ostream>
 #include "Site.h"
+#include "AdaptivePlacement.h"
+#include "Placement.h"
+#include "CompressedHistory.h"
+#include "ChangeFeed.h"
 #include "Transaction.h"
+#include "ReplicationPropagator.h"
+#include "SiteProcessHost.h"
+#include "SpillFile.h"
+// Outcome of a single variable read issued as part of a batch
+enum class ReadStatus {
+ OK,     // Value was read from a site
+ WAIT,   // Read was parked until a replica becomes available
+ ABORT   // No valid copy exists, the reader must abort
+};
+// Result slot for one variable of a batched read
+struct BatchRead {
+ std::string variableName;
+ ReadStatus status;
+ int value;
+};
+// Metrics recorded for one catch-up of a recovered site
+struct CatchUpStats {
+ int siteId;            // Site that recovered
+ int donorSiteId;       // Replica the versions were copied from
+ size_t variables;      // Replicated variables that received versions
+ size_t versions;       // Versions copied
+ size_t bytes;          // Version payload bytes copied
+ double durationMicros; // Time from recovery to the site being readable
+};
+// Metrics recorded for one recovery of a failed site
+struct RecoveryStats {
+ int siteId;             // Site that recovered
+ size_t parkedScanned;   // Parked reads examined
+ size_t parkedServed;    // Parked reads the recovered site answered
+ double markMicros;      // Site::recover: status change and stale marks for replicated copies
+ double catchUpMicros;   // Copying missed versions, 0 with catch-up off
+ double scanMicros;      // Examining and answering parked reads
+ double totalMicros;     // The whole recoverSite call
+ double firstReadMicros; // From the start of recovery to the first read the site served, -1 until it serves one
+};
+// Counters of the version retention policy
+struct RetentionStats {
+ size_t prunes;         // Times the policy was applied
+ size_t versionsPruned; // Versions dropped, summed over sites
+ size_t versionsKept;   // Versions left at all sites after the latest prune
+};
+// Size of the version storage over all sites
+struct VersionStorageStats {
+ size_t versions;       // Versions held, summed over sites
+ size_t bytes;          // Bytes of version storage, shared blocks counted once
+ size_t unsharedBytes;  // Bytes the same storage would take if no block were shared
+ size_t sharedBlocks;   // Distinct full compressed blocks alive
+};
+// Version storage in memory and on disk under the memory budget
+struct MemoryStats {
+ size_t residentBytes; // Bytes of version storage in memory, summed over sites
+ size_t spilledBytes;  // Bytes of version storage spilled to disk, summed over sites
+ size_t spills;        // Times storage neared the budget and sites spilled
+ SpillStats file;      // Traffic of the spill file
+};
+// Counters of adaptive replication
+struct PlacementStats {
+ size_t rebalances;      // Times the placement policy ran
+ size_t replicasAdded;   // Replicas added, by the policy or by hand
+ size_t replicasDropped; // Replicas dropped, by the policy or by hand
+ size_t versionsCopied;  // Versions copied into added replicas
+};
+// Read and write quorum sizes of a replicated variable
+struct QuorumConfig {
+ int readQuorum;  // Replicas consulted by a read
+ int writeQuorum; // Replicas a commit must reach
+};
 class DataManager {
 public:
- // Initialize data manager with empty sites
-DataManager();
+ // Initialize data manager with the given number of sites
+DataManager(int numSites = 10);
+ // Stop background replication before the sites go away
+~DataManager();
  // Create and initialize all database sites
 void initializeSites();
  // Get site instance by ID
  std::shared_ptr<Site> getSite(int siteId);
+ // Get number of database sites
+int getSiteCount() const;
  // Get list of all database sites
  std::vector<std::shared_ptr<Site>> getAllSites();
  // Check if variable has committed write since given time
@@ -30,15 +108,115 @@ bool hasCommittedWrite(const std::string& variableName, long startTime);
 void commitTransaction(std::shared_ptr<Transaction> transaction);
  // Print current state of all sites
 void dump();
+ // Send messages to a stream instead of standard output
+void setOutput(std::ostream& stream);
+ // Get the stream messages go to
+ std::ostream& getOutput() const;
  // Read variable value from appropriate site
 int read(const std::string& transactionName, const std::string& variableName, long timestamp);
- // Write value to variable across all available sites
-void write(std::shared_ptr<Transaction> transaction, const std::string& variableName, int value, long commitTime);
+ // Read several variables, grouping them by the site chosen to serve each one
+ std::vector<BatchRead> readBatch(const std::string& transactionName, const std::vector<std::string>& variableNames, long timestamp);
+ // Gather snapshot values into one contiguous buffer, visiting each chosen site once
+ReadStatus gatherSnapshot(const std::vector<std::string>& variableNames, long timestamp, std::vector<int>& values, std::string& blockingVariable);
+ // Write value to variable across all available sites; returns the sites reached as a bit mask
+uint64_t write(std::shared_ptr<Transaction> transaction, const std::string& variableName, int value, long commitTime);
  // Mark site as failed
 void failSite(int siteId);
- // Restore failed site
-void recoverSite(int siteId);
+ // Restore failed site; resolveInDoubt, if given, settles its in-doubt transactions before catch-up
+void recoverSite(int siteId, const std::function<void()>& resolveInDoubt = std::function<void()>());
+ // Enable or disable bulk catch-up of replicated variables on recovery
+void setCatchUpEnabled(bool enabled);
+ // Check if recovering sites catch up from an up-to-date replica
+bool isCatchUpEnabled() const;
+ // Return metrics of every catch-up performed so far
+const std::vector<CatchUpStats>& getCatchUpHistory() const;
+ // Return metrics of every recovery so far
+const std::vector<RecoveryStats>& getRecoveryHistory() const;
+ // Switch replicated writes between synchronous and lazy primary-copy propagation
+void setLazyReplication(bool enabled);
+ // Check if replicated writes are propagated lazily
+bool isLazyReplication() const;
+ // Wait until lazily propagated writes have reached every replica
+void drainReplication();
+ // Return lazy replication metrics (all zero when the mode was never enabled)
+ ReplicationStats getReplicationStats() const;
+ // Use quorum replication for a replicated variable; fails unless R + W > N
+bool setQuorum(const std::string& variableName, int readQuorum, int writeQuorum, std::string& error);
+ // Return a variable to write-all-available replication
+void clearQuorum(const std::string& variableName);
+ // Check if a variable uses quorum replication
+bool hasQuorum(const std::string& variableName) const;
+ // Check if enough replicas are live to commit a write under the variable's quorum
+bool canWriteQuorum(const std::string& variableName) const;
+ // Read the newest committed value among live copies (base of an increment); false if none is live
+bool readLatestCommitted(const std::string& variableName, int& value);
+ // Get the number of sites holding a copy of the variable
+int getReplicaCount(const std::string& variableName) const;
+ // Check if the variable has copies at more than one site
+bool isReplicated(const std::string& variableName) const;
+ // Get the sites holding a copy of the variable, in ID order
+const std::vector<int>& getReplicaSites(const std::string& variableName) const;
+ // Copy a variable's history to a site that lacks it; fails if no complete copy is up
+bool addReplica(const std::string& variableName, int siteId, std::string& error);
+ // Remove a site's copy of a variable; fails unless another complete copy stays up
+bool dropReplica(const std::string& variableName, int siteId, std::string& error);
+ // Let the placement policy add replicas to read-hot variables and drop them from write-hot ones
+ std::vector<PlacementMove> rebalance();
+ // Spread reads of replicated variables over their least loaded replicas instead of the first one
+void setAdaptivePlacement(bool enabled);
+ // Check if reads are spread over replicas
+bool isAdaptivePlacement() const;
+ // Rebuild the sites under another placement; only while nothing has committed or failed
+bool setPlacement(const ReplicaLists& placement, std::string& error);
+ // Change the thresholds of the placement policy
+void setPlacementPolicy(const PlacementPolicy& policy);
+ // Return the thresholds of the placement policy
+const PlacementPolicy& getPlacementPolicy() const;
+ // Return read and write counts per variable and per site
+const AccessHeatmap& getHeatmap() const;
+ // Return adaptive replication counters
+const PlacementStats& getPlacementStats() const;
+ // Group a transaction's writes by the sites that would apply them now (two-phase commit participants)
+ std::map<int, std::vector<StagedWrite>> planCommit(std::shared_ptr<Transaction> transaction);
+ // Deliver a two-phase commit decision to a participant and install its writes on commit
+void deliverDecision(int siteId, const std::string& transactionName, bool commit);
+ // Move every site's data into its own process (turns lazy replication off)
+void setSiteProcesses(bool enabled);
+ // Check if sites run as separate processes
+bool isSiteProcesses() const;
+ // Choose the site that serves a read, or -1 if the read has to wait
+int selectReadSite(const std::string& variableName, long timestamp);
+ // Drop versions no protected timestamp can read; the latest version of every copy is kept
+size_t pruneVersions(const std::vector<long>& protectedTimes);
+ // Check if snapshot reads at timestamp see every version committed by then (no prune removed one)
+bool isHistoryRetained(long timestamp) const;
+ // Return retention counters
+const RetentionStats& getRetentionStats() const;
+ // Store version histories compressed, with replicas sharing identical full blocks, or uncompressed
+void setCompression(bool enabled);
+ // Check if version histories are stored compressed
+bool isCompression() const;
+ // Publish committed writes to a change feed holding the latest capacity records, or stop publishing
+void setChangeCapture(bool enabled, size_t capacity = 1024);
+ // Return the change feed, or null while change capture is off
+ ChangeFeed* getChangeFeed();
+ // Count and publish the writes of a transaction committed through two-phase commit with the given participants
+void publishCommit(std::shared_ptr<Transaction> transaction, const std::map<int, std::vector<StagedWrite>>& plan);
+ // Measure the version storage of all sites
+ VersionStorageStats getVersionStorage() const;
+ // Cap the bytes of version storage in memory, 0 for no cap; false with error if the spill file cannot be made
+bool setMemoryBudget(size_t bytes, std::string& error);
+ // Return the memory budget in bytes, 0 if there is none
+size_t getMemoryBudget() const;
+ // Spill versions no protected timestamp reads once storage nears the budget; returns the bytes spilled
+size_t enforceMemoryBudget(const std::vector<long>& protectedTimes);
+ // Measure version storage in memory and on disk
+ MemoryStats getMemoryStats() const;
+ // Print data manager metrics
+void printStats() const;
 private:
+int numSites;
+ std::ostream* out; // Where messages go, standard output by default
  std::map<int, std::shared_ptr<Site>> sites;
 struct WaitingRead {
  std::string transactionName;
@@ -46,6 +224,45 @@ struct WaitingRead {
 long timestamp;
  };
  std::vector<WaitingRead> waitingReads;
+bool catchUpEnabled;
+ std::vector<CatchUpStats> catchUpHistory;
+ std::vector<RecoveryStats> recoveryHistory;        // One entry per recovery
+ // Recovered sites yet to serve a read -> their entry in recoveryHistory and when recovery began
+ std::map<int, std::pair<size_t, std::chrono::steady_clock::time_point>> awaitingFirstRead;
+ std::unique_ptr<ReplicationPropagator> propagator; // Set while lazy replication is on
+ std::map<std::string, QuorumConfig> quorums;       // Variables using quorum replication
+ std::unique_ptr<SiteProcessHost> siteProcesses;    // Set while sites run as processes
+long pruneHorizon;                                 // Time of the latest prune, 0 if none
+ RetentionStats retention;                          // Retention counters
+bool compression;                                  // Version histories are stored compressed
+ BlockInterner blockInterner;                       // Full compressed blocks shared by all sites
+ std::unique_ptr<ChangeFeed> changeFeed;            // Set while change capture is on
+ ReplicaLists replicaSites;                         // Sites holding each variable, by index
+ AccessHeatmap heatmap;                             // Reads and writes per variable and per site
+ AdaptivePlacement placement;                       // Policy proposing replica moves
+bool adaptivePlacement;                            // Reads go to the least loaded replica
+ PlacementStats placementStats;                     // Adaptive replication counters
+size_t memoryBudget;                               // Bytes of version storage kept in memory, 0 if uncapped
+ std::shared_ptr<SpillFile> spillFile;              // Where cold version blocks go, set with a budget
+size_t budgetSpills;                               // Times the budget made sites spill
+ // Check if a copy holds every version a snapshot read of the variable at timestamp needs
+bool isCopyComplete(std::shared_ptr<Site> site, const std::string& variableName, long timestamp) const;
+ // Apply a committed write to a site and, in process mode, queue it for the site's process
+void applyWrite(Site* site, const std::string& variableName, int value, long commitTime);
+ // Read the versions of variables visible at timestamp from a site's process in one round trip
+ std::vector<Version> readSiteVersions(int siteId, const std::vector<std::string>& variableNames, long timestamp);
+ // Read the newest version visible at timestamp from a read quorum; false if too few replicas are live
+bool readFromQuorum(const std::string& variableName, long timestamp, int& value);
+ // Apply a write to a write quorum of live replicas; returns the sites written as a bit mask
+uint64_t writeToQuorum(const std::string& variableName, int value, long commitTime);
+ // Check if a replica may serve a snapshot read given lazy propagation
+bool isReplicaFresh(int siteId, long timestamp) const;
+ // Pick a replica of variableName (any variable if empty) that was up for the whole of a site's last outage, or null
+ std::shared_ptr<Site> selectCatchUpDonor(std::shared_ptr<Site> site, const std::string& variableName) const;
+ // Copy missed replicated versions into a recovering site and make it readable
+void catchUpSite(std::shared_ptr<Site> site);
+ // Record the time to first read of a recovered site when a read is routed to it
+void noteSiteRead(int siteId);
  // Check if site has consistent history from given timestamp
 bool hasSiteStableHistory(std::shared_ptr<Site> site, long timestamp) const;
  // Verify site was up continuously between time points
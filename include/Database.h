@@ -0,0 +1,114 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:53:30
+ */
+
+// Typed interface to the database for programs linking librepcrec. Operations take transaction
+// names, variable indices and values directly and report what happened as results, so a host
+// needs neither command text nor the console. Messages the system would print are discarded
+// unless an output stream is set; the command-line program sets standard output.
+#ifndef DATABASE_H
+#define DATABASE_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include "Transaction.h"
+
+class DataManager;
+class TransactionManager;
+struct Command;
+
+// What became of an operation
+enum class OperationStatus
+{
+    OK,       // Done; a read carries its value
+    WAITING,  // Queued behind a lock, admission, a failed site or a retry backoff; finishes later
+    ABORTED,  // The transaction aborted; the reason says why
+    REJECTED  // Not run: the transaction is unknown or finished, or begin named an existing one
+};
+
+// Result of begin and write
+struct OperationResult
+{
+    OperationStatus status; // What became of the operation
+    AbortReason reason;     // Why the transaction aborted, NONE otherwise
+};
+
+// Result of a read
+struct ReadResult
+{
+    OperationStatus status; // OK when value holds the value read
+    AbortReason reason;     // Why the transaction aborted, NONE otherwise
+    int value;              // Value read, 0 unless status is OK
+};
+
+// Result of a commit
+struct CommitResult
+{
+    bool committed;         // The transaction committed
+    OperationStatus status; // OK when committed, otherwise why not
+    AbortReason reason;     // Why the transaction aborted, NONE otherwise
+};
+
+class Database
+{
+public:
+    // Starts a system of numSites sites with the default placement and initial values
+    explicit Database(int numSites = 10);
+
+    ~Database();
+
+    // Starts a read-write transaction
+    OperationResult begin(const std::string &transaction);
+
+    // Starts a read-only transaction reading the snapshot at its start
+    OperationResult beginReadOnly(const std::string &transaction);
+
+    // Reads variable x<variable> for the transaction
+    ReadResult read(const std::string &transaction, int variable);
+
+    // Buffers a write of value to variable x<variable> until commit
+    OperationResult write(const std::string &transaction, int variable, int value);
+
+    // Ends the transaction, committing it unless validation aborts it
+    CommitResult commit(const std::string &transaction);
+
+    // Fails a site
+    void failSite(int siteId);
+
+    // Recovers a failed site
+    void recoverSite(int siteId);
+
+    // Changes a runtime option, as config(option, value) does
+    void configure(const std::string &option, const std::string &value);
+
+    // Writes the committed state of every site to the output stream
+    void dump();
+
+    // Runs a command parsed from text; the command-line front end goes through here
+    void execute(const Command &command);
+
+    // Parses and runs one line of command text
+    void execute(const std::string &line);
+
+    // Sends messages to stream, or discards them if stream is null (the default)
+    void setOutput(std::ostream *stream);
+
+    // Returns the transaction manager, for what the typed interface does not cover
+    TransactionManager &getTransactionManager();
+
+private:
+    std::shared_ptr<DataManager> dataManager;                // Sites and their data
+    std::unique_ptr<TransactionManager> transactionManager; // Concurrency control and commit
+    std::ostream discarded;                                  // Stream without a buffer, so writes go nowhere
+
+    // Works out what became of an operation of a transaction that was active (or not) when issued
+    OperationResult settle(const std::string &transaction, bool wasActive) const;
+
+    // Checks if the transaction exists and is active
+    bool isActive(const std::string &transaction) const;
+};
+
+#endif // DATABASE_H
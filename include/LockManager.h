@@ -0,0 +1,70 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:38:05
+ */
+
+// Lock tables for the strict two-phase locking mode. Each site has its own table of Locks
+// keyed by variable index; requests that cannot be granted wait in a FIFO queue per lock,
+// upgrades from shared to exclusive go ahead of other waiters, and a wait-for graph built
+// from holders and queues is used to find deadlocks. Transactions are identified by int IDs
+// given out in begin order, so the youngest transaction is the one with the highest ID.
+#ifndef LOCK_MANAGER_H
+#define LOCK_MANAGER_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include "Lock.h"
+
+// Outcome of a lock request
+enum class LockResult
+{
+    GRANTED, // Lock is held now
+    WAITING, // Request is queued behind conflicting holders or waiters
+    BUSY     // Not granted and, as asked, not queued
+};
+
+class LockManager
+{
+public:
+    // Requests a lock on a variable at a site; queues the request if it conflicts and queueIfBusy is set
+    LockResult acquire(int transactionId, int siteId, int varIndex, Lock_type type, bool queueIfBusy = true);
+
+    // Releases every lock and queued request of a transaction; returns transactions granted a waited-for lock
+    std::vector<int> releaseAll(int transactionId);
+
+    // Drops the lock table of a failed site; returns transactions granted a waited-for lock elsewhere
+    std::vector<int> clearSite(int siteId);
+
+    // Returns the youngest transaction on a wait-for cycle, or -1 if there is no deadlock
+    int findDeadlockVictim() const;
+
+private:
+    // A queued lock request
+    struct LockRequest
+    {
+        int transactionId; // Requester
+        Lock_type type;    // Requested mode
+    };
+
+    // State of one variable's lock at one site
+    struct LockEntry
+    {
+        Lock lock;                       // Current mode and holders
+        std::deque<LockRequest> waiting; // Requests not yet granted, in grant order
+        LockEntry() : lock(NO_LOCK, std::set<int>()) {}
+    };
+
+    std::map<int, std::map<int, LockEntry>> tables;              // Site ID -> variable index -> lock
+    std::map<int, std::set<std::pair<int, int>>> touchedEntries; // Transaction -> (site, variable) held or waited on
+
+    // Checks if a request can be granted on top of the current holders
+    static bool isCompatible(const Lock &lock, const LockRequest &request);
+
+    // Grants queued requests from the front while they are compatible; returns the new holders
+    std::vector<int> grantWaiting(LockEntry &entry);
+};
+
+#endif // LOCK_MANAGER_H
@@ -0,0 +1,57 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:40:15
+ */
+
+// Version words for the optimistic concurrency control mode, in the style of Silo. Every
+// variable has one atomic word holding the commit timestamp (TID) of its latest write and a
+// lock bit. Readers record the word they saw; a committing transaction locks its write set in
+// ascending variable order, checks that every word it read is unchanged and not locked by
+// someone else, then installs its TID, so commits touching different variables never meet on
+// shared state. All operations are safe to call from several threads.
+#ifndef OCC_TABLE_H
+#define OCC_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class OccTable
+{
+public:
+    // Creates version words for variables 1..numVariables, all at version 0
+    explicit OccTable(int numVariables);
+
+    // Returns the committed version of a variable, waiting out a commit that holds it
+    uint64_t readVersion(int varIndex) const;
+
+    // Locks the words of a write set; indices must be sorted and distinct so lockers cannot deadlock
+    void lockWrites(const std::vector<int> &sortedIndices);
+
+    // Checks that each (variable, version) read is still current and not locked by another committer
+    bool validateReads(const std::vector<std::pair<int, uint64_t>> &reads, const std::vector<int> &sortedWrites) const;
+
+    // Returns a TID above every version read or overwritten and at least minimumTid
+    uint64_t chooseTid(const std::vector<std::pair<int, uint64_t>> &reads, const std::vector<int> &sortedWrites,
+                       uint64_t minimumTid) const;
+
+    // Publishes tid as the new version of each locked word and unlocks it
+    void install(const std::vector<int> &sortedWrites, uint64_t tid);
+
+    // Unlocks the words of a write set without changing their versions
+    void unlock(const std::vector<int> &sortedWrites);
+
+private:
+    static const uint64_t LOCK_BIT = uint64_t(1) << 63; // Set while a committer holds the word
+
+    int numVariables;                              // Highest variable index
+    std::unique_ptr<std::atomic<uint64_t>[]> words; // Version word per variable, index 0 unused
+
+    // Returns the word of a variable
+    std::atomic<uint64_t> &word(int varIndex) const;
+};
+
+#endif // OCC_TABLE_H
@@ -0,0 +1,145 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:52:00
+ */
+
+// Placement policies decide which sites hold a copy of each variable. A policy is any type with
+// a member void place(int variableIndex, std::vector<int> &siteIds) const that appends the sites
+// holding that variable. placeVariables runs a policy once over every variable and produces the
+// replica lists that sites and the DataManager work from, so reads and writes look a list up
+// instead of consulting the policy. Policies are plain classes combined through templates, with
+// no virtual interface; the default one inlines to the parity test and 1 + i % numSites.
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Sites holding each variable, indexed by variable (entry 0 unused), each list in ascending order
+typedef std::vector<std::vector<int>> ReplicaLists;
+
+// Copies at consecutive sites starting from site 1 + i % numSites
+class ModuloPlacement
+{
+public:
+    ModuloPlacement(int numSites, int copies = 1) : numSites(numSites), copies(std::min(copies, numSites)) {}
+
+    void place(int variableIndex, std::vector<int> &siteIds) const
+    {
+        for (int k = 0; k < copies; ++k)
+        {
+            siteIds.push_back(1 + (variableIndex + k) % numSites);
+        }
+    }
+
+private:
+    int numSites; // Sites in the system
+    int copies;   // Copies of every variable
+};
+
+// A copy at every site
+class ReplicateAllPlacement
+{
+public:
+    explicit ReplicateAllPlacement(int numSites) : numSites(numSites) {}
+
+    void place(int, std::vector<int> &siteIds) const
+    {
+        for (int siteId = 1; siteId <= numSites; ++siteId)
+        {
+            siteIds.push_back(siteId);
+        }
+    }
+
+private:
+    int numSites; // Sites in the system
+};
+
+// Variables split into equal contiguous ranges, one per site; further copies at the next sites
+class RangePlacement
+{
+public:
+    RangePlacement(int numSites, int numVariables, int copies = 1)
+        : numSites(numSites), numVariables(numVariables), copies(std::min(copies, numSites)) {}
+
+    void place(int variableIndex, std::vector<int> &siteIds) const
+    {
+        int first = (variableIndex - 1) * numSites / numVariables;
+        for (int k = 0; k < copies; ++k)
+        {
+            siteIds.push_back(1 + (first + k) % numSites);
+        }
+    }
+
+private:
+    int numSites;     // Sites in the system
+    int numVariables; // Variables placed
+    int copies;       // Copies of every variable
+};
+
+// Sites own points on a hash ring; a variable goes to the owners of the next points clockwise from its
+// hash, so adding a site moves only the variables that fall just before its points
+class ConsistentHashPlacement
+{
+public:
+    ConsistentHashPlacement(int numSites, int copies = 1, int pointsPerSite = 16);
+
+    void place(int variableIndex, std::vector<int> &siteIds) const;
+
+private:
+    std::vector<std::pair<uint64_t, int>> ring; // Points sorted by hash, with the site owning each
+    int copies;                                 // Copies of every variable
+};
+
+// Even variables placed by one policy and odd ones by another
+template <class EvenPolicy, class OddPolicy>
+class ParityPlacement
+{
+public:
+    ParityPlacement(const EvenPolicy &even, const OddPolicy &odd) : even(even), odd(odd) {}
+
+    void place(int variableIndex, std::vector<int> &siteIds) const
+    {
+        if (variableIndex % 2 == 0)
+        {
+            even.place(variableIndex, siteIds);
+        }
+        else
+        {
+            odd.place(variableIndex, siteIds);
+        }
+    }
+
+private:
+    EvenPolicy even; // Policy for even variables
+    OddPolicy odd;   // Policy for odd variables
+};
+
+// The placement of the original design: even variables everywhere, odd ones at site 1 + i % numSites
+typedef ParityPlacement<ReplicateAllPlacement, ModuloPlacement> DefaultPlacement;
+
+// Returns the default placement for a system of numSites sites
+inline DefaultPlacement defaultPlacement(int numSites)
+{
+    return DefaultPlacement(ReplicateAllPlacement(numSites), ModuloPlacement(numSites));
+}
+
+// Runs a policy over variables 1..numVariables and returns their replica lists
+template <class Policy>
+ReplicaLists placeVariables(const Policy &policy, int numVariables)
+{
+    ReplicaLists replicas(numVariables + 1);
+    for (int variableIndex = 1; variableIndex <= numVariables; ++variableIndex)
+    {
+        std::vector<int> &siteIds = replicas[variableIndex];
+        policy.place(variableIndex, siteIds);
+        std::sort(siteIds.begin(), siteIds.end());
+        siteIds.erase(std::unique(siteIds.begin(), siteIds.end()), siteIds.end());
+    }
+    return replicas;
+}
+
+#endif // PLACEMENT_H
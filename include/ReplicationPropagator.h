@@ -0,0 +1,98 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:16:30
+ */
+
+// Background propagator for lazy (primary-copy) replication. Commits apply replicated writes
+// to one primary site and hand the remaining replicas to this class, which applies them on
+// its own thread in commit order and tracks, per site, how far the replica has caught up.
+#ifndef REPLICATION_PROPAGATOR_H
+#define REPLICATION_PROPAGATOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Site.h"
+
+// Lag and throughput metrics of the propagator
+struct ReplicationStats
+{
+    size_t recordsQueued;    // Writes handed to the propagator
+    size_t replicaApplies;   // Writes applied to a secondary replica
+    size_t replicaSkips;     // Writes dropped because the replica was down
+    double averageLagMicros; // Mean commit-to-apply delay per replica write
+    double maxLagMicros;     // Largest commit-to-apply delay seen
+};
+
+class ReplicationPropagator
+{
+public:
+    // Starts the propagation thread
+    ReplicationPropagator();
+
+    // Applies everything still queued, then stops the thread
+    ~ReplicationPropagator();
+
+    // Queues a committed write for the given secondary replicas; sites must outlive the propagator
+    void enqueue(const std::string &variableName, int value, long commitTime,
+                 const std::vector<Site *> &targets);
+
+    // Checks if a replica has applied every write visible to a snapshot at timestamp
+    bool isFresh(int siteId, long timestamp) const;
+
+    // Checks if a replica is only behind because writes are still in flight
+    bool isCatchingUp(int siteId) const;
+
+    // Returns the commit time up to which a replica is known to be complete
+    long getAppliedThrough(int siteId) const;
+
+    // Blocks until every queued write has been applied or skipped
+    void drain();
+
+    // Forgets the lag state of a site whose data was brought up to date another way
+    void resetSite(int siteId);
+
+    // Returns lag metrics collected so far
+    ReplicationStats getStats() const;
+
+private:
+    struct Record
+    {
+        std::string variableName;                      // Variable written
+        int value;                                     // Committed value
+        long commitTime;                               // Commit timestamp of the write
+        std::vector<Site *> targets;                   // Secondary replicas still to apply it
+        std::chrono::steady_clock::time_point queuedAt; // When the commit handed it over
+    };
+
+    struct SiteLag
+    {
+        size_t pending;      // Queued writes not yet applied to the site
+        long appliedThrough; // Every write committed at or before this time is applied
+        bool stale;          // A write was dropped while the site was down
+    };
+
+    mutable std::mutex queueMutex;        // Guards everything below
+    std::condition_variable workReady;    // Signals the worker that records arrived
+    std::condition_variable queueDrained; // Signals waiters that the queue is empty
+    std::deque<Record> queue;             // Records in commit order
+    std::map<int, SiteLag> lag;           // Per-site progress
+    bool applying;                        // Worker is applying a record outside the lock
+    bool idle;                            // Worker is blocked waiting for records
+    bool stopping;                        // Destructor asked the worker to finish
+    ReplicationStats stats;               // Metrics
+    double totalLagMicros;                // Sum of lags for the average
+    std::thread worker;                   // Propagation thread
+
+    // Worker loop applying records in commit order
+    void run();
+};
+
+#endif // REPLICATION_PROPAGATOR_H
@@ -0,0 +1,50 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:54:30
+ */
+
+// Dependency graph checked by serializable snapshot isolation at commit. A transaction gets a
+// dense slot number the first time it takes part in a dependency, and the edges leaving it are
+// a row of bits indexed by slot. Cycle detection is a depth-first search that keeps the visited
+// and on-stack sets as bitsets too, so each step is a few word-wide AND tests over rows instead
+// of string set lookups.
+#ifndef SERIALIZATION_GRAPH_H
+#define SERIALIZATION_GRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SerializationGraph
+{
+public:
+    // Creates an empty graph
+    SerializationGraph();
+
+    // Records that transaction from depends on transaction to
+    void addDependency(const std::string &from, const std::string &to);
+
+    // Drops the dependencies a transaction has, keeping those on it; used when it starts over
+    void clearDependencies(const std::string &transactionName);
+
+    // Checks if any cycle is reachable from the transaction
+    bool reachesCycle(const std::string &transactionName) const;
+
+    // Returns the number of transactions holding a slot
+    size_t getSlotCount() const;
+
+    // Returns the number of dependencies recorded
+    size_t getEdgeCount() const;
+
+private:
+    std::unordered_map<std::string, int> slots;    // Slot of each transaction in the graph
+    std::vector<std::vector<uint64_t>> successors; // Per slot, bit s set if it depends on slot s
+    size_t edges;                                  // Bits set over all rows
+
+    // Returns the slot of a transaction, assigning the next one if it has none
+    int slotOf(const std::string &transactionName);
+};
+
+#endif // SERIALIZATION_GRAPH_H
@@ -0,0 +1,86 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:33:20
+ */
+
+// Single-producer single-consumer ring of fixed-size site messages, placed in POSIX shared
+// memory so the coordinator and a site process can talk without copying through the kernel.
+// Producers fill slots in place and publish several at once; consumers read slots in place
+// and release them after use. An idle consumer sleeps on a futex until the next publish.
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Kinds of messages exchanged between the data manager and a site process
+enum class SiteMessageType : int32_t
+{
+    APPLY_WRITE, // Coordinator -> site: append a committed version
+    READ,        // Coordinator -> site: read the version visible at timestamp
+    READ_REPLY,  // Site -> coordinator: value and commit time of the version read
+    READ_FAILED, // Site -> coordinator: the variable could not be read
+    SHUTDOWN     // Coordinator -> site: exit cleanly
+};
+
+// One ring slot; plain data so it can live in shared memory
+struct SiteMessage
+{
+    SiteMessageType type; // Message kind
+    int32_t variableIndex; // Variable number, e.g. 2 for x2
+    int32_t value;         // Written or read value
+    int32_t reserved;      // Padding, keeps timestamp 8-byte aligned
+    int64_t timestamp;     // Commit time of a write, snapshot time of a read, commit time of a reply
+};
+
+class ShmRing
+{
+public:
+    static const uint32_t CAPACITY = 1024; // Slots, a power of two
+
+    // Initializes an empty ring; construct with placement new inside the shared mapping
+    ShmRing();
+
+    // Producer: returns the next free slot to fill in place, or null if the ring is full
+    SiteMessage *reserve();
+
+    // Producer: makes every reserved slot visible to the consumer and wakes it if asleep
+    void publish();
+
+    // Producer: number of reserved slots not yet published
+    uint32_t unpublished() const;
+
+    // Consumer: number of published messages not yet released
+    uint32_t available() const;
+
+    // Consumer: message at offset i among the available ones, read in place
+    const SiteMessage &peek(uint32_t i) const;
+
+    // Consumer: returns n slots to the producer
+    void release(uint32_t n);
+
+    // Consumer: waits until a message is available or timeoutMicros passes (negative waits forever)
+    bool waitForMessages(long timeoutMicros);
+
+    // Producer: waits until a slot is free or timeoutMicros passes
+    bool waitForSpace(long timeoutMicros);
+
+private:
+    alignas(64) std::atomic<uint64_t> head;      // Next slot the consumer reads
+    alignas(64) std::atomic<uint64_t> tail;      // End of published slots
+    uint64_t reservedTail;                       // End of reserved slots, producer only
+    alignas(64) std::atomic<uint32_t> wakeups;   // Futex word bumped on every wake-up
+    std::atomic<uint32_t> sleeping;              // Consumer or producer is parked on the futex
+    alignas(64) SiteMessage slots[CAPACITY];     // Message storage
+
+    // Parks on the futex unless ready() turns true; returns ready()
+    template <typename Ready>
+    bool park(Ready ready, long timeoutMicros);
+
+    // Wakes a parked peer
+    void wake();
+};
+
+#endif // SHM_RING_H
@@ -8,13 +8,19 @@
 // handles site failures and recovery, and maintains transaction consistency. Each site
 // stores a subset of database variables with their version history and tracks its
 // operational status (UP/DOWN/RECOVERING) to ensure data consistency during failures.
+// Reads go through a seqlock over each variable's latest versions and take no lock unless
+// they need an older version; everything that changes data still takes the site lock.
 #ifndef SITE_H
 #define SITE_H
 #include <string>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <ostream>
+#include <atomic>
 #include <unordered_set>
 #include "Variable.h"
+#include "Placement.h"
 
 enum class SiteStatus
 {
@@ -23,11 +29,47 @@ enum class SiteStatus
     RECOVERING  // Site is recovering from failure and has limited functionality
 };
 
+// A write a participant holds between voting to commit and learning the decision
+struct StagedWrite
+{
+    std::string variableName; // Variable to update
+    int value;                // Value to install
+};
+
+// Number of latest versions of each variable that readers can see without the site lock
+const int PUBLISHED_VERSIONS = VERSIONS_PER_BLOCK;
+
+// The latest versions of one variable, guarded by a sequence number instead of a lock. A writer,
+// holding the site lock, makes the sequence odd, updates the ring and makes it even again; a
+// reader copies what it needs and retries if the sequence was odd or moved meanwhile. The fields
+// are atomics so those racing copies are well defined; the entry never moves or is freed while
+// the site exists, so a reader can never follow a stale pointer.
+struct PublishedVersions
+{
+    std::atomic<unsigned> sequence;                      // Even when stable, odd during an update
+    std::atomic<int> count;                              // Versions held, 0 if the variable is not stored here
+    std::atomic<int> newest;                             // Ring position of the latest version
+    std::atomic<int> values[PUBLISHED_VERSIONS];         // Value of each version
+    std::atomic<long> commitTimes[PUBLISHED_VERSIONS];   // Commit time of each version
+};
+
+// Entries of a site's two-phase commit log
+enum class ParticipantState
+{
+    PREPARED,  // Voted to commit, waiting for the decision
+    COMMITTED, // Decision was commit
+    ABORTED    // Decision was abort
+};
+
 class Site
 {
 public:
-    // Creates a new database site with the specified ID and initializes its variables
-    Site(int id);
+    // Creates a new database site with the specified ID and initializes its variables under the
+    // default placement; numSites is the size of the system
+    Site(int id, int numSites = 10);
+
+    // Creates a site holding the variables that placement assigns to it
+    Site(int id, const ReplicaLists &placement);
     
     // Returns the unique identifier of this database site
     int getId() const;
@@ -41,6 +83,15 @@ public:
     // Reads the value of a variable at a specific timestamp, ensuring transaction consistency
     int readVariable(const std::string &variableName, long timestamp);
     
+    // Reads the version of a variable visible at timestamp, including its commit time
+    Version readVersion(const std::string &variableName, long timestamp);
+    
+    // Reads several variables at one timestamp while holding the site lock once
+    std::vector<int> readVariables(const std::vector<std::string> &variableNames, long timestamp);
+    
+    // Gathers snapshot values of variables by index into a contiguous buffer under one lock
+    void gatherSnapshot(const std::vector<int> &varIndices, long timestamp, int *out);
+    
     // Writes a new value to a variable with the given commit timestamp
     void writeVariable(const std::string &variableName, int value, long commitTime);
     
@@ -52,28 +103,129 @@ public:
     
     // Checks if this site maintains a copy of the specified variable
     bool hasVariable(const std::string &variableName) const;
+
+    // Checks if the copy of a variable is current: stored here, the site is not down, and it is
+    // not a replica that has missed writes since the latest recovery
+    bool isAvailable(const std::string &variableName) const;
+
+    // Installs a copy of a variable holding history (oldest first), e.g. a replica copied from another site
+    void addVariable(const std::string &variableName, const std::vector<Version> &history, bool replicated);
+
+    // Removes this site's copy of a variable
+    void removeVariable(const std::string &variableName);
+
+    // Marks the copy of a variable as one of several replicas or as the only copy
+    void setReplicated(const std::string &variableName, bool replicated);
+
+    // Returns the time from which the copy is known to hold every version, 0 for initial copies
+    long getCopyTime(const std::string &variableName) const;
     
     // Verifies if the variable has any committed writes since the given start time
     bool hasCommittedWrite(const std::string &variableName, long startTime) const;
     
-    // Outputs the current state of all variables at this site for debugging
-    void dump() const;
+    // Writes the current state of all variables at this site to a stream, for debugging
+    void dump(std::ostream &out) const;
     
     // Returns the history of site failures as pairs of failure start and end times
     const std::vector<std::pair<long, long>> &getFailureTimes() const;
 
+    // Checks if the replicated data missed during a failure was caught up afterwards
+    bool isFailureHealed(size_t failureIndex) const;
+
+    // Checks if a failure overlapped [fromTime, toTime]; failures healed by a catch-up count only
+    // if countHealed. A binary search, however long the failure history
+    bool wasDownDuring(long fromTime, long toTime, bool countHealed) const;
+
+    // Returns the latest commit time of every replicated variable stored here
+    std::map<std::string, long> getReplicatedCommitTimes();
+
+    // Copies, for each variable, the versions committed after the given time
+    std::map<std::string, std::vector<Version>> collectVersionTails(const std::map<std::string, long> &since);
+
+    // Installs caught-up version tails and makes the site fully readable in one step
+    size_t installCatchUp(const std::map<std::string, std::vector<Version>> &tails);
+
+    // Drops versions no protected timestamp (ascending) can read; returns how many were dropped
+    size_t pruneVersions(const std::vector<long> &protectedTimes);
+
+    // Returns the number of versions held for all variables at this site
+    size_t getVersionCount() const;
+
+    // Stores every variable's history compressed, sharing full blocks through interner, or uncompressed
+    void setCompression(bool enabled, BlockInterner *interner);
+
+    // Returns the bytes of version storage in memory at this site, counting shared blocks in full
+    size_t getVersionBytes() const;
+
+    // Spills version blocks no read at or after horizon needs to file until bytesWanted are
+    // spilled; returns the bytes spilled
+    size_t spillVersions(long horizon, std::shared_ptr<SpillFile> file, size_t bytesWanted);
+
+    // Returns the bytes of version storage at this site spilled to disk
+    size_t getSpilledBytes() const;
+
+    // Votes on a two-phase commit; stages the writes and logs PREPARED, or votes no if down
+    bool prepare(const std::string &transactionName, long commitTime, const std::vector<StagedWrite> &writes);
+
+    // Logs the decision for a prepared transaction and returns its staged writes with their commit time
+    std::vector<StagedWrite> decide(const std::string &transactionName, bool commit, long &commitTime);
+
+    // Returns transactions that voted to commit but never heard the decision
+    std::vector<std::string> getInDoubtTransactions() const;
+
+    // Returns the two-phase commit log, oldest entry first
+    const std::vector<std::pair<std::string, ParticipantState>> &getParticipantLog() const;
+
 private:
     int id;                     // Unique identifier for this site
-    SiteStatus status;          // Current operational status of the site
-    std::mutex siteMutex;       // Ensures thread-safe access to site data
+    std::atomic<SiteStatus> status; // Current operational status, also read by the replication thread
+    mutable std::mutex siteMutex;   // Ensures thread-safe access to site data
+    SlabPool versionSlab;       // Version blocks for every variable at this site; outlives variables
+    std::shared_ptr<SpillFile> spillFile; // Where cold version blocks were spilled; outlives variables
     std::map<std::string, Variable> variables;  // Storage for variables at this site
-    std::unordered_set<std::string> unavailableVariables;  // Variables marked inconsistent during recovery
+    unsigned recoveryEpoch;                // Recoveries so far
+    std::vector<unsigned> writeEpochs;     // Per variable index, recoveryEpoch when its copy was last made current
+    std::unique_ptr<PublishedVersions[]> published; // Latest versions per variable index, read without the lock
+    int publishedCount;                    // Entries in published, one past the highest variable index
+    std::unordered_set<std::string> replicatedVariables; // Variables with copies at other sites too
+    std::map<std::string, long> copyTimes; // Copies installed or promoted after startup -> when
+    BlockInterner *interner;               // Where compressed histories share blocks, null if uncompressed
+    
+    // Finds the published version visible at timestamp without locking; false if the ring does not
+    // reach back that far or the variable is not stored here, so the caller must take the lock
+    bool readPublished(int varIndex, long timestamp, Version &version) const;
+
+    // Reads the version visible at timestamp under the site lock; throws if the variable is not here
+    Version readLocked(const std::string &variableName, long timestamp);
+
+    // Appends a version to a variable's published ring; caller holds the site lock
+    void publish(int varIndex, int value, long commitTime);
+
+    // Refills a variable's published ring from its history, or empties it; caller holds the site lock
+    void republish(int varIndex);
+
+    // Records that a variable's copy is current as of the latest recovery; caller holds the site lock
+    void markCurrent(int varIndex);
     
-    // Sets up initial variables and their values when site is created
-    void initializeVariables();
+    // Sets up the variables placed here and their initial values when site is created
+    void initializeVariables(const ReplicaLists &placement);
+
+    // Refills the published rings of all variables; caller holds the site lock or is constructing
+    void republishAll();
     
     // Tracks periods of site failure for consistency checking
     std::vector<std::pair<long, long>> failureTimes;
+    std::vector<bool> healedFailures;  // Per failure, whether a catch-up filled the gap
+    std::vector<size_t> unhealedFailures; // Positions in failureTimes of failures not healed, ascending
+
+    // Two-phase commit participant state; survives failures like the rest of the site's storage
+    struct PreparedTransaction
+    {
+        long commitTime;                 // Commit time proposed by the coordinator
+        std::vector<StagedWrite> writes; // Writes to install on commit
+    };
+    std::map<std::string, PreparedTransaction> preparedTransactions;       // Undecided transactions
+    std::vector<std::pair<std::string, ParticipantState>> participantLog; // Prepare and decision records
 };
 
 #endif // SITE_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:34:10
+ */
+
+// Runs each site's data store in its own local process. Every process owns a request and a
+// reply ShmRing in a POSIX shared memory segment; the coordinator batches committed writes
+// into the request ring and reads versions with a request/reply round trip. The coordinator
+// keeps its Site objects as the sites' durable image, used to reseed a restarted process.
+#ifndef SITE_PROCESS_HOST_H
+#define SITE_PROCESS_HOST_H
+
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "ShmRing.h"
+#include "Site.h"
+
+// Counters for cross-process traffic
+struct SiteProcessStats
+{
+    size_t processesStarted; // Site processes spawned, including restarts after recovery
+    size_t messagesSent;     // Requests written into request rings
+    size_t batchesPublished; // Publishes of request rings, each covering one or more messages
+    size_t readRoundTrips;   // Read batches answered by a site process
+    double totalReadMicros;  // Time spent waiting for read replies
+};
+
+class SiteProcessHost
+{
+public:
+    // Prepares to host sites that hold the variables placement assigns them
+    explicit SiteProcessHost(const ReplicaLists &placement);
+
+    // Shuts down every running site process
+    ~SiteProcessHost();
+
+    // Spawns the process of a site and seeds it with every version the site holds
+    void start(Site &site);
+
+    // Kills the process of a site
+    void stop(int siteId);
+
+    // Checks if the process of a site is alive
+    bool isRunning(int siteId);
+
+    // Queues a committed write for a site; it is sent on the next flush or read
+    void queueWrite(int siteId, int variableIndex, int value, long commitTime);
+
+    // Publishes every queued write
+    void flush();
+
+    // Reads the versions of variables visible at timestamp in one round trip; throws on failure
+    std::vector<Version> readVersions(int siteId, const std::vector<int> &variableIndices, long timestamp);
+
+    // Returns traffic counters
+    const SiteProcessStats &getStats() const;
+
+    // Returns the number of live site processes
+    size_t getRunningCount() const;
+
+private:
+    struct Channel
+    {
+        pid_t pid;         // Site process
+        void *mapping;     // Shared segment holding both rings
+        ShmRing *requests; // Coordinator -> site
+        ShmRing *replies;  // Site -> coordinator
+    };
+
+    ReplicaLists placement;           // Sites holding each variable, needed to build sites in children
+    std::map<int, Channel> channels;  // Running site processes by site ID
+    SiteProcessStats stats;           // Traffic counters
+
+    // Reserves a request slot, publishing and waiting while the ring is full
+    SiteMessage *reserveRequest(int siteId, Channel &channel);
+
+    // Publishes a site's request ring if anything is queued
+    void publish(Channel &channel);
+
+    // Reaps the process and unmaps the segment
+    void release(Channel &channel);
+
+    // Main loop of a site process; never returns
+    static void serve(int siteId, const ReplicaLists &placement, ShmRing *requests, ShmRing *replies);
+};
+
+#endif // SITE_PROCESS_HOST_H
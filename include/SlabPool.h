@@ -0,0 +1,108 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:14:35
+ */
+
+// Fixed-size slab allocator. Chunks are carved out of pages that double in size up to a cap
+// and are recycled through a free list, so steady-state allocation never reaches the global
+// heap. Used for transaction objects in TransactionManager and for version blocks at each Site.
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+class SlabPool
+{
+public:
+    // Largest number of chunks carved from a single page
+    static const size_t MAX_PAGE_CHUNKS = 4096;
+
+    // Creates a pool handing out chunks of chunkSize bytes, starting with chunksPerPage per page
+    SlabPool(size_t chunkSize, size_t chunksPerPage = 16);
+
+    // Returns all pages to the heap
+    ~SlabPool();
+
+    // Returns one chunk, reusing a freed chunk when possible
+    void *allocate();
+
+    // Puts a chunk back on the free list
+    void deallocate(void *chunk);
+
+    // Returns the size of each chunk in bytes
+    size_t getChunkSize() const;
+
+    // Returns the number of chunks currently handed out
+    size_t getLiveChunks() const;
+
+    // Returns the number of bytes reserved in pages
+    size_t getReservedBytes() const;
+
+private:
+    struct FreeChunk
+    {
+        FreeChunk *next; // Next chunk on the free list
+    };
+
+    size_t chunkSize;                 // Bytes per chunk, rounded up for alignment
+    size_t chunksPerPage;             // Chunks carved from the next page
+    FreeChunk *freeList;              // Recycled chunks
+    std::vector<unsigned char *> pages; // Pages owned by the pool
+    size_t liveChunks;                // Chunks currently in use
+    size_t reservedBytes;             // Bytes held in pages
+
+    // Allocates a new page and threads its chunks onto the free list
+    void grow();
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+};
+
+// STL allocator for single objects backed by a SlabPool; larger requests use the heap
+template <class T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    // Binds the allocator to a pool
+    explicit PoolAllocator(SlabPool &pool) : pool(&pool) {}
+
+    // Rebinding constructor used by allocate_shared
+    template <class U>
+    PoolAllocator(const PoolAllocator<U> &other) : pool(other.pool) {}
+
+    // Returns storage for n objects of type T
+    T *allocate(size_t n)
+    {
+        if (n == 1 && sizeof(T) <= pool->getChunkSize())
+        {
+            return static_cast<T *>(pool->allocate());
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    // Returns storage obtained from allocate
+    void deallocate(T *p, size_t n)
+    {
+        if (n == 1 && sizeof(T) <= pool->getChunkSize())
+        {
+            pool->deallocate(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    SlabPool *pool; // Pool the chunks come from
+};
+
+template <class T, class U>
+bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool == b.pool; }
+
+template <class T, class U>
+bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool != b.pool; }
+
+#endif // SLAB_POOL_H
@@ -0,0 +1,63 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:55:00
+ */
+
+// On-disk store of fixed-size segments, where cold version blocks go when memory runs short.
+// The file is created in TMPDIR (or /tmp) and unlinked at once, so it disappears with the
+// process. Segments are written and read at their offsets with pwrite and pread; the slot of a
+// segment read back is reused by the next write, so the file only grows while more is spilled.
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Traffic of a spill file
+struct SpillStats
+{
+    size_t segmentsWritten; // Segments spilled
+    size_t segmentsRead;    // Segments paged back in
+    size_t segmentsHeld;    // Segments on disk now
+    size_t fileBytes;       // Size of the file, including free slots
+};
+
+class SpillFile
+{
+public:
+    // Creates an empty file for segments of segmentBytes; throws runtime_error if it cannot
+    explicit SpillFile(size_t segmentBytes);
+
+    // Closes the file, dropping every segment
+    ~SpillFile();
+
+    // Writes one segment and returns its offset; throws runtime_error on a short write
+    long write(const void *segment);
+
+    // Reads the segment at offset back and frees its slot; throws runtime_error on a short read
+    void read(long offset, void *segment);
+
+    // Frees the slot of a segment that is no longer needed
+    void release(long offset);
+
+    // Returns the size of every segment
+    size_t getSegmentBytes() const;
+
+    // Returns the counters
+    SpillStats getStats() const;
+
+private:
+    int fd;                       // Unlinked file holding the segments
+    size_t segmentBytes;          // Size of every segment
+    long fileEnd;                 // Offset past the last slot ever used
+    std::vector<long> freeSlots;  // Slots of segments read back or released
+    SpillStats stats;             // Counters
+    mutable std::mutex fileMutex; // Sites spill and page in from their own threads
+
+    SpillFile(const SpillFile &) = delete;
+    SpillFile &operator=(const SpillFile &) = delete;
+};
+
+#endif // SPILL_FILE_H
@@ -0,0 +1,65 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:53:00
+ */
+
+// Stored procedures: transaction templates defined once and run with one command. The body of
+// a DEFINE block is compiled into a list of operations whose arguments are either literals,
+// already converted and checked, or references to a parameter. A CALL checks and converts each
+// argument once and runs the operations straight against the TransactionManager, with no
+// further parsing.
+#ifndef STORED_PROCEDURE_H
+#define STORED_PROCEDURE_H
+
+#include <string>
+#include <vector>
+
+// Operation of a procedure body
+enum class ProcedureStep
+{
+    BEGIN,     // begin(T)
+    BEGIN_RO,  // beginRO(T)
+    READ,      // R(T, x)
+    WRITE,     // W(T, x, v)
+    INCREMENT, // INC(T, x, d)
+    END        // end(T)
+};
+
+// An argument of an operation: a literal or a parameter of the procedure
+struct ProcedureOperand
+{
+    int parameter;    // Index of the parameter, -1 for a literal
+    bool negated;     // Value operands only: -parameter
+    std::string text; // Literal transaction or variable name
+    int value;        // Literal value
+};
+
+// One compiled operation
+struct ProcedureOperation
+{
+    ProcedureStep step;           // What to run
+    ProcedureOperand transaction; // Transaction it runs for
+    ProcedureOperand variable;    // Variable read or written, unused for begin and end
+    ProcedureOperand value;       // Value written or delta added, only for W and INC
+};
+
+// A compiled procedure
+struct StoredProcedure
+{
+    std::string name;                           // Name CALL refers to
+    std::vector<std::string> parameters;        // Parameter names, in argument order
+    std::vector<bool> variableParameters;       // Parameters used as variable names
+    std::vector<bool> valueParameters;          // Parameters used as values, converted once per call
+    std::vector<ProcedureOperation> operations; // Body in order
+};
+
+// Counters of stored procedures
+struct ProcedureStats
+{
+    size_t calls;      // CALLs that ran
+    size_t operations; // Operations they ran
+    size_t rejected;   // CALLs refused for bad arguments or unknown procedures
+};
+
+#endif // STORED_PROCEDURE_H
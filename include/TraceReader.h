@@ -0,0 +1,80 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:52:30
+ */
+
+// Streams the commands of an input file. The file is mapped into memory and cut into chunks
+// at line boundaries; parser threads claim chunks in turn and parse them into Commands while
+// the caller executes the commands of earlier chunks. Parsed chunks are handed over in file
+// order through a bounded window, so parsing runs at most a few chunks ahead of execution and
+// memory stays flat however large the file is.
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CommandParser.h"
+
+// Ingestion counters
+struct TraceReaderStats
+{
+    size_t bytes;         // Size of the file
+    size_t chunks;        // Chunks the file was cut into
+    size_t commands;      // Commands handed out, blank lines and comments excluded
+    int parserThreads;    // Threads parsing chunks
+    double parseMicros;   // Time spent parsing, summed over parser threads
+    double stallMicros;   // Time the caller waited for a chunk to be parsed
+};
+
+class TraceReader
+{
+public:
+    // Maps a file and starts parsing it; parserThreads 0 means one per hardware thread.
+    // Throws runtime_error if the file cannot be opened or mapped
+    explicit TraceReader(const std::string &path, int parserThreads = 0, size_t chunkBytes = 1 << 20,
+                         size_t windowChunks = 8);
+
+    // Stops the parser threads and unmaps the file
+    ~TraceReader();
+
+    // Moves the next command in file order into command; false once the file is exhausted
+    bool next(Command &command);
+
+    // Returns the counters; parse time is complete once next has returned false
+    TraceReaderStats getStats() const;
+
+private:
+    struct Slot
+    {
+        std::vector<Command> commands; // Parsed commands of the chunk
+        bool ready;                    // Parsed and not yet taken
+    };
+
+    const char *data;                    // Mapped file, null if empty
+    size_t size;                         // Bytes mapped
+    std::vector<size_t> chunkStarts;     // Offset of each chunk, then the file size
+    std::vector<Slot> window;            // Chunk i is parsed into slot i % size
+    mutable std::mutex windowMutex;      // Guards the window, nextChunk, takenChunks, stopping, stats
+    std::condition_variable chunkReady;  // Signalled when a slot becomes ready
+    std::condition_variable slotFree;    // Signalled when the caller takes a chunk
+    size_t nextChunk;                    // Next chunk to be claimed by a parser
+    size_t takenChunks;                  // Chunks handed to the caller
+    bool stopping;                       // Set by the destructor
+    std::vector<Command> current;        // Chunk the caller is reading
+    size_t position;                     // Next command of current
+    TraceReaderStats stats;              // Counters
+    std::vector<std::thread> parsers;    // Parser threads
+
+    // Cuts the file into chunks of about chunkBytes that end at line boundaries
+    void splitChunks(size_t chunkBytes);
+
+    // Body of a parser thread
+    void parseLoop();
+};
+
+#endif // TRACE_READER_H
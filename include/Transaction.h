@@ -12,8 +12,11 @@
 #include <set>
 #include <map>
 #include <chrono>
+#include <cstdint>
 #include <unordered_set>
 #include <vector>
+#include <functional>
+#include "Arena.h"
 
 // Represents the lifecycle states of a transaction
 enum class TransactionStatus
@@ -23,6 +26,27 @@ enum class TransactionStatus
     ABORTED    // Rolled back due to conflict or error
 };
 
+// Why a transaction was aborted
+enum class AbortReason
+{
+    NONE,              // Not aborted
+    INVALID_OPERATION, // Bad variable name, or a write by a read-only transaction
+    NO_VALID_VERSION,  // No site holds a version the transaction may read
+    SITE_FAILURE,      // A site it wrote to failed before it committed
+    UNAVAILABLE,       // Write quorum or the copy an increment needs is down
+    WRITE_CONFLICT,    // Another transaction committed a write to the same variable first
+    READ_INVALIDATED,  // Optimistic validation found a variable it read overwritten
+    DEPENDENCY_CYCLE,  // Committing would close a cycle in the serialization graph
+    VOTE_REJECTED,     // A participant voted not to commit in two-phase commit
+    DEADLOCK           // Chosen as the victim of a lock deadlock
+};
+
+// Bookkeeping containers whose nodes live in the transaction's arena
+typedef std::set<std::string, std::less<std::string>, ArenaAllocator<std::string>> ReadSet;
+typedef std::map<std::string, int, std::less<std::string>, ArenaAllocator<std::pair<const std::string, int>>> WriteSet;
+typedef std::set<int, std::less<int>, ArenaAllocator<int>> SiteSet;
+typedef std::map<int, uint64_t, std::less<int>, ArenaAllocator<std::pair<const int, uint64_t>>> ReadVersionMap;
+
 class Transaction
 {
 public:
@@ -41,9 +65,27 @@ public:
     // Updates the transaction's current status
     void setStatus(TransactionStatus status);
 
+    // Records why the transaction is being aborted
+    void setAbortReason(AbortReason reason);
+
+    // Returns why the transaction was aborted, NONE unless it was
+    AbortReason getAbortReason() const;
+
+    // Records the value a single-variable read returned
+    void setLastRead(int value);
+
+    // Returns the value of the latest single-variable read
+    int getLastRead() const;
+
+    // Returns how many single-variable reads have returned a value
+    size_t getReadsReturned() const;
+
     // Returns the timestamp when this transaction started
     long getStartTime() const;
 
+    // Moves the snapshot of a read-only transaction back to an earlier time
+    void setStartTime(long time);
+
     // Sets the timestamp when this transaction committed
     void setCommitTime(long time);
 
@@ -53,11 +95,23 @@ public:
     // Records a write operation and its value for later commitment
     void addWriteVariable(const std::string &variableName, int value);
 
+    // Records the version of a variable seen by the first read of it (optimistic mode)
+    void addReadVersion(int varIndex, uint64_t version);
+
+    // Returns the versions seen per variable index
+    const ReadVersionMap &getReadVersions() const;
+
+    // Buffers a commutative increment, folded into a buffered write of the same variable if any
+    void addIncrement(const std::string &variableName, int delta);
+
+    // Returns the pending increments per variable
+    const WriteSet &getIncrementSet() const;
+
     // Returns the set of all variables read by this transaction
-    const std::set<std::string> &getReadSet() const;
+    const ReadSet &getReadSet() const;
 
     // Returns the map of variables and their values to be written
-    const std::map<std::string, int> &getWriteSet() const;
+    const WriteSet &getWriteSet() const;
 
     // Returns the timestamp when this transaction was committed
     long getCommitTime() const;
@@ -66,24 +120,26 @@ public:
     void addSitesWritten(const std::vector<int> &siteIds);
 
     // Returns the set of site IDs this transaction has written to
-    const std::unordered_set<int> &getSitesWrittenTo() const;
-
-    // Adds a dependency on another transaction for serialization ordering
-    void addDependency(const std::string &transactionName);
+    const SiteSet &getSitesWrittenTo() const;
 
-    // Returns the set of transactions this transaction depends on
-    const std::set<std::string> &getDependencies() const;
+    // Drops the read/write bookkeeping and releases its arena once the transaction has finished
+    void retire();
 
 private:
     std::string name;              // Unique identifier for the transaction
     bool readOnly;                 // Whether this is a read-only transaction
     TransactionStatus status;      // Current state of the transaction
+    AbortReason abortReason;       // Why it was aborted, if it was
+    int lastRead;                  // Value of the latest single-variable read
+    size_t readsReturned;          // Single-variable reads that returned a value
     long startTime;               // Transaction start timestamp for SSI
     long commitTime;              // When transaction was committed
-    std::set<std::string> dependencySet;  // Other transactions this one depends on
-    std::set<std::string> readSet;        // Variables read by this transaction
-    std::map<std::string, int> writeSet;  // Variables and values to be written
-    std::unordered_set<int> sitesWrittenTo; // Sites modified by this transaction
+    Arena arena;                          // Backing store for the bookkeeping below
+    ReadSet readSet;                      // Variables read by this transaction
+    WriteSet writeSet;                    // Variables and values to be written
+    WriteSet incrementSet;                // Variables and deltas applied to the latest value at commit
+    SiteSet sitesWrittenTo;               // Sites modified by this transaction
+    ReadVersionMap readVersions;          // Versions read, for commit-time validation
 };
 
 #endif // TRANSACTION_H
\ No newline at end of file
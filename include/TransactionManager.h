@@ -12,8 +12,50 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
 #include "Transaction.h"
 #include "DataManager.h"
+#include "Aggregate.h"
+#include "SlabPool.h"
+#include "CommitCoordinator.h"
+#include "LockManager.h"
+#include "OccTable.h"
+#include "SerializationGraph.h"
+#include "AdmissionScheduler.h"
+#include "CommandParser.h"
+#include <deque>
+#include <functional>
+#include <random>
+
+// Concurrency control used for read-write transactions
+enum class ConcurrencyMode
+{
+    SSI,        // Serializable snapshot isolation (default)
+    STRICT_2PL, // Strict two-phase locking with deadlock detection
+    OCC         // Optimistic: reads record versions, commits lock writes and validate reads
+};
+
+// Outcome counters across all transactions
+struct TransactionStats
+{
+    size_t committed; // Transactions committed, read-only included
+    size_t aborted;   // Transactions aborted for any reason
+    size_t lockWaits; // Operations that had to wait for a lock
+    size_t deadlocks; // Deadlocks broken by aborting a transaction
+    size_t validationFailures; // Optimistic commits whose reads were overwritten
+};
+
+// Counters of the automatic retry mode
+struct RetryStats
+{
+    size_t retries;           // Attempts started after an abort
+    size_t commits;           // Commits of transactions begun while retry was on
+    size_t commitsAfterRetry; // Of those, commits that needed at least one retry
+    size_t givenUp;           // Transactions dropped after their last allowed attempt
+    size_t backoffCommands;   // Commands waited in backoff, summed over retries
+};
 
 class TransactionManager
 {
@@ -24,8 +66,30 @@ public:
     // Processes and executes a database command
     void processCommand(const std::string &command);
 
-    // Creates a new transaction with specified properties
-    void beginTransaction(const std::string &transactionName, bool isReadOnly);
+    // Executes a command that was already parsed
+    void processCommand(const Command &command);
+
+    // Advances the command clock after an operation called directly rather than through processCommand
+    void advanceClock();
+
+    // Sends messages to a stream instead of standard output
+    void setOutput(std::ostream &stream);
+
+    // Returns the stream messages go to
+    std::ostream &getOutput() const;
+
+    // Returns the transaction with the given name, finished or not, or null if there is none
+    std::shared_ptr<const Transaction> getTransaction(const std::string &transactionName) const;
+
+    // Checks if a transaction's operations are queued: behind a lock, for admission or for its next attempt
+    bool isWaiting(const std::string &transactionName) const;
+
+    // Creates a new transaction; accessSet optionally declares the variables it will use for admission
+    void beginTransaction(const std::string &transactionName, bool isReadOnly,
+                          const std::vector<std::string> &accessSet = std::vector<std::string>());
+
+    // Starts a read-only transaction reading as of a snapshot name, a committed transaction or a timestamp
+    void beginAsOf(const std::string &transactionName, const std::string &asOf);
 
     // Executes a read operation for the specified transaction
     void read(const std::string &transactionName, const std::string &variableName);
@@ -33,9 +97,25 @@ public:
     // Records a write operation for the transaction
     void write(const std::string &transactionName, const std::string &variableName, int value);
 
+    // Records a commutative increment, applied to the latest committed value at commit
+    void increment(const std::string &transactionName, const std::string &variableName, int delta);
+
+    // Executes several reads for one transaction and reports them as one block
+    void readBatch(const std::string &transactionName, const std::vector<std::string> &variableNames);
+
+    // Records several buffered writes for one transaction
+    void writeBatch(const std::string &transactionName, const std::vector<std::pair<std::string, int>> &writes);
+
+    // Runs a scan or aggregate over variables as of the transaction's snapshot
+    void aggregate(const std::string &transactionName, AggregateOp op, const std::vector<std::string> &variableNames,
+                   ScanPredicate predicate = ScanPredicate::ALL, int operand = 0);
+
     // Attempts to commit or abort the specified transaction
     void endTransaction(const std::string &transactionName);
 
+    // Ends several transactions as one commit group
+    void endTransactions(const std::vector<std::string> &transactionNames);
+
     // Displays current state of all database sites
     void dump() const;
 
@@ -45,23 +125,243 @@ public:
     // Recovers a failed site and processes pending operations
     void recoverSite(int siteId);
 
+    // Changes a runtime option such as "catchup"
+    void configure(const std::string &option, const std::string &value);
+
+    // Sets the read/write quorum of a replicated variable; 0, 0 restores write-all-available
+    void setQuorum(const std::string &variableName, int readQuorum, int writeQuorum);
+
+    // Registers a named snapshot of the current time; retention keeps the versions it reads
+    void takeSnapshot(const std::string &snapshotName);
+
+    // Unregisters a named snapshot so the versions only it needed can be pruned
+    void releaseSnapshot(const std::string &snapshotName);
+
+    // Applies the version retention policy now and reports what was dropped
+    void pruneVersions();
+
+    // Adds a replica of a variable at a site, copying its history
+    void addReplica(const std::string &variableName, int siteId);
+
+    // Drops a site's replica of a variable
+    void dropReplica(const std::string &variableName, int siteId);
+
+    // Applies the adaptive placement policy now and reports the replicas it moved
+    void rebalance();
+
+    // Subscribes a named consumer to the change feed; with drop set it is dropped instead of skipping ahead
+    void subscribe(const std::string &subscriberName, bool drop);
+
+    // Prints the changes a subscriber has not seen yet
+    void pollChanges(const std::string &subscriberName);
+
+    // Ends a subscription to the change feed
+    void unsubscribe(const std::string &subscriberName);
+
+    // Starts a DEFINE block; input lines up to END become the body of the procedure
+    void beginDefinition(const std::string &procedureName, const std::vector<std::string> &parameters);
+
+    // Ends a DEFINE block, compiling and registering the procedure
+    void endDefinition();
+
+    // Runs a stored procedure with the given arguments
+    void callProcedure(const std::string &procedureName, const std::vector<std::string> &arguments);
+
+    // Prints metrics collected across the system
+    void printStats() const;
+
+    // Returns commit, abort and locking counters
+    const TransactionStats &getTransactionStats() const;
+
+    // Returns counters of the automatic retry mode
+    const RetryStats &getRetryStats() const;
+
 private:
+    SlabPool transactionPool;                                          // Storage for transactions and their control blocks
     std::map<std::string, std::shared_ptr<Transaction>> transactions;  // Active transactions in the system
     std::shared_ptr<DataManager> dataManager;                          // Interface to distributed data sites
     std::map<std::string, std::set<std::string>> readTable;           // Tracks which transactions read each variable
     std::map<std::string, std::set<std::string>> writeTable;          // Tracks which transactions wrote each variable
+    SerializationGraph dependencyGraph;                                // Dependencies checked for cycles at commit
+    std::unique_ptr<CommitCoordinator> commitCoordinator;              // Set while two-phase commit is on
+    ConcurrencyMode concurrencyMode;                                   // Protocol for read-write transactions
+    TransactionStats stats;                                            // Outcome counters
+    std::ostream *out;                                                 // Where messages go, standard output by default
+
+    // An operation of a transaction that is blocked on a lock, run once the lock is granted
+    struct PendingOperation
+    {
+        enum Kind
+        {
+            READ,
+            WRITE,
+            INCREMENT,
+            AGGREGATE,
+            END
+        } kind;
+        std::string variableName;               // Variable read or written
+        int value;                              // Value written, delta added or scan operand
+        std::vector<std::string> variableNames; // Variables an aggregate reads
+        AggregateOp op;                         // Operation of an aggregate
+        ScanPredicate predicate;                // Filter of a scan
+    };
+    LockManager lockManager;                                           // Lock tables of the 2PL mode
+    std::map<std::string, int> lockIds;                                // Lock table ID per transaction, in begin order
+    std::map<int, std::string> lockNames;                              // Transaction name per lock table ID
+    std::map<std::string, std::deque<PendingOperation>> pendingOperations; // Blocked operations per transaction
+    OccTable occTable;                                                 // Version words of the optimistic mode
+    std::map<std::string, std::vector<int>> occLockedWrites;           // Write sets locked between validation and install
+
+    // Operation log and schedule of a transaction begun while automatic retry is on
+    struct RetryState
+    {
+        bool readOnly;                          // Begun with beginRO
+        std::vector<std::function<void()>> log; // Operations issued so far, replayed by each attempt
+        int attempts;                           // Attempts started, the first one included
+        long dueAt;                             // Command count at which the next attempt starts, -1 while running
+    };
+    bool retryEnabled;                         // Re-execute aborted transactions
+    int retryLimit;                            // Attempts allowed per transaction
+    int retryBackoff;                          // Backoff ceiling of the first retry, in commands
+    long commandCount;                         // Commands processed, the clock backoff is measured on
+    bool replaying;                            // Set while an attempt replays its log
+    std::mt19937 retryRandom;                  // Jitter source, seeded for reproducible runs
+    std::map<std::string, RetryState> retries; // Transactions that may still be retried
+    RetryStats retryStats;                     // Retry counters
+
+    // A read-write transaction the admission scheduler has not let in yet
+    struct UnadmittedTransaction
+    {
+        std::vector<std::string> accessSet;            // Declared at begin, or predicted from the first operation
+        std::vector<std::function<void()>> operations; // Operations to run once admitted
+        bool held;                                     // Admission was refused at least once
+    };
+    std::unique_ptr<AdmissionScheduler> scheduler;             // Set while admission scheduling is on
+    std::map<std::string, UnadmittedTransaction> unadmitted;   // Transactions begun but not started
+    std::deque<std::string> admissionQueue;                    // Held transactions in arrival order
+
+    std::map<std::string, long> snapshots; // Registered snapshot timestamps by name
+    bool retentionEnabled;                 // Prune versions automatically as commits accumulate
+    size_t commitsAtLastPrune;             // Commit count when retention last ran
+    size_t commitsAtLastRebalance;         // Commit count when the placement policy last ran
+    size_t commitsAtLastBudgetCheck;       // Commit count when storage was last held to the memory budget
+
+    std::map<std::string, ChangeSubscriber> subscribers; // Named consumers of the change feed
+
+    std::map<std::string, StoredProcedure> procedures; // Compiled procedures by name
+    bool defining;                                     // Inside a DEFINE block
+    std::string definitionName;                        // Procedure the block defines
+    std::vector<std::string> definitionParameters;     // Its parameters
+    std::vector<std::string> definitionBody;           // Lines collected so far
+    ProcedureStats procedureStats;                     // Procedure counters
+
+    // Returns the active transaction with the given name, or null after printing why not
+    std::shared_ptr<Transaction> findActiveTransaction(const std::string &transactionName);
+
+    // Returns all sites that are currently up
+    std::vector<std::shared_ptr<Site>> getUpSites() const;
+
+    // Collects the sites a write to the variable goes to, given the currently up sites
+    std::vector<int> collectWriteSites(const std::string &variableName, const std::vector<std::shared_ptr<Site>> &upSites) const;
 
     // Validates transaction's operations and commits if valid
     void validateAndCommit(std::shared_ptr<Transaction> transaction);
 
-    // Rolls back a transaction's operations
-    void abortTransaction(std::shared_ptr<Transaction> transaction);
+    // Runs commit-time checks; true if the transaction's writes should be committed
+    bool validateForCommit(std::shared_ptr<Transaction> transaction, std::set<std::string> *groupWrites);
+
+    // Commits the writes of validated transactions, as one two-phase commit group when enabled
+    void commitValidated(const std::vector<std::shared_ptr<Transaction>> &group);
+
+    // Runs optimistic validation: locks the write set in order and checks the read versions
+    bool validateOptimistic(std::shared_ptr<Transaction> transaction, std::set<std::string> *groupWrites);
+
+    // Installs or unlocks the version words an optimistic transaction locked at validation
+    void releaseOccWrites(const std::shared_ptr<Transaction> &transaction, bool committed);
+
+    // Passes an operation through retry logging and admission; true if it must not run now
+    bool interceptOperation(const std::string &transactionName, const std::vector<std::string> &variables,
+                            const std::function<void()> &operation);
+
+    // Queues an operation of a transaction that is not admitted, trying to admit it; true if queued
+    bool holdOperation(const std::string &transactionName, const std::vector<std::string> &variables,
+                       const std::function<void()> &operation);
+
+    // Asks the scheduler to admit a transaction and starts it if admitted
+    bool tryAdmission(const std::string &transactionName);
+
+    // Retries held transactions in arrival order until none more can be admitted
+    void admitHeldTransactions();
+
+    // Reports a finished read-write transaction and the variables it used to the scheduler
+    void finishAdmission(const std::shared_ptr<Transaction> &transaction, bool committed,
+                         const std::vector<std::string> &variables);
+
+    // Appends an operation to a retried transaction's log; true if it must wait for the next attempt
+    bool logOperation(const std::string &transactionName, const std::function<void()> &operation);
+
+    // Schedules the next attempt of an aborted transaction after a jittered exponential backoff
+    void scheduleRetry(const std::shared_ptr<Transaction> &transaction);
+
+    // Stops tracking a committed transaction for retry
+    void finishRetry(const std::shared_ptr<Transaction> &transaction);
+
+    // Starts the attempts whose backoff has elapsed by replaying their logs
+    void runDueRetries();
+
+    // Finds the time a beginAsOf argument names; false after printing why if it names none
+    bool resolveSnapshotTime(const std::string &transactionName, const std::string &asOf, long &timestamp) const;
+
+    // Returns the timestamps reads may still use: registered snapshots and active transactions
+    std::vector<long> getProtectedTimes() const;
+
+    // Prunes versions, protecting registered snapshots and the snapshots of active transactions
+    size_t applyRetention();
+
+    // Runs the placement policy and prints its moves; returns how many there were
+    size_t applyPlacement();
+
+    // Turns the increments of committing transactions into writes of the resulting values
+    void resolveIncrements(const std::vector<std::shared_ptr<Transaction>> &group);
+
+    // Rolls back a transaction's operations, recording why
+    void abortTransaction(std::shared_ptr<Transaction> transaction, AbortReason reason);
+
+    // Checks if a transaction runs under optimistic concurrency control
+    bool usesOcc(const std::shared_ptr<Transaction> &transaction) const;
+
+    // Adds a completed read to the transaction's read set and to the conflict tracking of its mode
+    void recordRead(const std::shared_ptr<Transaction> &transaction, const std::string &variableName);
+
+    // Returns the time reads of a transaction are served at: its start, or now for optimistic ones
+    long readTimeOf(const std::shared_ptr<Transaction> &transaction) const;
+
+    // Checks if a transaction runs under strict two-phase locking
+    bool usesLocking(const std::shared_ptr<Transaction> &transaction) const;
+
+    // Reads variables as of timestamp and prints the aggregate over them; skips it if one cannot be read yet
+    void printAggregate(const std::shared_ptr<Transaction> &transaction, AggregateOp op,
+                        const std::vector<std::string> &variableNames, ScanPredicate predicate, int operand,
+                        long timestamp);
+
+    // Runs an operation under 2PL now, or queues it behind the transaction's blocked operations
+    void submitOperation(std::shared_ptr<Transaction> transaction, const PendingOperation &operation);
+
+    // Acquires the locks of an operation and runs it; false if it blocked and was queued
+    bool runLockedOperation(std::shared_ptr<Transaction> transaction, const PendingOperation &operation);
+
+    // Acquires a lock at each site in turn; returns the first site where the request waits, or -1
+    int acquireLocks(std::shared_ptr<Transaction> transaction, const std::vector<int> &siteIds,
+                     const std::string &variableName, Lock_type type);
+
+    // Aborts the youngest transaction of each wait-for cycle
+    void breakDeadlocks();
 
-    // Checks for dependency cycles in transaction graph
-    bool detectCycle(const std::string &transactionName);
+    // Releases a finished transaction's locks and resumes transactions that were granted one
+    void releaseLocks(const std::shared_ptr<Transaction> &transaction);
 
-    // Performs depth-first search for cycle detection
-    bool dfs(const std::string &transactionName, std::set<std::string> &visited, std::set<std::string> &recursionStack);
+    // Runs the queued operations of transactions whose lock requests were granted
+    void resumeTransactions(const std::vector<int> &lockIdsToResume);
 };
 
 #endif // TRANSACTION_MANAGER_H
\ No newline at end of file
@@ -9,8 +9,14 @@
 #ifndef VARIABLE_H
 #define VARIABLE_H
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "SlabPool.h"
+
+class CompressedHistory;
+class BlockInterner;
+class SpillFile;
 
 // Stores a single version of a variable's value and its commit timestamp
 struct Version {
@@ -18,13 +24,30 @@ struct Version {
     long commitTime; // When this version was committed
 };
 
+// Number of versions held by one slab-allocated block
+const int VERSIONS_PER_BLOCK = 8;
+
+// Fixed-size run of consecutive versions, stored column-wise
+struct VersionBlock {
+    int count;                              // Versions used in this block
+    long commitTimes[VERSIONS_PER_BLOCK];   // Commit times in ascending order
+    int values[VERSIONS_PER_BLOCK];         // Value committed at each time
+};
+
 class Variable {
 public:
     // Creates an uninitialized variable
     Variable();
 
-    // Creates a variable with initial value and name
-    Variable(const std::string& name, int initialValue);
+    // Creates a variable with initial value and name; version blocks come from slab if given
+    Variable(const std::string& name, int initialValue, SlabPool* slab = nullptr);
+
+    // Transfers the version history of another variable
+    Variable(Variable&& other);
+    Variable& operator=(Variable&& other);
+
+    // Returns version blocks to their slab
+    ~Variable();
 
     // Returns the variable's identifier
     std::string getName() const;
@@ -32,15 +55,76 @@ public:
     // Retrieves appropriate version value based on timestamp
     int readValue(long timestamp) const;
 
+    // Retrieves the version (value and commit time) visible at timestamp
+    Version readVersion(long timestamp) const;
+
     // Creates a new version with given value and commit time
     void writeValue(int value, long commitTime);
 
+    // Returns the most recently committed value
+    int getLatestValue() const;
+
+    // Returns the commit time of the most recent version
+    long getLatestCommitTime() const;
+
     // Checks if variable was modified after given timestamp
     bool wasModifiedAfter(long timestamp) const;
 
+    // Appends every version committed strictly after afterTime to out, oldest first
+    void collectVersionsAfter(long afterTime, std::vector<Version>& out) const;
+
+    // Returns the number of versions in the history
+    size_t getVersionCount() const;
+
+    // Drops versions not visible at any of the ascending keepTimes, except the latest; returns how many
+    size_t pruneVersions(const std::vector<long>& keepTimes);
+
+    // Moves the history into a compressed store sharing full blocks through interner, or back to slab blocks
+    void setCompressed(bool enabled, BlockInterner* interner = nullptr);
+
+    // Checks if the history is stored compressed
+    bool isCompressed() const;
+
+    // Returns the bytes the history takes in memory, counting blocks shared with replicas in full
+    size_t getVersionBytes() const;
+
+    // Writes blocks no read at or after horizon needs to file, oldest first, until bytesWanted
+    // are spilled; they are paged back in when read. Returns the bytes spilled
+    size_t spillColdBlocks(long horizon, SpillFile& file, size_t bytesWanted);
+
+    // Returns the bytes of history spilled to disk
+    size_t getSpilledBytes() const;
+
 private:
-    std::string name;             // Variable identifier
-    std::vector<Version> versions; // History of variable versions
+    std::string name;                   // Variable identifier
+    SlabPool* slab;                     // Source of version blocks, or null for the heap
+    mutable std::vector<VersionBlock*> blocks;  // History of variable versions, oldest block first; null if spilled
+    std::vector<long> blockStarts;      // First commit time of each block, searched instead of the blocks
+    std::unique_ptr<CompressedHistory> compressed; // Set while the history is stored compressed instead
+    mutable std::vector<long> spillOffsets; // Per block, offset in the spill file or -1; empty until a spill
+    SpillFile* spill;                   // Where spilled blocks are, null if none ever was
+    mutable size_t spilledBlocks;       // Blocks currently on disk
+
+    // Returns the position in the history of the version visible at timestamp, or -1 if none
+    long findVersion(long timestamp) const;
+
+    // Returns block b, paging it back in from the spill file if needed
+    const VersionBlock* residentBlock(size_t b) const;
+
+    // Pages every spilled block back in
+    void pageInAll();
+
+    // Returns a fresh, empty version block
+    VersionBlock* allocateBlock() const;
+
+    // Returns a block to its source
+    void freeBlock(VersionBlock* block) const;
+
+    // Returns every block to its source
+    void releaseBlocks();
+
+    Variable(const Variable&) = delete;
+    Variable& operator=(const Variable&) = delete;
 };
 
 #endif // VARIABLE_H
\ No newline at end of file
@@ -0,0 +1,47 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:49:30
+ */
+
+// Zigzag varint coding of signed numbers, shared by the compressed version store and the
+// change feed's file format. Small magnitudes of either sign take one byte, a full 64-bit
+// number at most ten.
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Longest encoding of one number
+const size_t MAX_VARINT_BYTES = 10;
+
+// Writes number as a zigzag varint into out (room for MAX_VARINT_BYTES); returns the bytes written
+inline size_t encodeVarint(long number, uint8_t *out)
+{
+    unsigned long zigzag = (static_cast<unsigned long>(number) << 1) ^ static_cast<unsigned long>(number >> 63);
+    size_t length = 0;
+    while (zigzag >= 0x80)
+    {
+        out[length++] = static_cast<uint8_t>(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(zigzag);
+    return length;
+}
+
+// Reads a zigzag varint and advances in past it
+inline long decodeVarint(const uint8_t *&in)
+{
+    unsigned long zigzag = 0;
+    int shift = 0;
+    while (*in & 0x80)
+    {
+        zigzag |= static_cast<unsigned long>(*in++ & 0x7f) << shift;
+        shift += 7;
+    }
+    zigzag |= static_cast<unsigned long>(*in++) << shift;
+    return static_cast<long>(zigzag >> 1) ^ -static_cast<long>(zigzag & 1);
+}
+
+#endif // VARINT_H
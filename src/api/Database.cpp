@@ -0,0 +1,237 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:53:30
+ */
+
+#include "Database.h"
+#include "DataManager.h"
+#include "TransactionManager.h"
+using namespace std;
+
+// Description: Builds the data and transaction managers
+// Input: numSites - number of sites
+// Output: None
+// Side Effects: Messages are discarded until setOutput is called
+Database::Database(int numSites)
+    : dataManager(make_shared<DataManager>(numSites)), transactionManager(new TransactionManager(dataManager)),
+      discarded(nullptr)
+{
+    transactionManager->setOutput(discarded);
+}
+
+// Description: Releases the managers
+// Input: None
+// Output: None
+// Side Effects: Stops background replication and site processes
+Database::~Database() {}
+
+// Description: Starts a read-write transaction
+// Input: transaction - name
+// Output: OperationResult - OK, WAITING if admission holds it, REJECTED if the name is in use
+// Side Effects: Creates the transaction, advances the command clock
+OperationResult Database::begin(const string &transaction)
+{
+    bool exists = transactionManager->getTransaction(transaction) || transactionManager->isWaiting(transaction);
+    transactionManager->beginTransaction(transaction, false);
+    transactionManager->advanceClock();
+    if (exists)
+    {
+        return OperationResult{OperationStatus::REJECTED, AbortReason::NONE};
+    }
+    return settle(transaction, true);
+}
+
+// Description: Starts a read-only transaction
+// Input: transaction - name
+// Output: OperationResult - OK, or REJECTED if the name is in use
+// Side Effects: Creates the transaction, advances the command clock
+OperationResult Database::beginReadOnly(const string &transaction)
+{
+    bool exists = transactionManager->getTransaction(transaction) || transactionManager->isWaiting(transaction);
+    transactionManager->beginTransaction(transaction, true);
+    transactionManager->advanceClock();
+    if (exists)
+    {
+        return OperationResult{OperationStatus::REJECTED, AbortReason::NONE};
+    }
+    return settle(transaction, true);
+}
+
+// Description: Reads a variable
+// Input: transaction - name, variable - index of the variable
+// Output: ReadResult - the value when OK; WAITING if the read is parked or queued
+// Side Effects: See TransactionManager::read; advances the command clock
+ReadResult Database::read(const string &transaction, int variable)
+{
+    bool wasActive = isActive(transaction);
+    auto before = transactionManager->getTransaction(transaction);
+    size_t readsBefore = before ? before->getReadsReturned() : 0;
+    transactionManager->read(transaction, "x" + to_string(variable));
+    transactionManager->advanceClock();
+
+    OperationResult settled = settle(transaction, wasActive);
+    ReadResult result{settled.status, settled.reason, 0};
+    if (result.status == OperationStatus::OK)
+    {
+        // A read that returned nothing was parked until a site holding the variable recovers
+        auto after = transactionManager->getTransaction(transaction);
+        if (after == before && after->getReadsReturned() > readsBefore)
+        {
+            result.value = after->getLastRead();
+        }
+        else
+        {
+            result.status = OperationStatus::WAITING;
+        }
+    }
+    return result;
+}
+
+// Description: Buffers a write
+// Input: transaction - name, variable - index of the variable, value - value written
+// Output: OperationResult
+// Side Effects: See TransactionManager::write; advances the command clock
+OperationResult Database::write(const string &transaction, int variable, int value)
+{
+    bool wasActive = isActive(transaction);
+    transactionManager->write(transaction, "x" + to_string(variable), value);
+    transactionManager->advanceClock();
+    return settle(transaction, wasActive);
+}
+
+// Description: Ends a transaction
+// Input: transaction - name
+// Output: CommitResult - committed, or the status and abort reason saying why not
+// Side Effects: See TransactionManager::endTransaction; advances the command clock
+CommitResult Database::commit(const string &transaction)
+{
+    bool wasActive = isActive(transaction);
+    transactionManager->endTransaction(transaction);
+    transactionManager->advanceClock();
+    auto finished = transactionManager->getTransaction(transaction);
+    if (wasActive && finished && finished->getStatus() == TransactionStatus::COMMITTED)
+    {
+        return CommitResult{true, OperationStatus::OK, AbortReason::NONE};
+    }
+    OperationResult settled = settle(transaction, wasActive);
+    if (settled.status == OperationStatus::OK)
+    {
+        // Still active: the commit is queued behind a lock
+        settled.status = OperationStatus::WAITING;
+    }
+    return CommitResult{false, settled.status, settled.reason};
+}
+
+// Description: Fails a site
+// Input: siteId
+// Output: None
+// Side Effects: See TransactionManager::failSite; advances the command clock
+void Database::failSite(int siteId)
+{
+    transactionManager->failSite(siteId);
+    transactionManager->advanceClock();
+}
+
+// Description: Recovers a site
+// Input: siteId
+// Output: None
+// Side Effects: See TransactionManager::recoverSite; advances the command clock
+void Database::recoverSite(int siteId)
+{
+    transactionManager->recoverSite(siteId);
+    transactionManager->advanceClock();
+}
+
+// Description: Changes a runtime option
+// Input: option, value - as in config(option, value)
+// Output: None
+// Side Effects: See TransactionManager::configure
+void Database::configure(const string &option, const string &value)
+{
+    transactionManager->configure(option, value);
+    transactionManager->advanceClock();
+}
+
+// Description: Writes the state of every site
+// Input: None
+// Output: None
+// Side Effects: Writes to the output stream, if one is set
+void Database::dump()
+{
+    transactionManager->dump();
+    transactionManager->advanceClock();
+}
+
+// Description: Runs a parsed command
+// Input: command
+// Output: None
+// Side Effects: See TransactionManager::processCommand
+void Database::execute(const Command &command)
+{
+    transactionManager->processCommand(command);
+}
+
+// Description: Parses and runs a line of command text
+// Input: line
+// Output: None
+// Side Effects: See TransactionManager::processCommand
+void Database::execute(const string &line)
+{
+    transactionManager->processCommand(line);
+}
+
+// Description: Chooses where messages go
+// Input: stream - output stream, or null to discard messages
+// Output: None
+// Side Effects: Redirects the messages of every component
+void Database::setOutput(ostream *stream)
+{
+    transactionManager->setOutput(stream ? *stream : discarded);
+}
+
+// Description: Returns the transaction manager
+// Input: None
+// Output: TransactionManager&
+// Side Effects: None
+TransactionManager &Database::getTransactionManager()
+{
+    return *transactionManager;
+}
+
+// Description: Classifies what became of an operation from the transaction's state afterwards
+// Input: transaction - name, wasActive - whether it was active when the operation was issued
+// Output: OperationResult - ABORTED with the reason if it aborted, WAITING if its operations are
+//         queued, REJECTED if it was not active to begin with, OK otherwise
+// Side Effects: None
+OperationResult Database::settle(const string &transaction, bool wasActive) const
+{
+    auto current = transactionManager->getTransaction(transaction);
+    if (wasActive && current && current->getStatus() == TransactionStatus::ABORTED)
+    {
+        return OperationResult{OperationStatus::ABORTED, current->getAbortReason()};
+    }
+    if (transactionManager->isWaiting(transaction))
+    {
+        return OperationResult{OperationStatus::WAITING, AbortReason::NONE};
+    }
+    if (!wasActive)
+    {
+        return OperationResult{OperationStatus::REJECTED, AbortReason::NONE};
+    }
+    return OperationResult{OperationStatus::OK, AbortReason::NONE};
+}
+
+// Description: Checks if a transaction is active
+// Input: transaction - name
+// Output: bool - true if it exists and is active, or is waiting for admission
+// Side Effects: None
+bool Database::isActive(const string &transaction) const
+{
+    auto current = transactionManager->getTransaction(transaction);
+    if (current)
+    {
+        return current->getStatus() == TransactionStatus::ACTIVE;
+    }
+    return transactionManager->isWaiting(transaction);
+}
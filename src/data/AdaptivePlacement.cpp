@@ -0,0 +1,198 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:51:00
+ */
+
+#include "AdaptivePlacement.h"
+#include <algorithm>
+using namespace std;
+
+// Description: Creates a heatmap with every count at zero
+// Input: numVariables, numSites
+// Output: None
+// Side Effects: None
+AccessHeatmap::AccessHeatmap(int numVariables, int numSites)
+    : variables(numVariables + 1, AccessCounts{0, 0}), sites(numSites + 1, AccessCounts{0, 0})
+{
+}
+
+// Description: Counts a read
+// Input: variableIndex, siteId - site that served it
+// Output: None
+// Side Effects: Updates the variable's and the site's counts
+void AccessHeatmap::recordRead(int variableIndex, int siteId)
+{
+    ++variables[variableIndex].reads;
+    ++sites[siteId].reads;
+}
+
+// Description: Counts a committed write of a variable, once however many copies apply it
+// Input: variableIndex
+// Output: None
+// Side Effects: Updates the variable's counts
+void AccessHeatmap::recordWrite(int variableIndex)
+{
+    ++variables[variableIndex].writes;
+}
+
+// Description: Counts one copy of a write applied at a site
+// Input: siteId
+// Output: None
+// Side Effects: Updates the site's counts
+void AccessHeatmap::recordSiteWrite(int siteId)
+{
+    ++sites[siteId].writes;
+}
+
+// Description: Returns the counts of a variable
+// Input: variableIndex
+// Output: AccessCounts
+// Side Effects: None
+const AccessCounts &AccessHeatmap::getVariable(int variableIndex) const
+{
+    return variables[variableIndex];
+}
+
+// Description: Returns the counts of a site
+// Input: siteId
+// Output: AccessCounts
+// Side Effects: None
+const AccessCounts &AccessHeatmap::getSite(int siteId) const
+{
+    return sites[siteId];
+}
+
+// Description: Returns the number of sites counted
+// Input: None
+// Output: int
+// Side Effects: None
+int AccessHeatmap::getSiteCount() const
+{
+    return static_cast<int>(sites.size()) - 1;
+}
+
+// Description: Starts a new window in which older accesses weigh half
+// Input: None
+// Output: None
+// Side Effects: Halves every count
+void AccessHeatmap::decay()
+{
+    for (AccessCounts &counts : variables)
+    {
+        counts.reads /= 2;
+        counts.writes /= 2;
+    }
+    for (AccessCounts &counts : sites)
+    {
+        counts.reads /= 2;
+        counts.writes /= 2;
+    }
+}
+
+// Description: Creates a placement engine
+// Input: policy - thresholds
+// Output: None
+// Side Effects: None
+AdaptivePlacement::AdaptivePlacement(const PlacementPolicy &policy) : policy(policy)
+{
+}
+
+// Description: Decides which replicas to add and drop
+// Input: heatmap, replicas - holders of each variable by index, usableSites - by site ID
+// Output: Moves in the order they should be applied
+// Side Effects: None
+vector<PlacementMove> AdaptivePlacement::plan(const AccessHeatmap &heatmap, const vector<vector<int>> &replicas,
+                                              const vector<bool> &usableSites) const
+{
+    // Site load as the moves so far would leave it, so two hot variables do not pick the same site
+    int numSites = heatmap.getSiteCount();
+    vector<uint64_t> load(numSites + 1, 0);
+    for (int siteId = 1; siteId <= numSites; ++siteId)
+    {
+        load[siteId] = heatmap.getSite(siteId).reads + heatmap.getSite(siteId).writes;
+    }
+
+    vector<int> hot;
+    for (int v = 1; v < static_cast<int>(replicas.size()); ++v)
+    {
+        const AccessCounts &counts = heatmap.getVariable(v);
+        if (counts.reads >= policy.hotAccesses || counts.writes >= policy.hotAccesses)
+        {
+            hot.push_back(v);
+        }
+    }
+    stable_sort(hot.begin(), hot.end(), [&heatmap](int a, int b)
+    {
+        const AccessCounts &first = heatmap.getVariable(a);
+        const AccessCounts &second = heatmap.getVariable(b);
+        return first.reads + first.writes > second.reads + second.writes;
+    });
+
+    vector<PlacementMove> moves;
+    for (int v : hot)
+    {
+        const AccessCounts &counts = heatmap.getVariable(v);
+        const vector<int> &holders = replicas[v];
+        if (counts.reads >= policy.hotAccesses && counts.reads >= policy.dominance * counts.writes)
+        {
+            // Another copy takes its share of the reads off the present holders
+            int target = -1;
+            for (int siteId = 1; siteId <= numSites; ++siteId)
+            {
+                if (usableSites[siteId] && find(holders.begin(), holders.end(), siteId) == holders.end() &&
+                    (target < 0 || load[siteId] < load[target]))
+                {
+                    target = siteId;
+                }
+            }
+            if (target > 0)
+            {
+                load[target] += counts.reads / (holders.size() + 1);
+                moves.push_back(PlacementMove{v, target, true, counts.reads, counts.writes});
+            }
+        }
+        else if (counts.writes >= policy.hotAccesses && counts.writes >= policy.dominance * counts.reads &&
+                 static_cast<int>(holders.size()) > policy.minReplicas)
+        {
+            // Every copy applies every write, so the busiest holder gains the most
+            int target = -1;
+            int usableHolders = 0;
+            for (int siteId : holders)
+            {
+                if (usableSites[siteId])
+                {
+                    ++usableHolders;
+                    if (target < 0 || load[siteId] > load[target])
+                    {
+                        target = siteId;
+                    }
+                }
+            }
+            if (usableHolders > 1)
+            {
+                load[target] -= min(load[target], counts.writes);
+                moves.push_back(PlacementMove{v, target, false, counts.reads, counts.writes});
+            }
+        }
+    }
+    return moves;
+}
+
+// Description: Changes the thresholds
+// Input: policy
+// Output: None
+// Side Effects: Later plans use the new thresholds
+void AdaptivePlacement::setPolicy(const PlacementPolicy &policy)
+{
+    this->policy = policy;
+}
+
+// Description: Returns the thresholds
+// Input: None
+// Output: PlacementPolicy
+// Side Effects: None
+const PlacementPolicy &AdaptivePlacement::getPolicy() const
+{
+    return policy;
+}
@@ -0,0 +1,197 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:15:12
+ */
+
+#include "Aggregate.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+namespace
+{
+#if defined(__SSE2__)
+    // Description: Lane-wise select between two vectors (SSE2 has no blend instruction)
+    // Input: mask - all-ones lanes pick a, zero lanes pick b
+    // Output: __m128i - blended vector
+    // Side Effects: None
+    inline __m128i select(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    // Description: Extracts the four 32-bit lanes of a vector
+    // Input: v - vector to spill
+    // Output: lanes - array of four ints
+    // Side Effects: Writes lanes
+    inline void storeLanes(__m128i v, int lanes[4])
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v);
+    }
+#endif
+}
+
+// Description: Sums a buffer of values without overflowing 32-bit lanes
+// Input: values (int*), count (size_t)
+// Output: long long - sum of all values
+// Side Effects: None
+long long sumValues(const int *values, size_t count)
+{
+    size_t i = 0;
+    long long total = 0;
+#if defined(__SSE2__)
+    // Sign-extend each group of four ints into two 64-bit accumulators
+    __m128i accLow = _mm_setzero_si128();
+    __m128i accHigh = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), v);
+        accLow = _mm_add_epi64(accLow, _mm_unpacklo_epi32(v, sign));
+        accHigh = _mm_add_epi64(accHigh, _mm_unpackhi_epi32(v, sign));
+    }
+    long long lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), _mm_add_epi64(accLow, accHigh));
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < count; ++i)
+    {
+        total += values[i];
+    }
+    return total;
+}
+
+// Description: Finds the minimum of a buffer of values
+// Input: values (int*), count (size_t) - must be non-zero
+// Output: int - smallest value
+// Side Effects: None
+int minValue(const int *values, size_t count)
+{
+    size_t i = 0;
+    int result = values[0];
+#if defined(__SSE2__)
+    if (count >= 4)
+    {
+        __m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+        for (i = 4; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+            best = select(_mm_cmplt_epi32(v, best), v, best);
+        }
+        int lanes[4];
+        storeLanes(best, lanes);
+        result = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        result = min(result, values[i]);
+    }
+    return result;
+}
+
+// Description: Finds the maximum of a buffer of values
+// Input: values (int*), count (size_t) - must be non-zero
+// Output: int - largest value
+// Side Effects: None
+int maxValue(const int *values, size_t count)
+{
+    size_t i = 0;
+    int result = values[0];
+#if defined(__SSE2__)
+    if (count >= 4)
+    {
+        __m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+        for (i = 4; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+            best = select(_mm_cmpgt_epi32(v, best), v, best);
+        }
+        int lanes[4];
+        storeLanes(best, lanes);
+        result = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        result = max(result, values[i]);
+    }
+    return result;
+}
+
+// Description: Collects positions of values that satisfy a scan predicate
+// Input: values (int*), count (size_t), predicate, operand
+// Output: matches - positions appended in ascending order
+// Side Effects: Appends to matches
+void filterValues(const int *values, size_t count, ScanPredicate predicate, int operand, vector<uint32_t> &matches)
+{
+    size_t i = 0;
+    if (predicate == ScanPredicate::ALL)
+    {
+        for (; i < count; ++i)
+        {
+            matches.push_back(static_cast<uint32_t>(i));
+        }
+        return;
+    }
+#if defined(__SSE2__)
+    // Compare four values at a time and only visit lanes whose mask bit is set
+    __m128i rhs = _mm_set1_epi32(operand);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i mask;
+        if (predicate == ScanPredicate::LESS)
+        {
+            mask = _mm_cmplt_epi32(v, rhs);
+        }
+        else if (predicate == ScanPredicate::GREATER)
+        {
+            mask = _mm_cmpgt_epi32(v, rhs);
+        }
+        else
+        {
+            mask = _mm_cmpeq_epi32(v, rhs);
+        }
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(mask));
+        while (bits)
+        {
+            int lane = __builtin_ctz(bits);
+            matches.push_back(static_cast<uint32_t>(i + lane));
+            bits &= bits - 1;
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        bool keep = (predicate == ScanPredicate::LESS && values[i] < operand) ||
+                    (predicate == ScanPredicate::GREATER && values[i] > operand) ||
+                    (predicate == ScanPredicate::EQUAL && values[i] == operand);
+        if (keep)
+        {
+            matches.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Description: Returns the command name used for an aggregate operation
+// Input: op (AggregateOp)
+// Output: string - "SUM", "MIN", "MAX" or "SCAN"
+// Side Effects: None
+string aggregateName(AggregateOp op)
+{
+    switch (op)
+    {
+    case AggregateOp::SUM:
+        return "SUM";
+    case AggregateOp::MIN:
+        return "MIN";
+    case AggregateOp::MAX:
+        return "MAX";
+    default:
+        return "SCAN";
+    }
+}
@@ -0,0 +1,294 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:49:30
+ */
+
+#include "ChangeFeed.h"
+#include "Varint.h"
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+namespace
+{
+    // Start of every sink file: format name and version
+    const uint8_t SINK_MAGIC[] = {'R', 'C', 'D', 'C', 1};
+}
+
+// Description: Creates a feed with an empty ring
+// Input: capacity - records kept for subscribers, rounded up to a power of two
+// Output: None
+// Side Effects: Allocates the ring
+ChangeFeed::ChangeFeed(size_t capacity)
+    : mask(0), next(1), sink(nullptr), sinkLastTime(0), sinkLastSequence(0), stats{0, 0, 0}
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    slots.reset(new Slot[size]());
+    mask = size - 1;
+}
+
+// Description: Destroys the feed
+// Input: None
+// Output: None
+// Side Effects: Flushes and closes the file sink
+ChangeFeed::~ChangeFeed()
+{
+    closeSink();
+}
+
+// Description: Publishes one committed write to the ring and the sink
+// Input: transactionName, commitTime, variableIndex, value, siteMask - sites applying the write
+// Output: None
+// Side Effects: Overwrites the oldest record once the ring is full
+void ChangeFeed::publish(const string &transactionName, long commitTime, int variableIndex, int value,
+                         uint64_t siteMask)
+{
+    uint64_t sequence = next.load(memory_order_relaxed);
+    Slot &slot = slots[sequence & mask];
+    // An odd stamp tells readers the slot is changing under them
+    slot.stamp.store(2 * sequence - 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    ChangeRecord &record = slot.record;
+    record.sequence = sequence;
+    record.commitTime = commitTime;
+    record.variableIndex = variableIndex;
+    record.value = value;
+    record.siteMask = siteMask;
+    size_t length = transactionName.copy(record.transaction, CHANGE_NAME_LENGTH);
+    record.transaction[length] = '\0';
+    slot.stamp.store(2 * sequence, memory_order_release);
+    next.store(sequence + 1, memory_order_release);
+    ++stats.published;
+    if (sink)
+    {
+        writeToSink(record);
+    }
+}
+
+// Description: Starts appending records to a file
+// Input: path - file to append to
+// Output: bool - false if the file cannot be opened
+// Side Effects: Closes any previous sink; writes the format header into a new file
+bool ChangeFeed::openSink(const string &path)
+{
+    closeSink();
+    sink = fopen(path.c_str(), "ab");
+    if (!sink)
+    {
+        return false;
+    }
+    // Deltas in an appended file start over from zero
+    sinkLastTime = 0;
+    sinkLastSequence = 0;
+    fseek(sink, 0, SEEK_END);
+    if (ftell(sink) == 0)
+    {
+        fwrite(SINK_MAGIC, 1, sizeof(SINK_MAGIC), sink);
+        stats.sinkBytes += sizeof(SINK_MAGIC);
+    }
+    else
+    {
+        // A zero sequence delta marks where an appended run restarts its deltas
+        uint8_t marker = 0;
+        fwrite(&marker, 1, 1, sink);
+        stats.sinkBytes += 1;
+    }
+    return true;
+}
+
+// Description: Stops appending records to the file sink
+// Input: None
+// Output: None
+// Side Effects: Flushes buffered records and closes the file
+void ChangeFeed::closeSink()
+{
+    if (sink)
+    {
+        fclose(sink);
+        sink = nullptr;
+    }
+}
+
+// Description: Returns the ring size
+// Input: None
+// Output: size_t - records held
+// Side Effects: None
+size_t ChangeFeed::getCapacity() const
+{
+    return mask + 1;
+}
+
+// Description: Returns the sequence number of the next record
+// Input: None
+// Output: uint64_t
+// Side Effects: None
+uint64_t ChangeFeed::getNextSequence() const
+{
+    return next.load(memory_order_acquire);
+}
+
+// Description: Returns publishing counters
+// Input: None
+// Output: ChangeFeedStats
+// Side Effects: None
+ChangeFeedStats ChangeFeed::getStats() const
+{
+    return stats;
+}
+
+// Description: Appends one record to the sink as varint deltas from the previous record
+// Input: record
+// Output: None
+// Side Effects: Buffered write to the sink file
+void ChangeFeed::writeToSink(const ChangeRecord &record)
+{
+    // Sequence and time deltas, variable, value, sites, then the name with its length
+    uint8_t buffer[5 * MAX_VARINT_BYTES + 1 + CHANGE_NAME_LENGTH];
+    size_t length = encodeVarint(static_cast<long>(record.sequence - sinkLastSequence), buffer);
+    length += encodeVarint(record.commitTime - sinkLastTime, buffer + length);
+    length += encodeVarint(record.variableIndex, buffer + length);
+    length += encodeVarint(record.value, buffer + length);
+    length += encodeVarint(static_cast<long>(record.siteMask), buffer + length);
+    size_t nameLength = strlen(record.transaction);
+    buffer[length++] = static_cast<uint8_t>(nameLength);
+    memcpy(buffer + length, record.transaction, nameLength);
+    length += nameLength;
+    fwrite(buffer, 1, length, sink);
+    sinkLastSequence = record.sequence;
+    sinkLastTime = record.commitTime;
+    ++stats.sinkRecords;
+    stats.sinkBytes += length;
+}
+
+// Description: Decodes a file written by a sink
+// Input: path
+// Output: Records in file order; a record cut off at the end of the file is left out
+// Side Effects: Throws runtime_error if the file cannot be read or is not a change file
+vector<ChangeRecord> ChangeFeed::readFile(const string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throw runtime_error("Cannot open change file " + path);
+    }
+    vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        bytes.insert(bytes.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    if (bytes.size() < sizeof(SINK_MAGIC) || memcmp(bytes.data(), SINK_MAGIC, sizeof(SINK_MAGIC)) != 0)
+    {
+        throw runtime_error(path + " is not a change file");
+    }
+
+    // Padding keeps the decoder inside the buffer when the last record is cut off
+    size_t size = bytes.size();
+    bytes.resize(size + sizeof(ChangeRecord) + 5 * MAX_VARINT_BYTES, 0);
+    vector<ChangeRecord> records;
+    const uint8_t *in = bytes.data() + sizeof(SINK_MAGIC);
+    const uint8_t *end = bytes.data() + size;
+    uint64_t sequence = 0;
+    long commitTime = 0;
+    while (in < end)
+    {
+        long sequenceDelta = decodeVarint(in);
+        if (sequenceDelta == 0)
+        {
+            sequence = 0;
+            commitTime = 0;
+            continue;
+        }
+        ChangeRecord record;
+        record.sequence = sequence + sequenceDelta;
+        record.commitTime = commitTime + decodeVarint(in);
+        record.variableIndex = static_cast<int>(decodeVarint(in));
+        record.value = static_cast<int>(decodeVarint(in));
+        record.siteMask = static_cast<uint64_t>(decodeVarint(in));
+        size_t nameLength = *in++;
+        if (nameLength > CHANGE_NAME_LENGTH || in + nameLength > end)
+        {
+            break;
+        }
+        memcpy(record.transaction, in, nameLength);
+        record.transaction[nameLength] = '\0';
+        in += nameLength;
+        sequence = record.sequence;
+        commitTime = record.commitTime;
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Description: Subscribes to a feed from its next record on
+// Input: feed, policy - what to do when falling a full ring behind
+// Output: None
+// Side Effects: None
+ChangeSubscriber::ChangeSubscriber(const ChangeFeed &feed, LagPolicy policy)
+    : feed(&feed), policy(policy), cursor(feed.getNextSequence()), missed(0), dropped(false)
+{
+}
+
+// Description: Copies the records published since the last poll
+// Input: maxRecords - most records to deliver
+// Output: out - receives records oldest first; PollStatus
+// Side Effects: Advances the cursor; on lag skips ahead or drops the subscriber
+PollStatus ChangeSubscriber::poll(vector<ChangeRecord> &out, size_t maxRecords)
+{
+    if (dropped)
+    {
+        return PollStatus::DROPPED;
+    }
+    PollStatus status = PollStatus::OK;
+    uint64_t capacity = feed->getCapacity();
+    uint64_t head = feed->getNextSequence();
+    size_t delivered = 0;
+    while (cursor < head && delivered < maxRecords)
+    {
+        const ChangeFeed::Slot &slot = feed->slots[cursor & feed->mask];
+        bool overwritten = head - cursor > capacity;
+        ChangeRecord record;
+        if (!overwritten)
+        {
+            uint64_t stamp = slot.stamp.load(memory_order_acquire);
+            record = slot.record;
+            atomic_thread_fence(memory_order_acquire);
+            overwritten = stamp != 2 * cursor || slot.stamp.load(memory_order_relaxed) != stamp;
+        }
+        if (overwritten)
+        {
+            if (policy == LagPolicy::DROP)
+            {
+                dropped = true;
+                return PollStatus::DROPPED;
+            }
+            // Resume at the oldest record still held; if that is overwritten meanwhile, this repeats
+            head = feed->getNextSequence();
+            uint64_t oldest = head > capacity ? head - capacity : 1;
+            missed += oldest - cursor;
+            cursor = oldest;
+            status = PollStatus::LAGGED;
+            continue;
+        }
+        out.push_back(record);
+        ++cursor;
+        ++delivered;
+    }
+    return status;
+}
+
+// Description: Returns the number of records skipped by lagging
+// Input: None
+// Output: uint64_t
+// Side Effects: None
+uint64_t ChangeSubscriber::getMissed() const
+{
+    return missed;
+}
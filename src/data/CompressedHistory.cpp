@@ -0,0 +1,301 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:48:10
+ */
+
+#include "CompressedHistory.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+using namespace std;
+
+namespace
+{
+    // Most versions one block can hold: a delta takes at least one byte for time and one for value
+    const size_t MAX_BLOCK_VERSIONS = 1 + COMPRESSED_BLOCK_BYTES / 2;
+
+    // Description: Decodes every version of a block
+    // Input: block, out - room for MAX_BLOCK_VERSIONS versions
+    // Output: None
+    // Side Effects: Fills out with block.count versions, oldest first
+    void decodeBlock(const CompressedBlock &block, Version *out)
+    {
+        out[0] = Version{block.firstValue, block.firstTime};
+        const uint8_t *in = block.payload;
+        for (uint16_t i = 1; i < block.count; ++i)
+        {
+            long time = out[i - 1].commitTime + decodeVarint(in);
+            long value = out[i - 1].value + decodeVarint(in);
+            out[i] = Version{static_cast<int>(value), time};
+        }
+    }
+
+    // Description: Hashes the bytes that make up a block (FNV-1a)
+    // Input: block
+    // Output: uint64_t - hash of the header and the used payload
+    // Side Effects: None
+    uint64_t hashBlock(const CompressedBlock &block)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](const void *data, size_t size)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ULL;
+            }
+        };
+        mix(&block.firstTime, sizeof(block.firstTime));
+        mix(&block.firstValue, sizeof(block.firstValue));
+        mix(&block.count, sizeof(block.count));
+        mix(block.payload, block.used);
+        return hash;
+    }
+
+    // Description: Compares the contents of two blocks
+    // Input: a, b
+    // Output: bool - true if they hold the same versions
+    // Side Effects: None
+    bool sameBlock(const CompressedBlock &a, const CompressedBlock &b)
+    {
+        return a.firstTime == b.firstTime && a.firstValue == b.firstValue && a.count == b.count &&
+               a.used == b.used && memcmp(a.payload, b.payload, a.used) == 0;
+    }
+}
+
+// Description: Finds or stores a full block
+// Input: block - block that will not change again
+// Output: shared_ptr - an identical live block, or a new shared copy of this one
+// Side Effects: Registers new blocks; forgets blocks nobody holds any more
+shared_ptr<const CompressedBlock> BlockInterner::intern(const CompressedBlock &block)
+{
+    lock_guard<mutex> lock(internMutex);
+    vector<weak_ptr<const CompressedBlock>> &bucket = blocks[hashBlock(block)];
+    for (auto it = bucket.begin(); it != bucket.end();)
+    {
+        shared_ptr<const CompressedBlock> existing = it->lock();
+        if (!existing)
+        {
+            it = bucket.erase(it);
+            continue;
+        }
+        if (sameBlock(*existing, block))
+        {
+            return existing;
+        }
+        ++it;
+    }
+    shared_ptr<const CompressedBlock> stored = make_shared<CompressedBlock>(block);
+    bucket.push_back(stored);
+    return stored;
+}
+
+// Description: Measures how much interning shares
+// Input: None
+// Output: liveBlocks - distinct blocks still held, savedBytes - bytes of the extra references
+// Side Effects: None
+void BlockInterner::getUsage(size_t &liveBlocks, size_t &savedBytes) const
+{
+    lock_guard<mutex> lock(internMutex);
+    liveBlocks = 0;
+    savedBytes = 0;
+    for (const auto &bucket : blocks)
+    {
+        for (const auto &block : bucket.second)
+        {
+            long holders = block.use_count();
+            if (holders > 0)
+            {
+                ++liveBlocks;
+                savedBytes += (holders - 1) * sizeof(CompressedBlock);
+            }
+        }
+    }
+}
+
+// Description: Creates an empty compressed history
+// Input: interner - shared block store, or null to keep blocks private
+// Output: None
+// Side Effects: None
+CompressedHistory::CompressedHistory(BlockInterner *interner)
+    : interner(interner), lastTime(0), lastValue(0), versionCount(0)
+{
+    memset(&tail, 0, sizeof(tail));
+}
+
+// Description: Adds a version at the end of the history
+// Input: value, commitTime - not older than the latest version
+// Output: None
+// Side Effects: May seal the tail block and start a new one
+void CompressedHistory::append(int value, long commitTime)
+{
+    if (tail.count > 0)
+    {
+        uint8_t delta[2 * MAX_VARINT_BYTES];
+        size_t length = encodeVarint(commitTime - lastTime, delta);
+        length += encodeVarint(static_cast<long>(value) - lastValue, delta + length);
+        if (tail.used + length <= COMPRESSED_BLOCK_BYTES)
+        {
+            memcpy(tail.payload + tail.used, delta, length);
+            tail.used += static_cast<uint16_t>(length);
+            ++tail.count;
+            lastTime = commitTime;
+            lastValue = value;
+            ++versionCount;
+            return;
+        }
+        seal();
+    }
+    tail.firstTime = commitTime;
+    tail.firstValue = value;
+    tail.count = 1;
+    tail.used = 0;
+    lastTime = commitTime;
+    lastValue = value;
+    ++versionCount;
+}
+
+// Description: Looks up the version visible at a timestamp
+// Input: timestamp
+// Output: version - the newest version committed at or before timestamp; bool - false if none
+// Side Effects: None
+bool CompressedHistory::find(long timestamp, Version &version) const
+{
+    if (versionCount == 0)
+    {
+        return false;
+    }
+    if (lastTime <= timestamp)
+    {
+        version = Version{lastValue, lastTime};
+        return true;
+    }
+
+    // The headers decide which block answers; only that block is decoded
+    const CompressedBlock *block = &tail;
+    if (tail.firstTime > timestamp)
+    {
+        auto it = upper_bound(sealedStarts.begin(), sealedStarts.end(), timestamp);
+        if (it == sealedStarts.begin())
+        {
+            return false;
+        }
+        block = sealed[it - sealedStarts.begin() - 1].get();
+    }
+    Version versions[MAX_BLOCK_VERSIONS];
+    decodeBlock(*block, versions);
+    int index = block->count - 1;
+    while (versions[index].commitTime > timestamp)
+    {
+        --index;
+    }
+    version = versions[index];
+    return true;
+}
+
+// Description: Returns the newest version
+// Input: None
+// Output: Version
+// Side Effects: None
+Version CompressedHistory::latest() const
+{
+    return Version{lastValue, lastTime};
+}
+
+// Description: Copies the versions committed after a given time
+// Input: afterTime - versions at or before this time are skipped
+// Output: out - receives the newer versions in commit order
+// Side Effects: Appends to out
+void CompressedHistory::collectAfter(long afterTime, vector<Version> &out) const
+{
+    if (versionCount == 0 || lastTime <= afterTime)
+    {
+        return;
+    }
+    size_t first = upper_bound(sealedStarts.begin(), sealedStarts.end(), afterTime) - sealedStarts.begin();
+    first = first > 0 ? first - 1 : 0;
+    Version versions[MAX_BLOCK_VERSIONS];
+    for (size_t b = first; b <= sealed.size(); ++b)
+    {
+        const CompressedBlock &block = b < sealed.size() ? *sealed[b] : tail;
+        decodeBlock(block, versions);
+        for (uint16_t i = 0; i < block.count; ++i)
+        {
+            if (versions[i].commitTime > afterTime)
+            {
+                out.push_back(versions[i]);
+            }
+        }
+    }
+}
+
+// Description: Applies a retention policy to the history
+// Input: keepTimes - protected timestamps in ascending order
+// Output: size_t - number of versions dropped
+// Side Effects: Re-encodes the surviving versions; replicas pruned alike share blocks again
+size_t CompressedHistory::prune(const vector<long> &keepTimes)
+{
+    vector<Version> all;
+    collectAfter(numeric_limits<long>::min(), all);
+    vector<size_t> keep;
+    for (long time : keepTimes)
+    {
+        size_t visible = upper_bound(all.begin(), all.end(), time,
+                                     [](long t, const Version &version) { return t < version.commitTime; }) -
+                         all.begin();
+        if (visible > 0 && (keep.empty() || keep.back() != visible - 1))
+        {
+            keep.push_back(visible - 1);
+        }
+    }
+    if (!all.empty() && (keep.empty() || keep.back() != all.size() - 1))
+    {
+        keep.push_back(all.size() - 1);
+    }
+    if (keep.size() == all.size())
+    {
+        return 0;
+    }
+
+    sealed.clear();
+    sealedStarts.clear();
+    memset(&tail, 0, sizeof(tail));
+    versionCount = 0;
+    for (size_t position : keep)
+    {
+        append(all[position].value, all[position].commitTime);
+    }
+    return all.size() - keep.size();
+}
+
+// Description: Counts the stored versions
+// Input: None
+// Output: size_t
+// Side Effects: None
+size_t CompressedHistory::size() const
+{
+    return versionCount;
+}
+
+// Description: Estimates the memory held by the history
+// Input: None
+// Output: size_t - bytes of the blocks and the search index
+// Side Effects: None
+size_t CompressedHistory::getBytes() const
+{
+    return sizeof(CompressedHistory) + sealed.size() * sizeof(CompressedBlock) +
+           sealed.capacity() * sizeof(sealed[0]) + sealedStarts.capacity() * sizeof(long);
+}
+
+// Description: Moves the tail into the full blocks
+// Input: None
+// Output: None
+// Side Effects: Shares the block through the interner when there is one
+void CompressedHistory::seal()
+{
+    sealed.push_back(interner ? interner->intern(tail) : make_shared<CompressedBlock>(tail));
+    sealedStarts.push_back(tail.firstTime);
+    memset(&tail, 0, sizeof(tail));
+}
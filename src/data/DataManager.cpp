@@ -6,29 +6,64 @@
 
 #include "DataManager.h"
 #include <iostream>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
 using namespace std;
 
+namespace
+{
+    // Bit of a site in a change record's site mask; sites past 64 are not represented
+    uint64_t siteBit(int siteId)
+    {
+        return siteId >= 1 && siteId <= 64 ? uint64_t(1) << (siteId - 1) : 0;
+    }
+}
+
 // Description: Constructor that sets up the distributed database system
-// Input: None
+// Input: numSites (int) - number of sites, 10 by default
 // Output: None
-// Side Effects: Initializes all 10 database sites
-DataManager::DataManager()
+// Side Effects: Initializes all database sites
+DataManager::DataManager(int numSites)
+    : numSites(numSites), out(&cout), catchUpEnabled(false), pruneHorizon(0), retention{0, 0, 0}, compression(false),
+      replicaSites(placeVariables(defaultPlacement(numSites), 20)), heatmap(20, numSites), adaptivePlacement(false),
+      placementStats{0, 0, 0, 0}, memoryBudget(0), budgetSpills(0)
 {
     initializeSites();
 }
 
+// Description: Destructor, lets in-flight replication finish before sites are released
+// Input: None
+// Output: None
+// Side Effects: Drains and stops the propagator if lazy replication is on, stops site processes
+DataManager::~DataManager()
+{
+    propagator.reset();
+    siteProcesses.reset();
+}
+
 // Description: Creates the initial set of database sites
 // Input: None
 // Output: None
-// Side Effects: Creates 10 Site objects and stores them in sites map
+// Side Effects: Creates numSites Site objects holding the variables replicaSites places at them
 void DataManager::initializeSites()
 {
-    for (int i = 1; i <= 10; ++i)
+    for (int i = 1; i <= numSites; ++i)
     {
-        sites[i] = std::make_shared<Site>(i);
+        sites[i] = std::make_shared<Site>(i, replicaSites);
     }
 }
 
+// Description: Returns the number of sites in the system
+// Input: None
+// Output: int - site count
+// Side Effects: None
+int DataManager::getSiteCount() const
+{
+    return numSites;
+}
+
 // Description: Retrieves a specific site by its ID
 // Input: siteId (int)
 // Output: Shared pointer to Site object
@@ -79,52 +114,111 @@ void DataManager::commitTransaction(std::shared_ptr<Transaction> transaction)
     {
         const std::string &variableName = write.first;
         int value = write.second;
-        DataManager::write(transaction, variableName, value, transaction->getCommitTime());
+        int varIndex = stoi(variableName.substr(1));
+        heatmap.recordWrite(varIndex);
+        uint64_t siteMask = DataManager::write(transaction, variableName, value, transaction->getCommitTime());
+        if (changeFeed)
+        {
+            changeFeed->publish(transaction->getName(), transaction->getCommitTime(), varIndex, value, siteMask);
+        }
+    }
+    if (siteProcesses) {
+        // All writes of the commit reach each site process in one batch
+        siteProcesses->flush();
     }
 }
 
-// Description: Writes variable to either all sites or single site based on variable type
+// Description: Writes variable to every up copy, or as the quorum or lazy replication mode says
 // Input: transaction pointer, variableName, value, commitTime
-// Output: None
+// Output: uint64_t - bit i-1 set for each site i the write is applied or streamed to
 // Side Effects: Updates variable value across relevant sites
-void DataManager::write(std::shared_ptr<Transaction> transaction, const std::string &variableName, int value, long commitTime)
+uint64_t DataManager::write(std::shared_ptr<Transaction> transaction, const std::string &variableName, int value, long commitTime)
 {
     int varIndex = stoi(variableName.substr(1));
+    uint64_t siteMask = 0;
 
-    if (varIndex % 2 == 0)
-    { // Even variables - write to all up sites
-        for (auto &sitePair : sites)
+    if (hasQuorum(variableName))
+    { // Quorum-replicated variables - only W replicas need the write
+        siteMask = writeToQuorum(variableName, value, commitTime);
+    }
+    else if (isReplicated(variableName) && propagator)
+    { // Replicated variables, lazy mode - apply to the primary now, stream to the rest
+        Site *primary = nullptr;
+        vector<Site *> secondaries;
+        for (int siteId : replicaSites[varIndex])
+        {
+            Site *site = sites[siteId].get();
+            if (site->getStatus() == SiteStatus::UP)
+            {
+                if (!primary)
+                {
+                    primary = site;
+                }
+                else
+                {
+                    secondaries.push_back(site);
+                }
+            }
+        }
+        if (primary)
         {
-            auto site = sitePair.second;
-            if (site->getStatus() == SiteStatus::UP && site->hasVariable(variableName))
+            primary->writeVariable(variableName, value, commitTime);
+            propagator->enqueue(variableName, value, commitTime, secondaries);
+            heatmap.recordSiteWrite(primary->getId());
+            siteMask = siteBit(primary->getId());
+            for (Site *secondary : secondaries)
             {
-                site->writeVariable(variableName, value, commitTime);
+                heatmap.recordSiteWrite(secondary->getId());
+                siteMask |= siteBit(secondary->getId());
             }
         }
     }
     else
-    { // Odd variables - write to specific site
-        int siteId = 1 + (varIndex % 10);
-        auto site = sites[siteId];
-        if (site->getStatus() == SiteStatus::UP && site->hasVariable(variableName))
+    { // Every up copy - all replicas, or the site holding an unreplicated variable
+        for (int siteId : replicaSites[varIndex])
         {
-            site->writeVariable(variableName, value, commitTime);
+            auto site = sites[siteId];
+            if (site->getStatus() == SiteStatus::UP)
+            {
+                applyWrite(site.get(), variableName, value, commitTime);
+                siteMask |= siteBit(siteId);
+            }
         }
     }
+    return siteMask;
 }
 
 // Description: Outputs current state of all database sites
 // Input: None
 // Output: None
-// Side Effects: Prints state of all sites to console
+// Side Effects: Prints state of all sites
 void DataManager::dump()
 {
+    drainReplication();
     for (const auto &sitePair : sites)
     {
-        sitePair.second->dump();
+        sitePair.second->dump(*out);
     }
 }
 
+// Description: Redirects the messages of the data manager
+// Input: stream - where messages go from now on
+// Output: None
+// Side Effects: Later messages are written to stream
+void DataManager::setOutput(ostream &stream)
+{
+    out = &stream;
+}
+
+// Description: Returns the stream messages go to
+// Input: None
+// Output: ostream&
+// Side Effects: None
+ostream &DataManager::getOutput() const
+{
+    return *out;
+}
+
 // Description: Verifies if site has consistent history at given timestamp
 // Input: site pointer, timestamp
 // Output: Boolean indicating stability
@@ -135,14 +229,9 @@ bool DataManager::hasSiteStableHistory(std::shared_ptr<Site> site, long timestam
         return false;
     }
 
-    const auto& failureTimes = site->getFailureTimes();
-    for (const auto& ft : failureTimes) {
-        // Check if there was a failure between transaction start and current time
-        if (ft.first <= timestamp && (ft.second == -1 || ft.second > timestamp)) {
-            return false;
-        }
-    }
-    return true;
+    // A failure not caught up that covers timestamp means the site may lack versions visible at it
+    long after = timestamp < numeric_limits<long>::max() ? timestamp + 1 : timestamp;
+    return !site->wasDownDuring(after, timestamp, false);
 }
 
 // Description: Checks if site was continuously up during time period
@@ -151,103 +240,322 @@ bool DataManager::hasSiteStableHistory(std::shared_ptr<Site> site, long timestam
 // Side Effects: None
 bool DataManager::hasContinuousHistory(std::shared_ptr<Site> site, long fromTime, long toTime) const 
 {
-    const auto& failureTimes = site->getFailureTimes();
-    for (const auto& ft : failureTimes) {
-        // Check if any failure interval overlaps with [fromTime, toTime]
-        if (ft.first <= toTime && (ft.second == -1 || ft.second >= fromTime)) {
-            return false;
-        }
-    }
-    return true;
+    // Caught-up gaps don't count
+    return !site->wasDownDuring(fromTime, toTime, false);
 }
 
-// Description: Reads variable from appropriate site based on variable type
-// Input: transactionName, variableName, timestamp
-// Output: Integer value of variable
-// Side Effects: May add to waitingReads queue, throws exceptions
-int DataManager::read(const string& transactionName, const string& variableName, long timestamp) 
+// Description: Picks the site that should serve a read of a variable
+// Input: variableName, timestamp
+// Output: Site ID to read from, or -1 if the read has to wait for a replica
+// Side Effects: Throws exceptions if no valid copy of the variable exists
+int DataManager::selectReadSite(const string& variableName, long timestamp)
 {
     int varIndex = stoi(variableName.substr(1));
 
-    if (varIndex % 2 == 1) { // Odd variables
-        int siteId = 1 + (varIndex % 10);
+    if (!isReplicated(variableName)) { // The only copy
+        int siteId = replicaSites[varIndex].front();
         auto site = sites[siteId];
         if (site->getStatus() == SiteStatus::DOWN) {
             throw runtime_error("Site " + to_string(siteId) + " is down");
         }
-        return site->readVariable(variableName, timestamp);
-    }
-    else { // Even variables
-        // First find if there is any site that has a valid history of the variable
-        long lastWriteTime = -1;
-        bool foundValidVersion = false;
-        
-        for (auto& sitePair : sites) {
-            auto site = sitePair.second;
-            if (site->hasVariable(variableName) && 
-                hasContinuousHistory(site, lastWriteTime, timestamp)) {
-                foundValidVersion = true;
-                break;
+        return siteId;
+    }
+
+    // Replicated variables
+    // Read from an up site with valid version; lagging lazy replicas are skipped
+    bool foundValidVersion = false;
+    bool lagging = false;
+    int leastLoaded = -1;
+    for (int siteId : replicaSites[varIndex]) {
+        auto site = sites[siteId];
+        if (!isCopyComplete(site, variableName, timestamp)) {
+            continue;
+        }
+        foundValidVersion = true;
+        if (site->getStatus() != SiteStatus::UP) {
+            continue;
+        }
+        if (isReplicaFresh(siteId, timestamp)) {
+            if (!adaptivePlacement) {
+                return siteId;
             }
+            // Spread reads: the replica that served the fewest accesses lately takes this one
+            const AccessCounts& load = heatmap.getSite(siteId);
+            if (leastLoaded < 0 || load.reads + load.writes <
+                                   heatmap.getSite(leastLoaded).reads + heatmap.getSite(leastLoaded).writes) {
+                leastLoaded = siteId;
+            }
+            continue;
         }
+        lagging = lagging || propagator->isCatchingUp(siteId);
+    }
 
-        // If no site has valid version, abort immediately
-        if (!foundValidVersion) {
-            throw runtime_error("No valid version of " + variableName);
-        }
+    // If no site has valid version, abort immediately
+    if (!foundValidVersion) {
+        throw runtime_error("No valid version of " + variableName);
+    }
+    if (leastLoaded > 0) {
+        return leastLoaded;
+    }
 
-        // Try to read from an up site with valid version
-        for (auto& sitePair : sites) {
-            auto site = sitePair.second;
-            if (site->getStatus() == SiteStatus::UP &&
-                site->hasVariable(variableName) &&
-                hasContinuousHistory(site, lastWriteTime, timestamp)) {
-                try {
-                    return site->readVariable(variableName, timestamp);
-                } catch (...) {
-                    continue;
-                }
-            }
+    // Every usable replica is behind the snapshot but will catch up once in-flight writes land
+    if (lagging) {
+        propagator->drain();
+        return selectReadSite(variableName, timestamp);
+    }
+
+    // A valid version exists but can't be accessed right now
+    return -1;
+}
+
+// Description: Reads variable from appropriate site based on variable type
+// Input: transactionName, variableName, timestamp
+// Output: Integer value of variable
+// Side Effects: May add to waitingReads queue, throws exceptions
+int DataManager::read(const string& transactionName, const string& variableName, long timestamp) 
+{
+    if (hasQuorum(variableName)) {
+        int value;
+        if (readFromQuorum(variableName, timestamp, value)) {
+            return value;
         }
+        *out << "Transaction " << transactionName << " waits for reading "
+             << variableName << endl;
+        waitingReads.push_back({transactionName, variableName, timestamp});
+        throw runtime_error("Transaction must wait");
+    }
 
+    int siteId = selectReadSite(variableName, timestamp);
+    if (siteId < 0) {
         // If we found a valid version but can't access it right now, wait
-        cout << "Transaction " << transactionName << " waits for reading "
+        *out << "Transaction " << transactionName << " waits for reading "
              << variableName << endl;
         waitingReads.push_back({transactionName, variableName, timestamp});
         throw runtime_error("Transaction must wait");
     }
+    heatmap.recordRead(stoi(variableName.substr(1)), siteId);
+    noteSiteRead(siteId);
+    if (siteProcesses) {
+        return readSiteVersions(siteId, {variableName}, timestamp)[0].value;
+    }
+    return sites[siteId]->readVariable(variableName, timestamp);
+}
+
+// Description: Reads a batch of variables, visiting each chosen site only once
+// Input: transactionName, variableNames, timestamp
+// Output: Vector of BatchRead results in the same order as variableNames
+// Side Effects: Adds variables that must wait to the waitingReads queue, unless one aborts the batch
+vector<BatchRead> DataManager::readBatch(const string& transactionName, const vector<string>& variableNames, long timestamp)
+{
+    vector<BatchRead> results;
+    results.reserve(variableNames.size());
+    map<int, vector<size_t>> readsBySite;
+
+    for (size_t i = 0; i < variableNames.size(); ++i) {
+        const string& variableName = variableNames[i];
+        results.push_back({variableName, ReadStatus::ABORT, 0});
+        if (hasQuorum(variableName)) {
+            results[i].status = readFromQuorum(variableName, timestamp, results[i].value) ? ReadStatus::OK
+                                                                                        : ReadStatus::WAIT;
+            continue;
+        }
+        int siteId;
+        try {
+            siteId = selectReadSite(variableName, timestamp);
+        } catch (const runtime_error&) {
+            continue;
+        }
+        if (siteId < 0) {
+            results[i].status = ReadStatus::WAIT;
+            continue;
+        }
+        heatmap.recordRead(stoi(variableName.substr(1)), siteId);
+        noteSiteRead(siteId);
+        readsBySite[siteId].push_back(i);
+    }
+
+    // One locked pass per site for all variables routed to it
+    vector<string> names;
+    for (const auto& group : readsBySite) {
+        names.clear();
+        for (size_t i : group.second) {
+            names.push_back(variableNames[i]);
+        }
+        try {
+            if (siteProcesses) {
+                vector<Version> versions = readSiteVersions(group.first, names, timestamp);
+                for (size_t k = 0; k < group.second.size(); ++k) {
+                    results[group.second[k]].status = ReadStatus::OK;
+                    results[group.second[k]].value = versions[k].value;
+                }
+                continue;
+            }
+            vector<int> values = sites[group.first]->readVariables(names, timestamp);
+            for (size_t k = 0; k < group.second.size(); ++k) {
+                results[group.second[k]].status = ReadStatus::OK;
+                results[group.second[k]].value = values[k];
+            }
+        } catch (const runtime_error&) {
+            // Results stay ABORT for every variable of this site
+        }
+    }
+
+    // Reads are parked only once the whole batch is known to go ahead; the transaction aborts if
+    // any variable cannot be read, and nothing should be left waiting on its behalf
+    for (const auto& result : results) {
+        if (result.status == ReadStatus::ABORT) {
+            return results;
+        }
+    }
+    for (const auto& result : results) {
+        if (result.status == ReadStatus::WAIT) {
+            *out << "Transaction " << transactionName << " waits for reading "
+                 << result.variableName << endl;
+            waitingReads.push_back({transactionName, result.variableName, timestamp});
+        }
+    }
+    return results;
+}
+
+// Description: Gathers snapshot values of many variables for scans and aggregates
+// Input: variableNames, timestamp
+// Output: ReadStatus - OK when every value was gathered; values holds them in input order,
+//         blockingVariable names the first variable that could not be read otherwise
+// Side Effects: None (unreadable variables are not parked as waiting reads)
+ReadStatus DataManager::gatherSnapshot(const vector<string>& variableNames, long timestamp, vector<int>& values, string& blockingVariable)
+{
+    values.assign(variableNames.size(), 0);
+    map<int, vector<size_t>> positionsBySite;
+
+    for (size_t i = 0; i < variableNames.size(); ++i) {
+        if (hasQuorum(variableNames[i])) {
+            if (!readFromQuorum(variableNames[i], timestamp, values[i])) {
+                blockingVariable = variableNames[i];
+                return ReadStatus::WAIT;
+            }
+            continue;
+        }
+        int siteId;
+        try {
+            siteId = selectReadSite(variableNames[i], timestamp);
+        } catch (const runtime_error&) {
+            blockingVariable = variableNames[i];
+            return ReadStatus::ABORT;
+        }
+        if (siteId < 0) {
+            blockingVariable = variableNames[i];
+            return ReadStatus::WAIT;
+        }
+        heatmap.recordRead(stoi(variableNames[i].substr(1)), siteId);
+        noteSiteRead(siteId);
+        positionsBySite[siteId].push_back(i);
+    }
 
-    throw runtime_error("No available site to read " + variableName);
+    vector<int> indices;
+    vector<int> siteValues;
+    for (const auto& group : positionsBySite) {
+        indices.clear();
+        for (size_t i : group.second) {
+            indices.push_back(stoi(variableNames[i].substr(1)));
+        }
+        siteValues.resize(indices.size());
+        try {
+            if (siteProcesses) {
+                vector<string> names;
+                for (size_t i : group.second) {
+                    names.push_back(variableNames[i]);
+                }
+                vector<Version> versions = readSiteVersions(group.first, names, timestamp);
+                for (size_t k = 0; k < versions.size(); ++k) {
+                    siteValues[k] = versions[k].value;
+                }
+            } else {
+                sites[group.first]->gatherSnapshot(indices, timestamp, siteValues.data());
+            }
+        } catch (const runtime_error&) {
+            blockingVariable = variableNames[group.second.front()];
+            return ReadStatus::ABORT;
+        }
+        for (size_t k = 0; k < group.second.size(); ++k) {
+            values[group.second[k]] = siteValues[k];
+        }
+    }
+    return ReadStatus::OK;
 }
 
 // Description: Brings a failed site back online and processes pending reads
-// Input: siteId
+// Input: siteId, resolveInDoubt - settles the two-phase commits the site voted on before failing
 // Output: None
-// Side Effects: Recovers site, processes waiting reads, prints status
-void DataManager::recoverSite(int siteId) 
+// Side Effects: Recovers site, installs in-doubt decisions, catches it up if enabled, answers
+//               waiting reads it can serve, records RecoveryStats, prints status
+void DataManager::recoverSite(int siteId, const function<void()>& resolveInDoubt)
 {
     auto site = getSite(siteId);
     if (!site || site->getStatus() != SiteStatus::DOWN) {
         return;
     }
 
+    auto start = chrono::steady_clock::now();
+    recoveryHistory.push_back(RecoveryStats{siteId, 0, 0, 0, 0, 0, 0, -1});
+    awaitingFirstRead[siteId] = make_pair(recoveryHistory.size() - 1, start);
+    RecoveryStats& stats = recoveryHistory.back();
+
     site->recover();
-    cout << "Site " << siteId << " recovered." << endl;
+    auto marked = chrono::steady_clock::now();
+    stats.markMicros = chrono::duration<double, micro>(marked - start).count();
+    *out << "Site " << siteId << " recovered." << endl;
+
+    // Decided writes staged before the failure are older than anything catch-up brings, and
+    // histories only grow at the newest end
+    if (resolveInDoubt) {
+        resolveInDoubt();
+    }
+    if (catchUpEnabled) {
+        catchUpSite(site);
+    }
+    if (siteProcesses) {
+        // The restarted process is seeded from the site's durable image
+        siteProcesses->start(*site);
+    }
+    auto caughtUp = chrono::steady_clock::now();
+    stats.catchUpMicros = catchUpEnabled ? chrono::duration<double, micro>(caughtUp - marked).count() : 0;
 
-    // Process waiting reads
-    auto it = waitingReads.begin();
-    while (it != waitingReads.end()) {
-        if (site->hasVariable(it->variableName) && 
-            hasSiteStableHistory(site, it->timestamp)) {
+    // Answer waiting reads in the order they were parked, keeping the rest in place; erasing each
+    // answered read instead would shift the tail every time
+    size_t kept = 0;
+    for (size_t i = 0; i < waitingReads.size(); ++i) {
+        WaitingRead& waiting = waitingReads[i];
+        bool answered = false;
+        if (hasQuorum(waiting.variableName)) {
+            int value;
+            if (readFromQuorum(waiting.variableName, waiting.timestamp, value)) {
+                *out << waiting.variableName << ": " << value << endl;
+                answered = true;
+            }
+        } else if (site->hasVariable(waiting.variableName) && hasSiteStableHistory(site, waiting.timestamp)) {
             try {
-                int value = site->readVariable(it->variableName, it->timestamp);
-                cout << it->variableName << ": " << value << endl;
-                it = waitingReads.erase(it);
-                continue;
+                int value = siteProcesses ? readSiteVersions(siteId, {waiting.variableName}, waiting.timestamp)[0].value
+                                          : site->readVariable(waiting.variableName, waiting.timestamp);
+                *out << waiting.variableName << ": " << value << endl;
+                answered = true;
+                noteSiteRead(siteId);
             } catch (...) {}
         }
-        ++it;
+        if (answered) {
+            ++stats.parkedServed;
+        } else {
+            if (kept != i) {
+                waitingReads[kept] = std::move(waiting);
+            }
+            ++kept;
+        }
     }
+    stats.parkedScanned = waitingReads.size();
+    waitingReads.resize(kept);
+
+    auto finished = chrono::steady_clock::now();
+    stats.scanMicros = chrono::duration<double, micro>(finished - caughtUp).count();
+    stats.totalMicros = chrono::duration<double, micro>(finished - start).count();
 }
 
 // Description: Simulates failure of a database site
@@ -261,6 +569,1047 @@ void DataManager::failSite(int siteId)
     
     if (site->getStatus() != SiteStatus::DOWN) {
         site->fail();
-        cout << "Site " << siteId << " failed." << endl;
+        // A site that fails again before serving a read never reaches its first read
+        awaitingFirstRead.erase(siteId);
+        if (siteProcesses) {
+            siteProcesses->stop(siteId);
+        }
+        *out << "Site " << siteId << " failed." << endl;
+    }
+}
+
+// Description: Turns bulk catch-up on recovery on or off
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Changes how later recoveries behave
+void DataManager::setCatchUpEnabled(bool enabled)
+{
+    catchUpEnabled = enabled;
+}
+
+// Description: Reports whether bulk catch-up on recovery is on
+// Input: None
+// Output: bool - true if enabled
+// Side Effects: None
+bool DataManager::isCatchUpEnabled() const
+{
+    return catchUpEnabled;
+}
+
+// Description: Returns the metrics of all catch-ups so far
+// Input: None
+// Output: Vector of CatchUpStats, oldest first
+// Side Effects: None
+const vector<CatchUpStats>& DataManager::getCatchUpHistory() const
+{
+    return catchUpHistory;
+}
+
+// Description: Returns the metrics of every recovery
+// Input: None
+// Output: Vector of RecoveryStats, oldest first
+// Side Effects: None
+const vector<RecoveryStats>& DataManager::getRecoveryHistory() const
+{
+    return recoveryHistory;
+}
+
+// Description: Completes the time to first read of a recovered site
+// Input: siteId - site a read was routed to
+// Output: None
+// Side Effects: The first read after a recovery sets firstReadMicros of that recovery
+void DataManager::noteSiteRead(int siteId)
+{
+    if (awaitingFirstRead.empty()) {
+        return;
+    }
+    auto it = awaitingFirstRead.find(siteId);
+    if (it == awaitingFirstRead.end()) {
+        return;
+    }
+    recoveryHistory[it->second.first].firstReadMicros =
+        chrono::duration<double, micro>(chrono::steady_clock::now() - it->second.second).count();
+    awaitingFirstRead.erase(it);
+}
+
+// Description: Chooses the replica to copy missed versions of a variable from
+// Input: site - the recovering site, variableName - variable the donor must hold, "" for any
+// Output: Pointer to an up site with continuous history since the outage began, or null
+// Side Effects: None
+shared_ptr<Site> DataManager::selectCatchUpDonor(shared_ptr<Site> site, const string& variableName) const
+{
+    const auto& failureTimes = site->getFailureTimes();
+    if (failureTimes.empty()) {
+        return nullptr;
+    }
+    long outageStart = failureTimes.back().first;
+    long now = chrono::system_clock::now().time_since_epoch().count();
+
+    for (const auto& sitePair : sites) {
+        auto donor = sitePair.second;
+        if (donor != site && donor->getStatus() == SiteStatus::UP &&
+            (variableName.empty() || donor->hasVariable(variableName)) &&
+            hasContinuousHistory(donor, outageStart, now)) {
+            return donor;
+        }
+    }
+    return nullptr;
+}
+
+// Description: Bulk-copies the replicated versions a recovering site missed
+// Input: site - site that just recovered
+// Output: None
+// Side Effects: Extends the site's histories, makes it UP, records and prints metrics
+void DataManager::catchUpSite(shared_ptr<Site> site)
+{
+    auto start = chrono::steady_clock::now();
+    // Donor histories must include every lazily propagated write
+    drainReplication();
+    auto donor = selectCatchUpDonor(site, "");
+    if (!donor) {
+        *out << "Site " << site->getId() << " has no up-to-date replica to catch up from." << endl;
+        return;
+    }
+
+    // Variables the donor lacks (after replicas moved) come from another up-to-date replica
+    map<shared_ptr<Site>, map<string, long>> requests;
+    for (const auto& entry : site->getReplicatedCommitTimes()) {
+        auto source = donor->hasVariable(entry.first) ? donor : selectCatchUpDonor(site, entry.first);
+        if (!source) {
+            *out << "Site " << site->getId() << " has no up-to-date replica of " << entry.first
+                 << " to catch up from." << endl;
+            return;
+        }
+        requests[source].insert(entry);
+    }
+    map<string, vector<Version>> tails;
+    for (const auto& request : requests) {
+        auto part = request.first->collectVersionTails(request.second);
+        tails.insert(part.begin(), part.end());
+    }
+    size_t versions = site->installCatchUp(tails);
+    if (propagator) {
+        propagator->resetSite(site->getId());
+    }
+
+    CatchUpStats stats;
+    stats.siteId = site->getId();
+    stats.donorSiteId = donor->getId();
+    stats.variables = tails.size();
+    stats.versions = versions;
+    stats.bytes = versions * sizeof(Version);
+    stats.durationMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    catchUpHistory.push_back(stats);
+
+    *out << "Site " << stats.siteId << " caught up from site " << stats.donorSiteId << ": "
+         << stats.versions << " versions of " << stats.variables << " variables ("
+         << stats.bytes << " bytes)." << endl;
+}
+
+// Description: Switches between synchronous and lazy primary-copy replication
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Starts or drains and stops the background propagator
+void DataManager::setLazyReplication(bool enabled)
+{
+    if (enabled && !propagator) {
+        // Site processes only receive synchronously applied writes
+        siteProcesses.reset();
+        propagator.reset(new ReplicationPropagator());
+    } else if (!enabled) {
+        propagator.reset();
+    }
+}
+
+// Description: Reports whether replicated writes are propagated lazily
+// Input: None
+// Output: bool - true if lazy replication is on
+// Side Effects: None
+bool DataManager::isLazyReplication() const
+{
+    return propagator != nullptr;
+}
+
+// Description: Waits for lazily propagated writes to reach their replicas
+// Input: None
+// Output: None
+// Side Effects: Blocks until the propagation queue is empty
+void DataManager::drainReplication()
+{
+    if (propagator) {
+        propagator->drain();
+    }
+}
+
+// Description: Returns lazy replication metrics
+// Input: None
+// Output: ReplicationStats - zeros if lazy replication is off
+// Side Effects: None
+ReplicationStats DataManager::getReplicationStats() const
+{
+    if (!propagator) {
+        return ReplicationStats{0, 0, 0, 0.0, 0.0};
+    }
+    return propagator->getStats();
+}
+
+// Description: Checks whether a replica has every write a snapshot needs
+// Input: siteId, timestamp - snapshot time
+// Output: bool - true in synchronous mode or when the replica has applied up to timestamp
+// Side Effects: None
+bool DataManager::isReplicaFresh(int siteId, long timestamp) const
+{
+    return !propagator || propagator->isFresh(siteId, timestamp);
+}
+
+// Description: Works out which sites take part in committing a transaction and what each applies
+// Input: transaction
+// Output: map of site ID to the writes that site applies, following the current replication mode
+// Side Effects: None
+map<int, vector<StagedWrite>> DataManager::planCommit(shared_ptr<Transaction> transaction)
+{
+    map<int, vector<StagedWrite>> participants;
+    for (const auto& write : transaction->getWriteSet()) {
+        const string& variableName = write.first;
+        int varIndex = stoi(variableName.substr(1));
+        StagedWrite staged = {variableName, write.second};
+
+        if (!isReplicated(variableName)) {
+            int siteId = replicaSites[varIndex].front();
+            if (sites[siteId]->getStatus() == SiteStatus::UP) {
+                participants[siteId].push_back(staged);
+            }
+            continue;
+        }
+        // Quorum writes go to W live replicas, lazy writes to the primary only, others to every up replica
+        int needed = hasQuorum(variableName) ? quorums[variableName].writeQuorum : numSites;
+        if (!hasQuorum(variableName) && propagator) {
+            needed = 1;
+        }
+        int chosen = 0;
+        for (int siteId : replicaSites[varIndex]) {
+            auto site = sites[siteId];
+            if (chosen == needed) {
+                break;
+            }
+            bool usable = hasQuorum(variableName) ? site->getStatus() != SiteStatus::DOWN
+                                                  : site->getStatus() == SiteStatus::UP;
+            if (usable) {
+                participants[siteId].push_back(staged);
+                ++chosen;
+            }
+        }
+    }
+    return participants;
+}
+
+// Description: Tells a participant the outcome of a transaction it prepared
+// Input: siteId, transactionName, commit - the coordinator's decision
+// Output: None
+// Side Effects: On commit installs the staged writes (and streams them to lazy secondaries)
+void DataManager::deliverDecision(int siteId, const string& transactionName, bool commit)
+{
+    auto site = sites[siteId];
+    long commitTime = 0;
+    vector<StagedWrite> writes = site->decide(transactionName, commit, commitTime);
+    if (!commit) {
+        return;
+    }
+    for (const auto& write : writes) {
+        applyWrite(site.get(), write.variableName, write.value, commitTime);
+        if (propagator && isReplicated(write.variableName) && !hasQuorum(write.variableName)) {
+            vector<Site*> secondaries;
+            for (int replicaId : replicaSites[stoi(write.variableName.substr(1))]) {
+                if (replicaId != siteId && sites[replicaId]->getStatus() == SiteStatus::UP) {
+                    secondaries.push_back(sites[replicaId].get());
+                    heatmap.recordSiteWrite(replicaId);
+                }
+            }
+            propagator->enqueue(write.variableName, write.value, commitTime, secondaries);
+        }
+    }
+    if (siteProcesses) {
+        siteProcesses->flush();
+    }
+}
+
+// Description: Moves site data into per-site processes, or back into this process
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Spawns or stops one process per site that is not down, stops lazy replication
+void DataManager::setSiteProcesses(bool enabled)
+{
+    if (!enabled) {
+        siteProcesses.reset();
+        return;
+    }
+    if (siteProcesses) {
+        return;
+    }
+    setLazyReplication(false);
+    siteProcesses.reset(new SiteProcessHost(replicaSites));
+    for (auto& sitePair : sites) {
+        if (sitePair.second->getStatus() != SiteStatus::DOWN) {
+            siteProcesses->start(*sitePair.second);
+        }
+    }
+}
+
+// Description: Reports whether sites run as separate processes
+// Input: None
+// Output: bool - true in process mode
+// Side Effects: None
+bool DataManager::isSiteProcesses() const
+{
+    return siteProcesses != nullptr;
+}
+
+// Description: Applies the version retention policy at every site
+// Input: protectedTimes - timestamps whose snapshots must stay readable, in any order
+// Output: size_t - versions dropped over all sites
+// Side Effects: Shrinks histories, moves the prune horizon to now, updates counters; site
+//               processes keep their own full histories
+size_t DataManager::pruneVersions(const vector<long>& protectedTimes)
+{
+    long now = chrono::system_clock::now().time_since_epoch().count();
+    vector<long> times(protectedTimes);
+    // Reads from now on must see what they would have seen without the prune
+    times.push_back(now);
+    sort(times.begin(), times.end());
+    times.erase(unique(times.begin(), times.end()), times.end());
+
+    size_t pruned = 0;
+    size_t kept = 0;
+    for (auto& site : sites) {
+        pruned += site.second->pruneVersions(times);
+        kept += site.second->getVersionCount();
+    }
+    pruneHorizon = now;
+    ++retention.prunes;
+    retention.versionsPruned += pruned;
+    retention.versionsKept = kept;
+    return pruned;
+}
+
+// Description: Checks if pruning may have changed what a snapshot at timestamp reads
+// Input: timestamp
+// Output: bool - true if the timestamp is not older than the latest prune
+// Side Effects: None
+bool DataManager::isHistoryRetained(long timestamp) const
+{
+    return timestamp >= pruneHorizon;
+}
+
+// Description: Switches every site between compressed and uncompressed version storage
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Re-encodes all histories; replicas holding the same versions share full blocks
+void DataManager::setCompression(bool enabled)
+{
+    compression = enabled;
+    for (auto& site : sites) {
+        site.second->setCompression(enabled, &blockInterner);
+    }
+}
+
+// Description: Checks if version histories are stored compressed
+// Input: None
+// Output: bool
+// Side Effects: None
+bool DataManager::isCompression() const
+{
+    return compression;
+}
+
+// Description: Turns the change feed of committed writes on or off
+// Input: enabled (bool), capacity - records the ring keeps for subscribers
+// Output: None
+// Side Effects: A new feed replaces the old one, whose subscribers and file sink end
+void DataManager::setChangeCapture(bool enabled, size_t capacity)
+{
+    changeFeed.reset(enabled ? new ChangeFeed(capacity) : nullptr);
+}
+
+// Description: Returns the change feed
+// Input: None
+// Output: ChangeFeed* - null while change capture is off
+// Side Effects: None
+ChangeFeed* DataManager::getChangeFeed()
+{
+    return changeFeed.get();
+}
+
+// Description: Counts and publishes the writes of a transaction committed by two-phase commit
+// Input: transaction - committed, plan - writes staged per participant site
+// Output: None
+// Side Effects: Updates the heatmap; one change record per write, where lazily replicated writes
+//               list the replicas they stream to
+void DataManager::publishCommit(shared_ptr<Transaction> transaction, const map<int, vector<StagedWrite>>& plan)
+{
+    for (const auto& write : transaction->getWriteSet()) {
+        heatmap.recordWrite(stoi(write.first.substr(1)));
+    }
+    if (!changeFeed) {
+        return;
+    }
+    for (const auto& write : transaction->getWriteSet()) {
+        uint64_t siteMask = 0;
+        for (const auto& participant : plan) {
+            for (const auto& staged : participant.second) {
+                if (staged.variableName == write.first) {
+                    siteMask |= siteBit(participant.first);
+                }
+            }
+        }
+        int varIndex = stoi(write.first.substr(1));
+        if (propagator && isReplicated(write.first) && !hasQuorum(write.first)) {
+            for (int siteId : replicaSites[varIndex]) {
+                if (sites[siteId]->getStatus() == SiteStatus::UP) {
+                    siteMask |= siteBit(siteId);
+                }
+            }
+        }
+        changeFeed->publish(transaction->getName(), transaction->getCommitTime(), varIndex, write.second, siteMask);
+    }
+}
+
+// Description: Measures version storage across the sites
+// Input: None
+// Output: VersionStorageStats
+// Side Effects: None
+VersionStorageStats DataManager::getVersionStorage() const
+{
+    VersionStorageStats storage{0, 0, 0, 0};
+    for (const auto& site : sites) {
+        storage.versions += site.second->getVersionCount();
+        storage.unsharedBytes += site.second->getVersionBytes();
+    }
+    size_t savedBytes = 0;
+    blockInterner.getUsage(storage.sharedBlocks, savedBytes);
+    storage.bytes = storage.unsharedBytes - savedBytes;
+    return storage;
+}
+
+// Description: Sets the memory budget of version storage
+// Input: bytes - storage to keep in memory, 0 for no cap; error - receives why the budget was refused
+// Output: bool - false if the spill file could not be created
+// Side Effects: Creates the spill file on the first budget; blocks already spilled stay on disk
+//               until read, even once the cap is lifted
+bool DataManager::setMemoryBudget(size_t bytes, string& error)
+{
+    if (bytes > 0 && !spillFile) {
+        try {
+            spillFile = make_shared<SpillFile>(sizeof(VersionBlock));
+        } catch (const runtime_error& e) {
+            error = e.what();
+            return false;
+        }
+    }
+    memoryBudget = bytes;
+    return true;
+}
+
+// Description: Returns the memory budget
+// Input: None
+// Output: size_t - bytes, 0 if uncapped
+// Side Effects: None
+size_t DataManager::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+// Description: Spills cold version blocks when storage in memory reaches 90% of the budget
+// Input: protectedTimes - timestamps whose snapshots must stay readable, in any order
+// Output: size_t - bytes spilled
+// Side Effects: Sites write blocks older than the oldest protected time, or now, to the spill file
+//               until storage is down to 75% of the budget or nothing cold is left
+size_t DataManager::enforceMemoryBudget(const vector<long>& protectedTimes)
+{
+    if (memoryBudget == 0) {
+        return 0;
+    }
+    size_t resident = 0;
+    for (const auto& site : sites) {
+        resident += site.second->getVersionBytes();
+    }
+    if (resident < memoryBudget / 10 * 9) {
+        return 0;
+    }
+    // Spilling down below the threshold leaves room for a few commits before the next spill
+    long horizon = chrono::system_clock::now().time_since_epoch().count();
+    for (long time : protectedTimes) {
+        horizon = min(horizon, time);
+    }
+    size_t wanted = resident - memoryBudget / 4 * 3;
+    size_t spilled = 0;
+    for (auto& site : sites) {
+        if (spilled >= wanted) {
+            break;
+        }
+        spilled += site.second->spillVersions(horizon, spillFile, wanted - spilled);
+    }
+    if (spilled > 0) {
+        ++budgetSpills;
+    }
+    return spilled;
+}
+
+// Description: Measures version storage in memory and on disk
+// Input: None
+// Output: MemoryStats
+// Side Effects: None
+MemoryStats DataManager::getMemoryStats() const
+{
+    MemoryStats memory{0, 0, budgetSpills, SpillStats{0, 0, 0, 0}};
+    for (const auto& site : sites) {
+        memory.residentBytes += site.second->getVersionBytes();
+        memory.spilledBytes += site.second->getSpilledBytes();
+    }
+    if (spillFile) {
+        memory.file = spillFile->getStats();
+    }
+    return memory;
+}
+
+// Description: Returns counters of the retention policy
+// Input: None
+// Output: RetentionStats
+// Side Effects: None
+const RetentionStats& DataManager::getRetentionStats() const
+{
+    return retention;
+}
+
+// Description: Applies a committed write to a site
+// Input: site, variableName, value, commitTime
+// Output: None
+// Side Effects: Updates the site; in process mode also queues the write for its process
+void DataManager::applyWrite(Site* site, const string& variableName, int value, long commitTime)
+{
+    site->writeVariable(variableName, value, commitTime);
+    heatmap.recordSiteWrite(site->getId());
+    if (siteProcesses) {
+        siteProcesses->queueWrite(site->getId(), stoi(variableName.substr(1)), value, commitTime);
+    }
+}
+
+// Description: Reads versions of several variables from the process of a site
+// Input: siteId, variableNames, timestamp
+// Output: Versions in the order of variableNames
+// Side Effects: One request/reply round trip; throws if the site process cannot answer
+vector<Version> DataManager::readSiteVersions(int siteId, const vector<string>& variableNames, long timestamp)
+{
+    vector<int> indices;
+    indices.reserve(variableNames.size());
+    for (const auto& name : variableNames) {
+        indices.push_back(stoi(name.substr(1)));
+    }
+    return siteProcesses->readVersions(siteId, indices, timestamp);
+}
+
+// Description: Configures quorum replication for a replicated variable
+// Input: variableName, readQuorum (R), writeQuorum (W)
+// Output: bool - true if applied; otherwise error explains why
+// Side Effects: Changes how the variable is read and written
+bool DataManager::setQuorum(const string& variableName, int readQuorum, int writeQuorum, string& error)
+{
+    int replicas = getReplicaCount(variableName);
+    if (replicas < 2) {
+        error = variableName + " is not replicated";
+        return false;
+    }
+    if (readQuorum < 1 || writeQuorum < 1 || readQuorum > replicas || writeQuorum > replicas) {
+        error = "quorum sizes must be between 1 and " + to_string(replicas);
+        return false;
+    }
+    if (readQuorum + writeQuorum <= replicas) {
+        error = "R + W must exceed " + to_string(replicas) + " replicas";
+        return false;
+    }
+    quorums[variableName] = {readQuorum, writeQuorum};
+    return true;
+}
+
+// Description: Removes the quorum configuration of a variable
+// Input: variableName
+// Output: None
+// Side Effects: Variable goes back to write-all-available replication
+void DataManager::clearQuorum(const string& variableName)
+{
+    quorums.erase(variableName);
+}
+
+// Description: Checks whether a variable is quorum-replicated
+// Input: variableName
+// Output: bool - true if a quorum is configured
+// Side Effects: None
+bool DataManager::hasQuorum(const string& variableName) const
+{
+    return !quorums.empty() && quorums.count(variableName) > 0;
+}
+
+// Description: Checks whether a commit could currently reach a write quorum
+// Input: variableName
+// Output: bool - true if at least W replicas are live (or no quorum is configured)
+// Side Effects: None
+bool DataManager::canWriteQuorum(const string& variableName) const
+{
+    auto it = quorums.find(variableName);
+    if (it == quorums.end()) {
+        return true;
+    }
+    int live = 0;
+    for (const auto& sitePair : sites) {
+        if (sitePair.second->getStatus() != SiteStatus::DOWN && sitePair.second->hasVariable(variableName)) {
+            ++live;
+        }
+    }
+    return live >= it->second.writeQuorum;
+}
+
+// Description: Counts the sites that hold a copy of a variable
+// Input: variableName
+// Output: int - replica count
+// Side Effects: None
+int DataManager::getReplicaCount(const string& variableName) const
+{
+    return static_cast<int>(getReplicaSites(variableName).size());
+}
+
+// Description: Checks whether more than one site holds the variable
+// Input: variableName
+// Output: bool - true for replicated variables, false if one site holds the only copy
+// Side Effects: None
+bool DataManager::isReplicated(const string& variableName) const
+{
+    return getReplicaCount(variableName) > 1;
+}
+
+// Description: Lists the sites holding a copy of a variable
+// Input: variableName
+// Output: Site IDs in ascending order
+// Side Effects: None
+const vector<int>& DataManager::getReplicaSites(const string& variableName) const
+{
+    return replicaSites[stoi(variableName.substr(1))];
+}
+
+// Description: Places the variables anew, e.g. by a policy other than the default
+// Input: placement - sites holding each variable 1..20
+// Output: bool - true if the sites were rebuilt; otherwise error explains why
+// Side Effects: Replaces every site with one holding only initial values, clears the access heatmap;
+//               refused once anything was committed or failed, since those histories would be lost
+bool DataManager::setPlacement(const ReplicaLists& placement, string& error)
+{
+    if (placement.size() != replicaSites.size()) {
+        error = "every variable x1..x20 needs a placement";
+        return false;
+    }
+    size_t initialVersions = 0;
+    for (size_t v = 1; v < placement.size(); ++v) {
+        if (placement[v].empty() || placement[v].front() < 1 || placement[v].back() > numSites) {
+            error = "x" + to_string(v) + " needs sites between 1 and " + to_string(numSites);
+            return false;
+        }
+        initialVersions += replicaSites[v].size();
+    }
+    if (siteProcesses) {
+        error = "sites run as processes";
+        return false;
+    }
+    if (!quorums.empty()) {
+        error = "quorum replication is configured";
+        return false;
+    }
+    for (const auto& sitePair : sites) {
+        if (sitePair.second->getStatus() != SiteStatus::UP || !sitePair.second->getFailureTimes().empty()) {
+            error = "site " + to_string(sitePair.first) + " has failed";
+            return false;
+        }
+    }
+    if (getVersionStorage().versions != initialVersions || !waitingReads.empty()) {
+        error = "transactions have already committed";
+        return false;
+    }
+
+    if (propagator) {
+        propagator->drain();
+    }
+    replicaSites = placement;
+    initializeSites();
+    setCompression(compression);
+    heatmap = AccessHeatmap(20, numSites);
+    return true;
+}
+
+// Description: Checks whether a copy can answer a snapshot read
+// Input: site, variableName - held by site, timestamp - snapshot time
+// Output: bool - true if the site was up without a gap from the copy's creation to timestamp
+// Side Effects: None
+bool DataManager::isCopyComplete(shared_ptr<Site> site, const string& variableName, long timestamp) const
+{
+    return hasContinuousHistory(site, site->getCopyTime(variableName), timestamp);
+}
+
+// Description: Adds a replica of a variable at a site
+// Input: variableName, siteId - an up site without a copy
+// Output: bool - true if added; otherwise error explains why
+// Side Effects: Copies every version from a complete copy, so snapshot reads at any time are
+//               answered alike by the new replica; a variable with one copy becomes replicated
+bool DataManager::addReplica(const string& variableName, int siteId, string& error)
+{
+    int varIndex = stoi(variableName.substr(1));
+    if (siteProcesses) {
+        error = "sites run as separate processes";
+        return false;
+    }
+    if (hasQuorum(variableName)) {
+        error = variableName + " uses a quorum";
+        return false;
+    }
+    if (!sites.count(siteId) || sites[siteId]->getStatus() != SiteStatus::UP) {
+        error = "site " + to_string(siteId) + " is not up";
+        return false;
+    }
+    if (sites[siteId]->hasVariable(variableName)) {
+        error = "site " + to_string(siteId) + " already holds " + variableName;
+        return false;
+    }
+
+    // The donor must hold every version, lazily propagated ones included
+    drainReplication();
+    long now = chrono::system_clock::now().time_since_epoch().count();
+    bool replicated = isReplicated(variableName);
+    shared_ptr<Site> donor;
+    for (int holder : replicaSites[varIndex]) {
+        auto candidate = sites[holder];
+        if (candidate->getStatus() == SiteStatus::UP && isReplicaFresh(holder, now) &&
+            (!replicated || isCopyComplete(candidate, variableName, now))) {
+            donor = candidate;
+            break;
+        }
+    }
+    if (!donor) {
+        error = "no complete copy of " + variableName + " is up";
+        return false;
+    }
+
+    map<string, long> everything = {{variableName, numeric_limits<long>::min()}};
+    vector<Version> history = donor->collectVersionTails(everything)[variableName];
+    if (!replicated) {
+        donor->setReplicated(variableName, true);
+    }
+    sites[siteId]->addVariable(variableName, history, true);
+    auto position = lower_bound(replicaSites[varIndex].begin(), replicaSites[varIndex].end(), siteId);
+    replicaSites[varIndex].insert(position, siteId);
+    ++placementStats.replicasAdded;
+    placementStats.versionsCopied += history.size();
+    return true;
+}
+
+// Description: Removes a site's replica of a variable
+// Input: variableName, siteId - a site holding a copy
+// Output: bool - true if dropped; otherwise error explains why
+// Side Effects: Frees the copy; a variable left with one copy is no longer replicated. Another
+//               complete copy must stay up, so every snapshot stays readable
+bool DataManager::dropReplica(const string& variableName, int siteId, string& error)
+{
+    int varIndex = stoi(variableName.substr(1));
+    vector<int>& holders = replicaSites[varIndex];
+    if (siteProcesses) {
+        error = "sites run as separate processes";
+        return false;
+    }
+    if (hasQuorum(variableName)) {
+        error = variableName + " uses a quorum";
+        return false;
+    }
+    auto position = find(holders.begin(), holders.end(), siteId);
+    if (position == holders.end()) {
+        error = "site " + to_string(siteId) + " does not hold " + variableName;
+        return false;
+    }
+    if (holders.size() == 1) {
+        error = "site " + to_string(siteId) + " holds the only copy";
+        return false;
+    }
+
+    drainReplication();
+    long now = chrono::system_clock::now().time_since_epoch().count();
+    bool keepsCopy = false;
+    for (int holder : holders) {
+        if (holder != siteId && sites[holder]->getStatus() == SiteStatus::UP && isReplicaFresh(holder, now) &&
+            isCopyComplete(sites[holder], variableName, now)) {
+            keepsCopy = true;
+            break;
+        }
+    }
+    if (!keepsCopy) {
+        error = "no other complete copy of " + variableName + " is up";
+        return false;
+    }
+
+    sites[siteId]->removeVariable(variableName);
+    holders.erase(position);
+    if (holders.size() == 1) {
+        sites[holders.front()]->setReplicated(variableName, false);
+    }
+    ++placementStats.replicasDropped;
+    return true;
+}
+
+// Description: Runs the placement policy on the accesses counted since the last run
+// Input: None
+// Output: Moves carried out, in order
+// Side Effects: Adds and drops replicas, halves the heatmap counts
+vector<PlacementMove> DataManager::rebalance()
+{
+    vector<bool> usableSites(numSites + 1, false);
+    for (const auto& sitePair : sites) {
+        usableSites[sitePair.first] = sitePair.second->getStatus() == SiteStatus::UP;
+    }
+    vector<PlacementMove> applied;
+    string error;
+    for (const PlacementMove& move : placement.plan(heatmap, replicaSites, usableSites)) {
+        string variableName = "x" + to_string(move.variableIndex);
+        bool done = move.add ? addReplica(variableName, move.siteId, error)
+                             : dropReplica(variableName, move.siteId, error);
+        if (done) {
+            applied.push_back(move);
+        }
+    }
+    heatmap.decay();
+    ++placementStats.rebalances;
+    return applied;
+}
+
+// Description: Turns load-aware read routing on or off
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Replicated reads go to the least loaded complete replica instead of the first
+void DataManager::setAdaptivePlacement(bool enabled)
+{
+    adaptivePlacement = enabled;
+}
+
+// Description: Reports whether reads are routed by load
+// Input: None
+// Output: bool
+// Side Effects: None
+bool DataManager::isAdaptivePlacement() const
+{
+    return adaptivePlacement;
+}
+
+// Description: Changes the thresholds of the placement policy
+// Input: policy
+// Output: None
+// Side Effects: Later rebalances use them
+void DataManager::setPlacementPolicy(const PlacementPolicy& policy)
+{
+    placement.setPolicy(policy);
+}
+
+// Description: Returns the thresholds of the placement policy
+// Input: None
+// Output: PlacementPolicy
+// Side Effects: None
+const PlacementPolicy& DataManager::getPlacementPolicy() const
+{
+    return placement.getPolicy();
+}
+
+// Description: Returns the access counts the placement policy works from
+// Input: None
+// Output: AccessHeatmap
+// Side Effects: None
+const AccessHeatmap& DataManager::getHeatmap() const
+{
+    return heatmap;
+}
+
+// Description: Returns counters of adaptive replication
+// Input: None
+// Output: PlacementStats
+// Side Effects: None
+const PlacementStats& DataManager::getPlacementStats() const
+{
+    return placementStats;
+}
+
+// Description: Reads from R live replicas and keeps the newest version visible at timestamp
+// Input: variableName, timestamp
+// Output: bool - true if a read quorum answered; value receives the result
+// Side Effects: None
+bool DataManager::readFromQuorum(const string& variableName, long timestamp, int& value)
+{
+    int needed = quorums[variableName].readQuorum;
+    int answered = 0;
+    Version newest = {0, -1};
+    for (auto& sitePair : sites) {
+        auto site = sitePair.second;
+        if (answered == needed) {
+            break;
+        }
+        if (site->getStatus() == SiteStatus::DOWN || !site->hasVariable(variableName)) {
+            continue;
+        }
+        try {
+            Version version = siteProcesses ? readSiteVersions(site->getId(), {variableName}, timestamp)[0]
+                                            : site->readVersion(variableName, timestamp);
+            if (version.commitTime > newest.commitTime) {
+                newest = version;
+            }
+            heatmap.recordRead(stoi(variableName.substr(1)), site->getId());
+            noteSiteRead(site->getId());
+            ++answered;
+        } catch (const runtime_error&) {
+            continue;
+        }
+    }
+    if (answered < needed) {
+        return false;
+    }
+    value = newest.value;
+    return true;
+}
+
+// Description: Finds the value the latest commit left in a variable
+// Input: variableName
+// Output: bool - false if no copy is live; value receives the newest committed value
+// Side Effects: None
+bool DataManager::readLatestCommitted(const string& variableName, int& value)
+{
+    Version newest = {0, -1};
+    for (auto& sitePair : sites) {
+        auto site = sitePair.second;
+        if (site->getStatus() == SiteStatus::DOWN || !site->hasVariable(variableName)) {
+            continue;
+        }
+        // Copies that missed writes (recovering or lazy secondaries) hold older versions
+        long latest = numeric_limits<long>::max();
+        Version version = siteProcesses ? readSiteVersions(site->getId(), {variableName}, latest)[0]
+                                        : site->readVersion(variableName, latest);
+        if (version.commitTime > newest.commitTime) {
+            newest = version;
+        }
+    }
+    if (newest.commitTime < 0) {
+        return false;
+    }
+    value = newest.value;
+    return true;
+}
+
+// Description: Applies a committed write to the first W live replicas
+// Input: variableName, value, commitTime
+// Output: uint64_t - bit i-1 set for each site i written
+// Side Effects: Updates W replicas; the others keep older versions
+uint64_t DataManager::writeToQuorum(const string& variableName, int value, long commitTime)
+{
+    uint64_t siteMask = 0;
+    int needed = quorums[variableName].writeQuorum;
+    int written = 0;
+    for (auto& sitePair : sites) {
+        auto site = sitePair.second;
+        if (written == needed) {
+            break;
+        }
+        if (site->getStatus() != SiteStatus::DOWN && site->hasVariable(variableName)) {
+            applyWrite(site.get(), variableName, value, commitTime);
+            siteMask |= siteBit(sitePair.first);
+            ++written;
+        }
+    }
+    return siteMask;
+}
+
+// Description: Prints metrics collected by the data manager
+// Input: None
+// Output: None
+// Side Effects: Prints to console
+void DataManager::printStats() const
+{
+    size_t versions = 0;
+    size_t bytes = 0;
+    double micros = 0;
+    for (const auto& stats : catchUpHistory) {
+        versions += stats.versions;
+        bytes += stats.bytes;
+        micros += stats.durationMicros;
+    }
+    if (propagator) {
+        ReplicationStats replication = propagator->getStats();
+        *out << "Lazy replication: " << replication.recordsQueued << " writes queued, "
+             << replication.replicaApplies << " replica applies, " << replication.replicaSkips
+             << " skipped, lag avg " << replication.averageLagMicros << " us, max "
+             << replication.maxLagMicros << " us" << endl;
+    }
+    if (siteProcesses) {
+        const SiteProcessStats& traffic = siteProcesses->getStats();
+        *out << "Site processes: " << siteProcesses->getRunningCount() << " running, "
+             << traffic.processesStarted << " started, " << traffic.messagesSent << " messages in "
+             << traffic.batchesPublished << " batches, " << traffic.readRoundTrips
+             << " read round trips, avg "
+             << (traffic.readRoundTrips ? traffic.totalReadMicros / traffic.readRoundTrips : 0.0)
+             << " us" << endl;
+    }
+    for (const auto& quorum : quorums) {
+        *out << "Quorum " << quorum.first << ": R=" << quorum.second.readQuorum << ", W="
+             << quorum.second.writeQuorum << " of " << getReplicaCount(quorum.first) << " replicas" << endl;
+    }
+    if (compression) {
+        VersionStorageStats storage = getVersionStorage();
+        *out << "Compressed versions: " << storage.versions << " versions in " << storage.bytes << " bytes ("
+             << storage.unsharedBytes << " without sharing), " << storage.sharedBlocks << " full blocks" << endl;
+    }
+    if (changeFeed) {
+        ChangeFeedStats feed = changeFeed->getStats();
+        *out << "Change feed: " << feed.published << " changes published, ring of " << changeFeed->getCapacity()
+             << ", " << feed.sinkRecords << " records in " << feed.sinkBytes << " bytes to file" << endl;
+    }
+    if (adaptivePlacement || placementStats.replicasAdded > 0 || placementStats.replicasDropped > 0) {
+        *out << "Placement: " << placementStats.rebalances << " rebalances, " << placementStats.replicasAdded
+             << " replicas added, " << placementStats.replicasDropped << " dropped, "
+             << placementStats.versionsCopied << " versions copied; site load (reads/writes)";
+        for (const auto& sitePair : sites) {
+            const AccessCounts& load = heatmap.getSite(sitePair.first);
+            *out << " " << sitePair.first << "=" << load.reads << "/" << load.writes;
+        }
+        *out << endl;
+    }
+    if (spillFile) {
+        MemoryStats memory = getMemoryStats();
+        *out << "Memory: budget " << memoryBudget << " bytes, " << memory.residentBytes << " resident, "
+             << memory.spilledBytes << " spilled in " << memory.spills << " spills; "
+             << memory.file.segmentsWritten << " blocks written, " << memory.file.segmentsRead
+             << " paged in, spill file " << memory.file.fileBytes << " bytes; site bytes (resident/spilled)";
+        for (const auto& sitePair : sites) {
+            *out << " " << sitePair.first << "=" << sitePair.second->getVersionBytes() << "/"
+                 << sitePair.second->getSpilledBytes();
+        }
+        *out << endl;
+    }
+    if (retention.prunes > 0) {
+        *out << "Retention: " << retention.prunes << " prunes, " << retention.versionsPruned
+             << " versions pruned, " << retention.versionsKept << " versions kept" << endl;
+    }
+    if (!recoveryHistory.empty()) {
+        size_t scanned = 0;
+        size_t served = 0;
+        for (const auto& stats : recoveryHistory) {
+            scanned += stats.parkedScanned;
+            served += stats.parkedServed;
+        }
+        // Timings are kept in getRecoveryHistory; only the counts are printed, so output stays reproducible
+        *out << "Recovery: " << recoveryHistory.size() << " runs, " << served << " of " << scanned
+             << " parked reads answered" << endl;
+    }
+    *out << "Catch-up: " << (catchUpEnabled ? "on" : "off") << ", " << catchUpHistory.size()
+         << " runs, " << versions << " versions, " << bytes << " bytes, " << micros << " us total" << endl;
+    for (const auto& stats : catchUpHistory) {
+        *out << "  site " << stats.siteId << " <- site " << stats.donorSiteId << ": "
+             << stats.versions << " versions, " << stats.bytes << " bytes, "
+             << stats.durationMicros << " us" << endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:52:00
+ */
+
+#include "Placement.h"
+using namespace std;
+
+namespace
+{
+    // Description: Scrambles a key into a ring position (splitmix64 finalizer)
+    // Input: key
+    // Output: uint64_t - well-spread hash
+    // Side Effects: None
+    uint64_t ringHash(uint64_t key)
+    {
+        key += 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+}
+
+// Description: Builds the hash ring
+// Input: numSites, copies - copies of every variable, pointsPerSite - ring points owned by each site
+// Output: None
+// Side Effects: None
+ConsistentHashPlacement::ConsistentHashPlacement(int numSites, int copies, int pointsPerSite)
+    : copies(min(copies, numSites))
+{
+    for (int siteId = 1; siteId <= numSites; ++siteId)
+    {
+        for (int point = 0; point < pointsPerSite; ++point)
+        {
+            ring.push_back(make_pair(ringHash((uint64_t(siteId) << 32) | uint64_t(point)), siteId));
+        }
+    }
+    sort(ring.begin(), ring.end());
+}
+
+// Description: Finds the sites of a variable on the ring
+// Input: variableIndex
+// Output: siteIds - receives the owners of the first points clockwise from the variable's hash,
+//         skipping sites already chosen
+// Side Effects: None
+void ConsistentHashPlacement::place(int variableIndex, vector<int> &siteIds) const
+{
+    uint64_t position = ringHash(uint64_t(variableIndex) | (uint64_t(1) << 63));
+    size_t start = lower_bound(ring.begin(), ring.end(), make_pair(position, 0)) - ring.begin();
+    size_t first = siteIds.size();
+    for (size_t step = 0; step < ring.size() && static_cast<int>(siteIds.size() - first) < copies; ++step)
+    {
+        int siteId = ring[(start + step) % ring.size()].second;
+        if (find(siteIds.begin() + first, siteIds.end(), siteId) == siteIds.end())
+        {
+            siteIds.push_back(siteId);
+        }
+    }
+}
@@ -0,0 +1,219 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:16:30
+ */
+
+#include "ReplicationPropagator.h"
+#include <climits>
+using namespace std;
+
+// Description: Creates the propagator and starts its worker thread
+// Input: None
+// Output: None
+// Side Effects: Spawns a thread
+ReplicationPropagator::ReplicationPropagator()
+    : applying(false), idle(false), stopping(false), stats{0, 0, 0, 0.0, 0.0}, totalLagMicros(0.0)
+{
+    worker = thread(&ReplicationPropagator::run, this);
+}
+
+// Description: Flushes pending writes and joins the worker
+// Input: None
+// Output: None
+// Side Effects: Applies remaining records, stops the thread
+ReplicationPropagator::~ReplicationPropagator()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    workReady.notify_one();
+    worker.join();
+}
+
+// Description: Hands a committed write to the propagator
+// Input: variableName, value, commitTime, targets - secondary replicas to update
+// Output: None
+// Side Effects: Marks each target as behind until the write is applied
+void ReplicationPropagator::enqueue(const string &variableName, int value, long commitTime,
+                                    const vector<Site *> &targets)
+{
+    if (targets.empty())
+    {
+        return;
+    }
+    bool wakeWorker;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        for (Site *site : targets)
+        {
+            auto it = lag.find(site->getId());
+            if (it == lag.end())
+            {
+                it = lag.insert(make_pair(site->getId(), SiteLag{0, LONG_MAX, false})).first;
+            }
+            SiteLag &siteLag = it->second;
+            if (siteLag.pending == 0 && !siteLag.stale)
+            {
+                // Everything before this commit has reached the site
+                siteLag.appliedThrough = commitTime - 1;
+            }
+            ++siteLag.pending;
+        }
+        queue.push_back(Record{variableName, value, commitTime, targets, chrono::steady_clock::now()});
+        ++stats.recordsQueued;
+        wakeWorker = idle;
+    }
+    // Only pay for a wake-up when the worker is actually asleep
+    if (wakeWorker)
+    {
+        workReady.notify_one();
+    }
+}
+
+// Description: Checks whether a replica can serve a snapshot read
+// Input: siteId, timestamp - snapshot time of the reader
+// Output: bool - true if all writes committed at or before timestamp are applied there
+// Side Effects: None
+bool ReplicationPropagator::isFresh(int siteId, long timestamp) const
+{
+    lock_guard<mutex> lock(queueMutex);
+    auto it = lag.find(siteId);
+    if (it == lag.end())
+    {
+        return true;
+    }
+    if (it->second.pending == 0 && !it->second.stale)
+    {
+        return true;
+    }
+    return timestamp <= it->second.appliedThrough;
+}
+
+// Description: Checks whether waiting for the propagator would make the replica current
+// Input: siteId
+// Output: bool - true if the site has writes in flight and has not missed any
+// Side Effects: None
+bool ReplicationPropagator::isCatchingUp(int siteId) const
+{
+    lock_guard<mutex> lock(queueMutex);
+    auto it = lag.find(siteId);
+    return it != lag.end() && it->second.pending > 0 && !it->second.stale;
+}
+
+// Description: Returns how far a replica is known to be complete
+// Input: siteId
+// Output: long - applied-through commit time, LONG_MAX if nothing is outstanding
+// Side Effects: None
+long ReplicationPropagator::getAppliedThrough(int siteId) const
+{
+    lock_guard<mutex> lock(queueMutex);
+    auto it = lag.find(siteId);
+    if (it == lag.end() || (it->second.pending == 0 && !it->second.stale))
+    {
+        return LONG_MAX;
+    }
+    return it->second.appliedThrough;
+}
+
+// Description: Waits until the queue is empty and no record is being applied
+// Input: None
+// Output: None
+// Side Effects: Blocks the caller
+void ReplicationPropagator::drain()
+{
+    unique_lock<mutex> lock(queueMutex);
+    queueDrained.wait(lock, [this]() { return queue.empty() && !applying; });
+}
+
+// Description: Clears the lag state of a site, e.g. after a catch-up copied its data
+// Input: siteId
+// Output: None
+// Side Effects: The site counts as current again
+void ReplicationPropagator::resetSite(int siteId)
+{
+    lock_guard<mutex> lock(queueMutex);
+    auto it = lag.find(siteId);
+    if (it != lag.end() && it->second.pending == 0)
+    {
+        lag.erase(it);
+    }
+}
+
+// Description: Returns a copy of the propagation metrics
+// Input: None
+// Output: ReplicationStats
+// Side Effects: None
+ReplicationStats ReplicationPropagator::getStats() const
+{
+    lock_guard<mutex> lock(queueMutex);
+    ReplicationStats result = stats;
+    result.averageLagMicros = stats.replicaApplies ? totalLagMicros / stats.replicaApplies : 0.0;
+    return result;
+}
+
+// Description: Worker loop, applies queued writes one record at a time in commit order
+// Input: None
+// Output: None
+// Side Effects: Writes to secondary replicas, updates lag state and metrics
+void ReplicationPropagator::run()
+{
+    unique_lock<mutex> lock(queueMutex);
+    while (true)
+    {
+        idle = true;
+        workReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+        idle = false;
+        if (queue.empty())
+        {
+            break;
+        }
+        Record record = std::move(queue.front());
+        queue.pop_front();
+        applying = true;
+        lock.unlock();
+
+        vector<bool> applied(record.targets.size(), false);
+        for (size_t i = 0; i < record.targets.size(); ++i)
+        {
+            // Sites that failed or recovered since the commit missed this write
+            if (record.targets[i]->getStatus() == SiteStatus::UP)
+            {
+                record.targets[i]->writeVariable(record.variableName, record.value, record.commitTime);
+                applied[i] = true;
+            }
+        }
+        double lagMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - record.queuedAt).count();
+
+        lock.lock();
+        for (size_t i = 0; i < record.targets.size(); ++i)
+        {
+            SiteLag &siteLag = lag[record.targets[i]->getId()];
+            --siteLag.pending;
+            if (!applied[i])
+            {
+                siteLag.stale = true;
+                ++stats.replicaSkips;
+                continue;
+            }
+            if (!siteLag.stale)
+            {
+                siteLag.appliedThrough = siteLag.pending == 0 ? LONG_MAX : record.commitTime;
+            }
+            ++stats.replicaApplies;
+            totalLagMicros += lagMicros;
+            if (lagMicros > stats.maxLagMicros)
+            {
+                stats.maxLagMicros = lagMicros;
+            }
+        }
+        applying = false;
+        if (queue.empty())
+        {
+            queueDrained.notify_all();
+        }
+    }
+    applying = false;
+    queueDrained.notify_all();
+}
@@ -9,15 +9,34 @@
 #include <chrono>
 #include <string>
 #include <algorithm>
+#include <limits>
 using namespace std;
 
-// Description: Constructs a new database site with given ID
-// Input: id (int) - unique identifier for the site
+// Description: Constructs a new database site with given ID under the default placement
+// Input: id (int) - unique identifier for the site, numSites (int) - sites in the system
 // Output: None
 // Side Effects: Initializes variables for this site
-Site::Site(int id) : id(id), status(SiteStatus::UP)
+Site::Site(int id, int numSites)
+    : Site(id, placeVariables(defaultPlacement(numSites), 20))
 {
-    initializeVariables();
+}
+
+// Description: Constructs a new database site with given ID
+// Input: id (int) - unique identifier for the site, placement - sites holding each variable
+// Output: None
+// Side Effects: Initializes the variables placed at this site
+Site::Site(int id, const ReplicaLists &placement)
+    : id(id), status(SiteStatus::UP), versionSlab(sizeof(VersionBlock)), recoveryEpoch(0),
+      writeEpochs(placement.size(), 0), published(new PublishedVersions[placement.size()]),
+      publishedCount(static_cast<int>(placement.size())), interner(nullptr)
+{
+    for (int i = 0; i < publishedCount; ++i)
+    {
+        published[i].sequence.store(0, memory_order_relaxed);
+        published[i].count.store(0, memory_order_relaxed);
+        published[i].newest.store(0, memory_order_relaxed);
+    }
+    initializeVariables(placement);
 }
 
 // Description: Returns the site's unique identifier
@@ -53,6 +72,7 @@ void Site::setStatus(SiteStatus status)
 // Side Effects: None
 bool Site::hasCommittedWrite(const string &variableName, long startTime) const
 {
+    std::lock_guard<std::mutex> lock(siteMutex);
     auto it = variables.find(variableName);
     if (it != variables.end())
     {
@@ -70,80 +90,276 @@ bool Site::hasVariable(const string &variableName) const
     return variables.find(variableName) != variables.end();
 }
 
+// Description: Checks if the copy of a variable can be trusted for reads
+// Input: variableName (string)
+// Output: bool - false if not stored here, the site is down, or a replica not written since recovery
+// Side Effects: None
+bool Site::isAvailable(const string &variableName) const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    if (status == SiteStatus::DOWN || variables.find(variableName) == variables.end()) {
+        return false;
+    }
+    int varIndex = stoi(variableName.substr(1));
+    return status == SiteStatus::UP || !replicatedVariables.count(variableName) ||
+           (varIndex < publishedCount && writeEpochs[varIndex] == recoveryEpoch);
+}
+
 // Description: Reads value of variable at specific timestamp
 // Input: variableName (string), timestamp (long)
 // Output: int - variable value
 // Side Effects: Throws exception if site down or variable not found
 int Site::readVariable(const std::string &variableName, long timestamp) {
-    std::lock_guard<std::mutex> lock(siteMutex);
+    return readVersion(variableName, timestamp).value;
+}
 
+// Description: Reads the version of a variable visible at a timestamp
+// Input: variableName (string), timestamp (long)
+// Output: Version - value with its commit time
+// Side Effects: Throws exception if site down or variable not found
+Version Site::readVersion(const std::string &variableName, long timestamp)
+{
     if (status == SiteStatus::DOWN) {
         throw std::runtime_error("Site is down.");
     }
 
+    Version version;
+    if (readPublished(stoi(variableName.substr(1)), timestamp, version)) {
+        return version;
+    }
+    return readLocked(variableName, timestamp);
+}
+
+// Description: Reads a group of variables at one timestamp
+// Input: variableNames (vector<string>), timestamp (long)
+// Output: vector<int> - values in the same order as variableNames
+// Side Effects: Throws exception if site down or any variable not found
+std::vector<int> Site::readVariables(const std::vector<std::string> &variableNames, long timestamp)
+{
+    if (status == SiteStatus::DOWN) {
+        throw std::runtime_error("Site is down.");
+    }
+
+    std::vector<int> values;
+    values.reserve(variableNames.size());
+    for (const auto &variableName : variableNames) {
+        Version version;
+        if (!readPublished(stoi(variableName.substr(1)), timestamp, version)) {
+            version = readLocked(variableName, timestamp);
+        }
+        values.push_back(version.value);
+    }
+    return values;
+}
+
+// Description: Copies snapshot values of variables into a contiguous buffer
+// Input: varIndices (vector<int>) - variables stored at this site, timestamp (long)
+// Output: out (int*) - receives one value per index, in order
+// Side Effects: Throws exception if site down or any variable not stored here
+void Site::gatherSnapshot(const std::vector<int> &varIndices, long timestamp, int *out)
+{
+    if (status == SiteStatus::DOWN) {
+        throw std::runtime_error("Site is down.");
+    }
+
+    for (size_t i = 0; i < varIndices.size(); ++i) {
+        Version version;
+        if (!readPublished(varIndices[i], timestamp, version)) {
+            version = readLocked("x" + std::to_string(varIndices[i]), timestamp);
+        }
+        out[i] = version.value;
+    }
+}
+
+// Description: Looks up the version visible at timestamp in a variable's published ring
+// Input: varIndex (int), timestamp (long)
+// Output: version - the version found; bool - false if the caller must read under the lock
+// Side Effects: None; retries while a writer is updating the ring
+bool Site::readPublished(int varIndex, long timestamp, Version &version) const
+{
+    if (varIndex < 0 || varIndex >= publishedCount) {
+        return false;
+    }
+    const PublishedVersions &entry = published[varIndex];
+    // A writer holds the ring for a few stores, so a handful of retries almost always suffices
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        unsigned before = entry.sequence.load(memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        int count = entry.count.load(memory_order_relaxed);
+        int position = entry.newest.load(memory_order_relaxed);
+        bool found = false;
+        for (int i = 0; i < count; ++i) {
+            long commitTime = entry.commitTimes[position].load(memory_order_relaxed);
+            if (commitTime <= timestamp) {
+                version.value = entry.values[position].load(memory_order_relaxed);
+                version.commitTime = commitTime;
+                found = true;
+                break;
+            }
+            position = position == 0 ? PUBLISHED_VERSIONS - 1 : position - 1;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (entry.sequence.load(memory_order_relaxed) == before) {
+            return found;
+        }
+    }
+    return false;
+}
+
+// Description: Reads a version under the site lock, for reads the published ring cannot serve
+// Input: variableName (string), timestamp (long)
+// Output: Version - value with its commit time
+// Side Effects: Throws exception if the variable is not stored here
+Version Site::readLocked(const std::string &variableName, long timestamp)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
     auto it = variables.find(variableName);
+    if (it == variables.end()) {
+        throw std::runtime_error("Variable " + variableName + " not found");
+    }
+    return it->second.readVersion(timestamp);
+}
+
+// Description: Appends a version to a variable's published ring
+// Input: varIndex (int), value (int), commitTime (long)
+// Output: None
+// Side Effects: Overwrites the oldest published version once the ring is full; a version older
+//               than the latest refills the ring from the history instead. Caller holds the lock
+void Site::publish(int varIndex, int value, long commitTime)
+{
+    if (varIndex < 0 || varIndex >= publishedCount) {
+        return;
+    }
+    PublishedVersions &entry = published[varIndex];
+    int count = entry.count.load(memory_order_relaxed);
+    int position = entry.newest.load(memory_order_relaxed);
+    if (count > 0 && entry.commitTimes[position].load(memory_order_relaxed) > commitTime) {
+        republish(varIndex);
+        return;
+    }
+    position = (position + 1) % PUBLISHED_VERSIONS;
+    unsigned sequence = entry.sequence.load(memory_order_relaxed);
+    entry.sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    entry.values[position].store(value, memory_order_relaxed);
+    entry.commitTimes[position].store(commitTime, memory_order_relaxed);
+    entry.newest.store(position, memory_order_relaxed);
+    entry.count.store(min(count + 1, PUBLISHED_VERSIONS), memory_order_relaxed);
+    entry.sequence.store(sequence + 2, memory_order_release);
+}
+
+// Description: Rebuilds a variable's published ring from its history
+// Input: varIndex (int)
+// Output: None
+// Side Effects: Publishes the latest versions exactly as the history answers reads, or none if
+//               the variable is not stored here. Caller holds the lock
+void Site::republish(int varIndex)
+{
+    if (varIndex < 0 || varIndex >= publishedCount) {
+        return;
+    }
+    // Walking back with readVersion mirrors the locked read, including its initial-value fallback
+    std::vector<Version> latest;
+    auto it = variables.find("x" + std::to_string(varIndex));
     if (it != variables.end()) {
-        return it->second.readValue(timestamp);
+        Version version = it->second.readVersion(numeric_limits<long>::max());
+        latest.push_back(version);
+        while ((int)latest.size() < PUBLISHED_VERSIONS && version.commitTime > 0) {
+            Version older = it->second.readVersion(version.commitTime - 1);
+            if (older.commitTime >= version.commitTime) {
+                break;
+            }
+            version = older;
+            latest.push_back(version);
+        }
+    }
+
+    PublishedVersions &entry = published[varIndex];
+    unsigned sequence = entry.sequence.load(memory_order_relaxed);
+    entry.sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    int count = static_cast<int>(latest.size());
+    for (int i = 0; i < count; ++i) {
+        // Oldest at position 0, latest at count - 1
+        entry.values[i].store(latest[count - 1 - i].value, memory_order_relaxed);
+        entry.commitTimes[i].store(latest[count - 1 - i].commitTime, memory_order_relaxed);
     }
+    entry.newest.store(count > 0 ? count - 1 : 0, memory_order_relaxed);
+    entry.count.store(count, memory_order_relaxed);
+    entry.sequence.store(sequence + 2, memory_order_release);
+}
 
-    throw std::runtime_error("Variable " + variableName + " not found");
+// Description: Marks a copy as written since the latest recovery
+// Input: varIndex (int)
+// Output: None
+// Side Effects: The copy counts as available; caller holds the site lock
+void Site::markCurrent(int varIndex)
+{
+    if (varIndex >= 0 && varIndex < publishedCount) {
+        writeEpochs[varIndex] = recoveryEpoch;
+    }
 }
 
 // Description: Updates variable value with commit timestamp
 // Input: variableName (string), value (int), commitTime (long)
 // Output: None
-// Side Effects: Updates variable value, removes from unavailable list
+// Side Effects: Updates variable value, makes the copy available
 void Site::writeVariable(const std::string &variableName, int value, long commitTime)
 {
     std::lock_guard<std::mutex> lock(siteMutex);
     variables[variableName].writeValue(value, commitTime);
-    unavailableVariables.erase(variableName);
+    int varIndex = stoi(variableName.substr(1));
+    markCurrent(varIndex);
+
+    publish(varIndex, value, commitTime);
 }
 
 // Description: Displays current state of all variables at this site
-// Input: None
+// Input: out - stream written to
 // Output: None
-// Side Effects: Prints site status and variable values to console
-void Site::dump() const
+// Side Effects: Prints site status and variable values
+void Site::dump(ostream &out) const
 {
-    cout << "=== Site " << id << " ===" << endl;
+    out << "=== Site " << id << " ===" << endl;
     if (status == SiteStatus::DOWN)
     {
-        cout << "Site " << id << " is down" << endl;
+        out << "Site " << id << " is down" << endl;
         return;
     }
 
     bool hasModifiedVars = false;
 
-    // Check odd variables
+    // Check variables held only here
     for (const auto &pair : variables)
     {
         string varName = pair.first;
         int varIndex = stoi(varName.substr(1));
-        if (varIndex % 2 == 1)
+        if (replicatedVariables.count(varName) == 0)
         {
             int value = pair.second.readValue(chrono::system_clock::now().time_since_epoch().count());
             int initialValue = varIndex * 10;
             if (value != initialValue)
             {
-                cout << varName << ": " << value << endl;
+                out << varName << ": " << value << endl;
                 hasModifiedVars = true;
             }
         }
     }
 
-    // Check even variables
+    // Check replicated variables
     for (const auto &pair : variables)
     {
         string varName = pair.first;
         int varIndex = stoi(varName.substr(1));
-        if (varIndex % 2 == 0)
+        if (replicatedVariables.count(varName) != 0)
         {
             int value = pair.second.readValue(chrono::system_clock::now().time_since_epoch().count());
             int initialValue = varIndex * 10;
             if (value != initialValue)
             {
-                cout << varName << ": " << value << " at all sites" << endl;
+                out << varName << ": " << value << " at all sites" << endl;
                 hasModifiedVars = true;
                 break;
             }
@@ -152,35 +368,110 @@ void Site::dump() const
 
     if (!hasModifiedVars)
     {
-        cout << "All variables have their initial values" << endl;
+        out << "All variables have their initial values" << endl;
     }
 }
 
 // Description: Sets up initial variables for this site
-// Input: None
+// Input: placement - sites holding each variable
 // Output: None
-// Side Effects: Creates and initializes variables based on site ID
-void Site::initializeVariables()
+// Side Effects: Creates and initializes the variables placed here; those placed at more than one
+//               site are marked replicated
+void Site::initializeVariables(const ReplicaLists &placement)
 {
-    for (int i = 1; i <= 20; ++i)
+    for (int i = 1; i < static_cast<int>(placement.size()); ++i)
     {
-        std::string varName = "x" + std::to_string(i);
-        int initialValue = i * 10;
-        if (i % 2 == 0)
+        const vector<int> &siteIds = placement[i];
+        if (find(siteIds.begin(), siteIds.end(), id) == siteIds.end())
         {
-            // Even-indexed variable, replicated at all sites
-            variables[varName] = Variable(varName, initialValue);
+            continue;
         }
-        else
+        std::string varName = "x" + std::to_string(i);
+        variables[varName] = Variable(varName, i * 10, &versionSlab);
+        if (siteIds.size() > 1)
         {
-            // Odd-indexed variable, stored at one site
-            int assignedSite = 1 + (i % 10);
-            if (assignedSite == id)
-            {
-                variables[varName] = Variable(varName, initialValue);
-            }
+            replicatedVariables.insert(varName);
         }
     }
+
+    republishAll();
+}
+
+// Description: Refills the published ring of every variable index
+// Input: None
+// Output: None
+// Side Effects: Rings of variables stored here hold their latest versions, the others are empty
+void Site::republishAll()
+{
+    for (int varIndex = 0; varIndex < publishedCount; ++varIndex)
+    {
+        republish(varIndex);
+    }
+}
+
+// Description: Installs a copy of a variable, e.g. a replica added by adaptive placement
+// Input: variableName, history - every version, oldest first, replicated - other copies exist
+// Output: None
+// Side Effects: Replaces any copy held here, republishes, records the copy time
+void Site::addVariable(const std::string &variableName, const std::vector<Version> &history, bool replicated)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    Variable copy(variableName, history.front().value, &versionSlab);
+    for (size_t i = 1; i < history.size(); ++i) {
+        copy.writeValue(history[i].value, history[i].commitTime);
+    }
+    if (interner) {
+        copy.setCompressed(true, interner);
+    }
+    variables[variableName] = std::move(copy);
+    if (replicated) {
+        replicatedVariables.insert(variableName);
+    } else {
+        replicatedVariables.erase(variableName);
+    }
+    copyTimes[variableName] = std::chrono::system_clock::now().time_since_epoch().count();
+    markCurrent(stoi(variableName.substr(1)));
+    republish(stoi(variableName.substr(1)));
+}
+
+// Description: Drops this site's copy of a variable
+// Input: variableName
+// Output: None
+// Side Effects: Frees its history and republishes
+void Site::removeVariable(const std::string &variableName)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    variables.erase(variableName);
+    replicatedVariables.erase(variableName);
+    copyTimes.erase(variableName);
+    republish(stoi(variableName.substr(1)));
+}
+
+// Description: Changes whether the copy of a variable is one of several replicas
+// Input: variableName, replicated
+// Output: None
+// Side Effects: A copy that becomes replicated counts as complete from now, since it was the
+//               only copy and so received every write
+void Site::setReplicated(const std::string &variableName, bool replicated)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    if (!replicated) {
+        replicatedVariables.erase(variableName);
+    } else if (replicatedVariables.insert(variableName).second) {
+        copyTimes[variableName] = std::chrono::system_clock::now().time_since_epoch().count();
+        markCurrent(stoi(variableName.substr(1)));
+    }
+}
+
+// Description: Tells from when the copy of a variable holds every committed version
+// Input: variableName
+// Output: long - time the copy was installed or promoted, 0 if it has been here from the start
+// Side Effects: None
+long Site::getCopyTime(const std::string &variableName) const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    auto it = copyTimes.find(variableName);
+    return it == copyTimes.end() ? 0 : it->second;
 }
 
 // Description: Returns history of site failures
@@ -192,6 +483,204 @@ const std::vector<std::pair<long, long>> &Site::getFailureTimes() const
     return failureTimes;
 }
 
+// Description: Tells whether a failure gap has been filled by a catch-up
+// Input: failureIndex (size_t) - position in getFailureTimes()
+// Output: bool - true if replicated data missed during that failure was copied in
+// Side Effects: None
+bool Site::isFailureHealed(size_t failureIndex) const
+{
+    return failureIndex < healedFailures.size() && healedFailures[failureIndex];
+}
+
+// Description: Looks for a failure overlapping a period
+// Input: fromTime, toTime - the period, inclusive; countHealed - also consider failures a catch-up filled
+// Output: bool - true if the site was down at some point of the period
+// Side Effects: None
+bool Site::wasDownDuring(long fromTime, long toTime, bool countHealed) const
+{
+    // Failures are disjoint and in order, so their ends ascend with only the last one open. The
+    // first failure ending at or after fromTime is the only one that can overlap, if it started by toTime
+    size_t count = countHealed ? failureTimes.size() : unhealedFailures.size();
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        long end = failureTimes[countHealed ? middle : unhealedFailures[middle]].second;
+        if (end != -1 && end < fromTime) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < count && failureTimes[countHealed ? low : unhealedFailures[low]].first <= toTime;
+}
+
+// Description: Reports how far each replicated variable's history reaches
+// Input: None
+// Output: map of replicated variable name to its latest commit time
+// Side Effects: None
+std::map<std::string, long> Site::getReplicatedCommitTimes()
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    std::map<std::string, long> commitTimes;
+    for (const auto &variableName : replicatedVariables) {
+        commitTimes[variableName] = variables.at(variableName).getLatestCommitTime();
+    }
+    return commitTimes;
+}
+
+// Description: Copies version tails for a catch-up under a single lock
+// Input: since - variable name to the commit time the requester already has
+// Output: map of variable name to versions committed after that time
+// Side Effects: None
+std::map<std::string, std::vector<Version>> Site::collectVersionTails(const std::map<std::string, long> &since)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    std::map<std::string, std::vector<Version>> tails;
+    for (const auto &entry : since) {
+        auto it = variables.find(entry.first);
+        if (it == variables.end()) {
+            continue;
+        }
+        std::vector<Version> tail;
+        it->second.collectVersionsAfter(entry.second, tail);
+        if (!tail.empty()) {
+            tails[entry.first].swap(tail);
+        }
+    }
+    return tails;
+}
+
+// Description: Appends caught-up versions and brings the site back to UP
+// Input: tails - versions missed while down, per variable, oldest first
+// Output: size_t - number of versions installed
+// Side Effects: Extends histories, makes every copy available, heals the latest failure, sets status UP
+size_t Site::installCatchUp(const std::map<std::string, std::vector<Version>> &tails)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t installed = 0;
+    for (const auto &tail : tails) {
+        auto it = variables.find(tail.first);
+        if (it == variables.end()) {
+            continue;
+        }
+        size_t before = installed;
+        for (const auto &version : tail.second) {
+            if (version.commitTime > it->second.getLatestCommitTime()) {
+                it->second.writeValue(version.value, version.commitTime);
+                ++installed;
+            }
+        }
+        // Copies that missed nothing keep their published rings
+        if (installed > before) {
+            republish(stoi(tail.first.substr(1)));
+        }
+    }
+    if (!healedFailures.empty()) {
+        healedFailures.back() = true;
+        if (!unhealedFailures.empty() && unhealedFailures.back() == failureTimes.size() - 1) {
+            unhealedFailures.pop_back();
+        }
+    }
+    status = SiteStatus::UP;
+    return installed;
+}
+
+// Description: Applies the retention policy to every variable stored here
+// Input: protectedTimes - timestamps whose snapshots must stay readable, ascending
+// Output: size_t - number of versions dropped
+// Side Effects: Shrinks version histories; latest values are untouched
+size_t Site::pruneVersions(const std::vector<long> &protectedTimes)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t pruned = 0;
+    for (auto &entry : variables) {
+        size_t dropped = entry.second.pruneVersions(protectedTimes);
+        if (dropped > 0) {
+            republish(stoi(entry.first.substr(1)));
+        }
+        pruned += dropped;
+    }
+    return pruned;
+}
+
+// Description: Switches the version store of every variable here
+// Input: enabled - compress if true, interner - shared store for full compressed blocks
+// Output: None
+// Side Effects: Re-encodes all histories under the site lock
+void Site::setCompression(bool enabled, BlockInterner *interner)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    this->interner = enabled ? interner : nullptr;
+    for (auto &entry : variables) {
+        entry.second.setCompressed(enabled, interner);
+    }
+}
+
+// Description: Measures the version storage of this site
+// Input: None
+// Output: size_t - bytes over all variables
+// Side Effects: None
+size_t Site::getVersionBytes() const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t bytes = 0;
+    for (const auto &entry : variables) {
+        bytes += entry.second.getVersionBytes();
+    }
+    return bytes;
+}
+
+// Description: Counts the versions kept at this site
+// Input: None
+// Output: size_t - versions over all variables
+// Side Effects: None
+size_t Site::getVersionCount() const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t versions = 0;
+    for (const auto &entry : variables) {
+        versions += entry.second.getVersionCount();
+    }
+    return versions;
+}
+
+// Description: Moves cold version blocks of this site's variables to disk
+// Input: horizon - no read at or after it needs a spilled block, file - where they go,
+//        bytesWanted - stop once this much is spilled
+// Output: size_t - bytes spilled
+// Side Effects: Writes blocks to file; they are paged back in when read. Published rings hold
+//               copies of the latest versions, so they stay as they are
+size_t Site::spillVersions(long horizon, std::shared_ptr<SpillFile> file, size_t bytesWanted)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t spilled = 0;
+    for (auto &entry : variables) {
+        if (spilled >= bytesWanted) {
+            break;
+        }
+        spilled += entry.second.spillColdBlocks(horizon, *file, bytesWanted - spilled);
+    }
+    if (spilled > 0) {
+        spillFile = file;
+    }
+    return spilled;
+}
+
+// Description: Measures the version storage of this site on disk
+// Input: None
+// Output: size_t - bytes spilled
+// Side Effects: None
+size_t Site::getSpilledBytes() const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t bytes = 0;
+    for (const auto &entry : variables) {
+        bytes += entry.second.getSpilledBytes();
+    }
+    return bytes;
+}
+
 // Description: Simulates site failure
 // Input: None
 // Output: None
@@ -204,13 +693,16 @@ void Site::fail() {
     status = SiteStatus::DOWN;
     long failTime = std::chrono::system_clock::now().time_since_epoch().count();
     failureTimes.emplace_back(failTime, -1);
-    unavailableVariables.clear();
+    healedFailures.push_back(false);
+    unhealedFailures.push_back(failureTimes.size() - 1);
 }
 
 // Description: Recovers site from failure
 // Input: None
 // Output: None
-// Side Effects: Updates status, records recovery time, marks replicated variables as unavailable
+// Side Effects: Updates status, records recovery time, makes replicated variables unavailable until
+//               written; that takes a new epoch rather than a mark per variable, so it costs the
+//               same however many variables the site holds
 void Site::recover() {
     std::unique_lock<std::mutex> lock(siteMutex);
     if (status != SiteStatus::DOWN) {
@@ -222,11 +714,63 @@ void Site::recover() {
         failureTimes.back().second = recoverTime;
     }
 
-    // Mark replicated variables as unavailable until a new write
-    for (const auto &varPair : variables) {
-        int varIndex = stoi(varPair.first.substr(1));
-        if (varIndex % 2 == 0) {
-            unavailableVariables.insert(varPair.first);
-        }
+    // Every copy is stale until written in the new epoch
+    ++recoveryEpoch;
+}
+
+// Description: Handles a prepare request of the two-phase commit
+// Input: transactionName, commitTime, writes - this site's share of the transaction
+// Output: bool - true for a yes vote
+// Side Effects: Stages the writes and appends PREPARED to the participant log
+bool Site::prepare(const std::string &transactionName, long commitTime, const std::vector<StagedWrite> &writes)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    if (status == SiteStatus::DOWN) {
+        return false;
+    }
+    preparedTransactions[transactionName] = PreparedTransaction{commitTime, writes};
+    participantLog.push_back(std::make_pair(transactionName, ParticipantState::PREPARED));
+    return true;
+}
+
+// Description: Handles the decision of the two-phase commit
+// Input: transactionName, commit - the decision; commitTime receives the proposed commit time
+// Output: Staged writes of the transaction (empty if it was not prepared here)
+// Side Effects: Forgets the staged writes and logs the decision; the caller installs them
+std::vector<StagedWrite> Site::decide(const std::string &transactionName, bool commit, long &commitTime)
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    std::vector<StagedWrite> writes;
+    auto it = preparedTransactions.find(transactionName);
+    if (it == preparedTransactions.end()) {
+        return writes;
     }
-}
\ No newline at end of file
+    commitTime = it->second.commitTime;
+    writes.swap(it->second.writes);
+    preparedTransactions.erase(it);
+    participantLog.push_back(std::make_pair(transactionName, commit ? ParticipantState::COMMITTED : ParticipantState::ABORTED));
+    return writes;
+}
+
+// Description: Lists prepared transactions still waiting for a decision
+// Input: None
+// Output: Transaction names
+// Side Effects: None
+std::vector<std::string> Site::getInDoubtTransactions() const
+{
+    std::lock_guard<std::mutex> lock(siteMutex);
+    std::vector<std::string> names;
+    for (const auto &entry : preparedTransactions) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+// Description: Returns the participant's two-phase commit log
+// Input: None
+// Output: Log entries, oldest first
+// Side Effects: None
+const std::vector<std::pair<std::string, ParticipantState>> &Site::getParticipantLog() const
+{
+    return participantLog;
+}
@@ -5,6 +5,10 @@
  */
 
 #include "Variable.h"
+#include "CompressedHistory.h"
+#include "SpillFile.h"
+#include <algorithm>
+#include <limits>
 using namespace std;
 
 // Description: Default constructor for Variable class
@@ -12,15 +16,62 @@ using namespace std;
 // Output: None
 // Side Effects: Creates variable with empty name and initial version {0,0}
 Variable::Variable()
-    : name(""), versions({{0, 0}}) {} 
+    : name(""), slab(nullptr), spill(nullptr), spilledBlocks(0) {
+    writeValue(0, 0);
+} 
 
 // Description: Creates named variable with initial value
-// Input: name (string), initialValue (int)
+// Input: name (string), initialValue (int), slab (SlabPool*) - optional block allocator
 // Output: None
 // Side Effects: Creates variable with specified name and initial version
-Variable::Variable(const string& name, int initialValue)
-    : name(name) {
-    versions.push_back({initialValue, 0}); // Initial version at time 0
+Variable::Variable(const string& name, int initialValue, SlabPool* slab)
+    : name(name), slab(slab), spill(nullptr), spilledBlocks(0) {
+    writeValue(initialValue, 0); // Initial version at time 0
+}
+
+// Description: Move constructor, takes over the other variable's blocks
+// Input: other (Variable&&)
+// Output: None
+// Side Effects: Leaves other without any versions
+Variable::Variable(Variable&& other)
+    : name(std::move(other.name)), slab(other.slab), blocks(std::move(other.blocks)),
+      blockStarts(std::move(other.blockStarts)), compressed(std::move(other.compressed)),
+      spillOffsets(std::move(other.spillOffsets)), spill(other.spill), spilledBlocks(other.spilledBlocks) {
+    other.blocks.clear();
+    other.blockStarts.clear();
+    other.spillOffsets.clear();
+    other.spilledBlocks = 0;
+}
+
+// Description: Move assignment, releases current blocks and takes over the other's
+// Input: other (Variable&&)
+// Output: Variable& - this variable
+// Side Effects: Leaves other without any versions
+Variable& Variable::operator=(Variable&& other) {
+    if (this != &other) {
+        releaseBlocks();
+        name = std::move(other.name);
+        slab = other.slab;
+        blocks = std::move(other.blocks);
+        blockStarts = std::move(other.blockStarts);
+        compressed = std::move(other.compressed);
+        spillOffsets = std::move(other.spillOffsets);
+        spill = other.spill;
+        spilledBlocks = other.spilledBlocks;
+        other.blocks.clear();
+        other.blockStarts.clear();
+        other.spillOffsets.clear();
+        other.spilledBlocks = 0;
+    }
+    return *this;
+}
+
+// Description: Destroys the variable
+// Input: None
+// Output: None
+// Side Effects: Returns version blocks to the slab
+Variable::~Variable() {
+    releaseBlocks();
 }
 
 // Description: Returns variable's name identifier
@@ -36,20 +87,84 @@ string Variable::getName() const {
 // Output: int - value of variable at timestamp
 // Side Effects: None
 int Variable::readValue(long timestamp) const {
+    return readVersion(timestamp).value;
+}
+
+// Description: Finds the version of the variable visible at a timestamp
+// Input: timestamp (long) - time point to read from
+// Output: Version - value and commit time; the initial value at time 0 if none qualifies
+// Side Effects: None
+Version Variable::readVersion(long timestamp) const {
+    if (compressed) {
+        Version version;
+        if (compressed->find(timestamp, version)) {
+            return version;
+        }
+        return {stoi(name.substr(1)) * 10, 0};
+    }
+
     // Return initial value if no versions exist
-    if (versions.empty()) {
-        return stoi(name.substr(1)) * 10;
+    if (blocks.empty()) {
+        return {stoi(name.substr(1)) * 10, 0};
     }
     
-    // Return value of latest version before or at timestamp
-    for (auto it = versions.rbegin(); it != versions.rend(); ++it) {
-        if (it->commitTime <= timestamp) {
-            return it->value;
-        }
+    // Versions are appended in commit order, so the latest one usually answers
+    const VersionBlock* last = blocks.back();
+    if (last->commitTimes[last->count - 1] <= timestamp) {
+        return {last->values[last->count - 1], last->commitTimes[last->count - 1]};
+    }
+
+    long position = findVersion(timestamp);
+    if (position >= 0) {
+        const VersionBlock* block = residentBlock(position / VERSIONS_PER_BLOCK);
+        int index = static_cast<int>(position % VERSIONS_PER_BLOCK);
+        return {block->values[index], block->commitTimes[index]};
     }
     
     // If no appropriate version found, return initial value
-    return stoi(name.substr(1)) * 10;
+    return {stoi(name.substr(1)) * 10, 0};
+}
+
+// Description: Locates the version visible at a timestamp
+// Input: timestamp (long) - time point to read from
+// Output: long - position counted from the oldest version, or -1 if every version is newer
+// Side Effects: None
+long Variable::findVersion(long timestamp) const {
+    // Binary search the dense start times first so only one block is touched, then search within it
+    auto bit = upper_bound(blockStarts.begin(), blockStarts.end(), timestamp);
+    if (bit == blockStarts.begin()) {
+        return -1;
+    }
+    size_t b = static_cast<size_t>(bit - blockStarts.begin()) - 1;
+    const VersionBlock* block = residentBlock(b);
+    const long* end = block->commitTimes + block->count;
+    long index = static_cast<long>(upper_bound(block->commitTimes, end, timestamp) - block->commitTimes) - 1;
+    return static_cast<long>(b) * VERSIONS_PER_BLOCK + index;
+}
+
+// Description: Returns the most recently committed value
+// Input: None
+// Output: int - latest value, or the initial value if there is no version
+// Side Effects: None
+int Variable::getLatestValue() const {
+    if (compressed) {
+        return compressed->size() ? compressed->latest().value : stoi(name.substr(1)) * 10;
+    }
+    if (blocks.empty()) {
+        return stoi(name.substr(1)) * 10;
+    }
+    return blocks.back()->values[blocks.back()->count - 1];
+}
+
+// Description: Returns the commit time of the most recent version
+// Input: None
+// Output: long - latest commit time, or 0 if there is no version
+// Side Effects: None
+long Variable::getLatestCommitTime() const {
+    if (compressed) {
+        return compressed->size() ? compressed->latest().commitTime : 0;
+    }
+    return blocks.empty() ? 0 : blocks.back()->commitTimes[blocks.back()->count - 1];
 }
 
 // Description: Checks if variable has been modified after given timestamp
@@ -57,18 +172,260 @@ int Variable::readValue(long timestamp) const {
 // Output: bool - true if modified after timestamp
 // Side Effects: None
 bool Variable::wasModifiedAfter(long timestamp) const {
-    for (const auto& version : versions) {
-        if (version.commitTime > timestamp) {
-            return true;
-        }
-    }
-    return false;
+    // Commit times only grow, so the newest version decides
+    return getLatestCommitTime() > timestamp;
 }
 
 // Description: Creates new version of variable with value and commit time
 // Input: value (int) - new value, commitTime (long) - commit timestamp
 // Output: None
-// Side Effects: Adds new version to version history
+// Side Effects: Adds new version to version history, may take a block from the slab
 void Variable::writeValue(int value, long commitTime) {
-    versions.push_back({value, commitTime});
-}
\ No newline at end of file
+    if (compressed) {
+        compressed->append(value, commitTime);
+        return;
+    }
+    if (blocks.empty() || blocks.back()->count == VERSIONS_PER_BLOCK) {
+        blocks.push_back(allocateBlock());
+        blockStarts.push_back(commitTime);
+        if (!spillOffsets.empty()) {
+            spillOffsets.push_back(-1);
+        }
+    }
+    VersionBlock* block = blocks.back();
+    block->commitTimes[block->count] = commitTime;
+    block->values[block->count] = value;
+    ++block->count;
+}
+
+// Description: Copies the tail of the history committed after a given time
+// Input: afterTime (long) - versions at or before this time are skipped
+// Output: out (vector<Version>) - receives the newer versions in commit order
+// Side Effects: Appends to out
+void Variable::collectVersionsAfter(long afterTime, vector<Version>& out) const {
+    if (compressed) {
+        compressed->collectAfter(afterTime, out);
+        return;
+    }
+    // Walk backwards to the first block that still holds newer versions
+    size_t b = blocks.size();
+    while (b > 0 && blockStarts[b - 1] > afterTime) {
+        --b;
+    }
+    if (b > 0) {
+        --b;
+    }
+    for (; b < blocks.size(); ++b) {
+        const VersionBlock* block = residentBlock(b);
+        for (int i = 0; i < block->count; ++i) {
+            if (block->commitTimes[i] > afterTime) {
+                out.push_back({block->values[i], block->commitTimes[i]});
+            }
+        }
+    }
+}
+
+// Description: Returns the number of versions kept for this variable
+// Input: None
+// Output: size_t - version count
+// Side Effects: None
+size_t Variable::getVersionCount() const {
+    if (compressed) {
+        return compressed->size();
+    }
+    if (blocks.empty()) {
+        return 0;
+    }
+    return (blocks.size() - 1) * VERSIONS_PER_BLOCK + blocks.back()->count;
+}
+
+// Description: Applies a retention policy to the history
+// Input: keepTimes (vector<long>) - protected timestamps in ascending order
+// Output: size_t - number of versions dropped
+// Side Effects: Compacts the surviving versions to the front and returns emptied blocks to the slab;
+//               spilled blocks are paged in first
+size_t Variable::pruneVersions(const vector<long>& keepTimes) {
+    if (compressed) {
+        return compressed->prune(keepTimes);
+    }
+    size_t total = getVersionCount();
+    vector<long> keep;
+    for (long time : keepTimes) {
+        long position = findVersion(time);
+        if (position >= 0 && (keep.empty() || keep.back() != position)) {
+            keep.push_back(position);
+        }
+    }
+    if (total > 0 && (keep.empty() || keep.back() != static_cast<long>(total) - 1)) {
+        keep.push_back(static_cast<long>(total) - 1);
+    }
+    if (keep.size() == total) {
+        return 0;
+    }
+    pageInAll();
+
+    // Survivors only move towards the front, so the history can be compacted in place
+    for (size_t to = 0; to < keep.size(); ++to) {
+        const VersionBlock* source = blocks[keep[to] / VERSIONS_PER_BLOCK];
+        VersionBlock* target = blocks[to / VERSIONS_PER_BLOCK];
+        int from = static_cast<int>(keep[to] % VERSIONS_PER_BLOCK);
+        target->commitTimes[to % VERSIONS_PER_BLOCK] = source->commitTimes[from];
+        target->values[to % VERSIONS_PER_BLOCK] = source->values[from];
+    }
+    size_t used = (keep.size() + VERSIONS_PER_BLOCK - 1) / VERSIONS_PER_BLOCK;
+    for (size_t b = used; b < blocks.size(); ++b) {
+        freeBlock(blocks[b]);
+    }
+    blocks.resize(used);
+    blockStarts.resize(used);
+    for (size_t b = 0; b < used; ++b) {
+        blocks[b]->count = b + 1 < used ? VERSIONS_PER_BLOCK
+                                        : static_cast<int>(keep.size() - b * VERSIONS_PER_BLOCK);
+        blockStarts[b] = blocks[b]->commitTimes[0];
+    }
+    return total - keep.size();
+}
+
+// Description: Switches the history between slab blocks and the compressed store
+// Input: enabled (bool) - compress if true, interner (BlockInterner*) - where full compressed blocks are shared
+// Output: None
+// Side Effects: Re-encodes every version and releases the storage of the old form
+void Variable::setCompressed(bool enabled, BlockInterner* interner) {
+    if (enabled == (compressed != nullptr)) {
+        return;
+    }
+    vector<Version> versions;
+    collectVersionsAfter(numeric_limits<long>::min(), versions);
+    if (enabled) {
+        releaseBlocks();
+        compressed.reset(new CompressedHistory(interner));
+    } else {
+        compressed.reset();
+    }
+    for (const auto& version : versions) {
+        writeValue(version.value, version.commitTime);
+    }
+}
+
+// Description: Checks which store holds the history
+// Input: None
+// Output: bool - true if compressed
+// Side Effects: None
+bool Variable::isCompressed() const {
+    return compressed != nullptr;
+}
+
+// Description: Estimates the memory held by the history
+// Input: None
+// Output: size_t - bytes of resident version blocks and search index; shared compressed blocks count in full
+// Side Effects: None
+size_t Variable::getVersionBytes() const {
+    if (compressed) {
+        return compressed->getBytes();
+    }
+    return (blocks.size() - spilledBlocks) * sizeof(VersionBlock) + blocks.capacity() * sizeof(VersionBlock*) +
+           blockStarts.capacity() * sizeof(long) + spillOffsets.capacity() * sizeof(long);
+}
+
+// Description: Moves cold blocks out of memory
+// Input: horizon (long) - no read at or after it may need a spilled block, file (SpillFile&) - where
+//        they go, bytesWanted (size_t) - stop once this much is spilled
+// Output: size_t - bytes spilled
+// Side Effects: Writes blocks to file and returns them to the slab; the latest block and compressed
+//               histories always stay in memory
+size_t Variable::spillColdBlocks(long horizon, SpillFile& file, size_t bytesWanted) {
+    if (compressed || (spill && spill != &file)) {
+        return 0;
+    }
+    size_t spilled = 0;
+    // A block is cold once the next block starts at or before horizon, as every version in it is superseded
+    for (size_t b = 0; b + 1 < blocks.size() && blockStarts[b + 1] <= horizon && spilled < bytesWanted; ++b) {
+        if (!blocks[b]) {
+            continue;
+        }
+        if (spillOffsets.empty()) {
+            spillOffsets.assign(blocks.size(), -1);
+        }
+        spillOffsets[b] = file.write(blocks[b]);
+        freeBlock(blocks[b]);
+        blocks[b] = nullptr;
+        ++spilledBlocks;
+        spill = &file;
+        spilled += sizeof(VersionBlock);
+    }
+    return spilled;
+}
+
+// Description: Returns the size of the spilled part of the history
+// Input: None
+// Output: size_t - bytes on disk
+// Side Effects: None
+size_t Variable::getSpilledBytes() const {
+    return spilledBlocks * sizeof(VersionBlock);
+}
+
+// Description: Returns a block, reading it back from disk if it was spilled
+// Input: b (size_t) - block position
+// Output: const VersionBlock* - the block, in memory
+// Side Effects: A spilled block is paged in and its slot in the spill file freed
+const VersionBlock* Variable::residentBlock(size_t b) const {
+    if (!blocks[b]) {
+        VersionBlock* block = allocateBlock();
+        spill->read(spillOffsets[b], block);
+        blocks[b] = block;
+        spillOffsets[b] = -1;
+        --spilledBlocks;
+    }
+    return blocks[b];
+}
+
+// Description: Brings the whole history back into memory
+// Input: None
+// Output: None
+// Side Effects: Pages in every spilled block
+void Variable::pageInAll() {
+    for (size_t b = 0; spilledBlocks > 0 && b < blocks.size(); ++b) {
+        residentBlock(b);
+    }
+    spillOffsets.clear();
+}
+
+// Description: Obtains an empty version block
+// Input: None
+// Output: VersionBlock* - block with count 0
+// Side Effects: Allocates from the slab, or the heap when there is none
+VersionBlock* Variable::allocateBlock() const {
+    VersionBlock* block = slab ? static_cast<VersionBlock*>(slab->allocate()) : new VersionBlock;
+    block->count = 0;
+    return block;
+}
+
+// Description: Frees a version block
+// Input: block (VersionBlock*)
+// Output: None
+// Side Effects: Returns it to the slab, or the heap when there is none
+void Variable::freeBlock(VersionBlock* block) const {
+    if (slab) {
+        slab->deallocate(block);
+    } else {
+        delete block;
+    }
+}
+
+// Description: Returns every version block to where it came from
+// Input: None
+// Output: None
+// Side Effects: Empties the version history and frees its slots in the spill file
+void Variable::releaseBlocks() {
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b]) {
+            freeBlock(blocks[b]);
+        } else {
+            spill->release(spillOffsets[b]);
+        }
+    }
+    blocks.clear();
+    blockStarts.clear();
+    spillOffsets.clear();
+    spilledBlocks = 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:33:20
+ */
+
+#include "ShmRing.h"
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+using namespace std;
+
+namespace
+{
+    // Yields before parking; the peer usually answers within a few of its time slices
+    const int SPIN_ROUNDS = 64;
+
+    // Longest single futex sleep; bounds the cost of a lost wake-up
+    const long MAX_PARK_MICROS = 10000;
+
+    uint32_t *futexWord(atomic<uint32_t> &word)
+    {
+        return reinterpret_cast<uint32_t *>(&word);
+    }
+}
+
+// Description: Creates an empty ring
+// Input: None
+// Output: None
+// Side Effects: None
+ShmRing::ShmRing() : head(0), tail(0), reservedTail(0), wakeups(0), sleeping(0)
+{
+}
+
+// Description: Hands the producer the next free slot
+// Input: None
+// Output: SiteMessage* - slot to fill, or null when the ring is full
+// Side Effects: The slot is reserved but stays invisible until publish()
+SiteMessage *ShmRing::reserve()
+{
+    if (reservedTail - head.load(memory_order_acquire) >= CAPACITY)
+    {
+        return nullptr;
+    }
+    return &slots[reservedTail++ & (CAPACITY - 1)];
+}
+
+// Description: Publishes every reserved slot in one step
+// Input: None
+// Output: None
+// Side Effects: Consumer may read the messages; a sleeping consumer is woken
+void ShmRing::publish()
+{
+    if (tail.load(memory_order_relaxed) == reservedTail)
+    {
+        return;
+    }
+    tail.store(reservedTail, memory_order_seq_cst);
+    wake();
+}
+
+// Description: Counts slots reserved since the last publish
+// Input: None
+// Output: uint32_t - unpublished slot count
+// Side Effects: None
+uint32_t ShmRing::unpublished() const
+{
+    return static_cast<uint32_t>(reservedTail - tail.load(memory_order_relaxed));
+}
+
+// Description: Counts messages the consumer has not released yet
+// Input: None
+// Output: uint32_t - available message count
+// Side Effects: None
+uint32_t ShmRing::available() const
+{
+    return static_cast<uint32_t>(tail.load(memory_order_acquire) - head.load(memory_order_relaxed));
+}
+
+// Description: Returns an available message without copying it
+// Input: i - offset from the oldest available message
+// Output: Reference to the slot
+// Side Effects: None
+const SiteMessage &ShmRing::peek(uint32_t i) const
+{
+    return slots[(head.load(memory_order_relaxed) + i) & (CAPACITY - 1)];
+}
+
+// Description: Frees consumed slots
+// Input: n - number of messages consumed
+// Output: None
+// Side Effects: Producer may reuse the slots; a producer waiting for space is woken
+void ShmRing::release(uint32_t n)
+{
+    head.store(head.load(memory_order_relaxed) + n, memory_order_seq_cst);
+    wake();
+}
+
+// Description: Blocks the consumer until a message arrives
+// Input: timeoutMicros - limit, negative to wait indefinitely
+// Output: bool - true if messages are available
+// Side Effects: May sleep on the futex
+bool ShmRing::waitForMessages(long timeoutMicros)
+{
+    return park([this]() { return available() > 0; }, timeoutMicros);
+}
+
+// Description: Blocks the producer until a slot is free
+// Input: timeoutMicros - limit, negative to wait indefinitely
+// Output: bool - true if a slot is free
+// Side Effects: May sleep on the futex
+bool ShmRing::waitForSpace(long timeoutMicros)
+{
+    return park([this]() { return reservedTail - head.load(memory_order_acquire) < CAPACITY; }, timeoutMicros);
+}
+
+// Description: Spins briefly, then sleeps on the futex until ready() holds
+// Input: ready - condition to wait for, timeoutMicros - limit, negative for none
+// Output: bool - final value of ready()
+// Side Effects: Sets the sleeping flag while parked
+template <typename Ready>
+bool ShmRing::park(Ready ready, long timeoutMicros)
+{
+    for (int i = 0; i < SPIN_ROUNDS; ++i)
+    {
+        if (ready())
+        {
+            return true;
+        }
+        sched_yield();
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::microseconds(timeoutMicros);
+    while (!ready())
+    {
+        long sleepMicros = MAX_PARK_MICROS;
+        if (timeoutMicros >= 0)
+        {
+            long left = chrono::duration_cast<chrono::microseconds>(deadline - chrono::steady_clock::now()).count();
+            if (left <= 0)
+            {
+                return ready();
+            }
+            sleepMicros = left < sleepMicros ? left : sleepMicros;
+        }
+
+        uint32_t seen = wakeups.load(memory_order_seq_cst);
+        sleeping.store(1, memory_order_seq_cst);
+        // The peer publishes before checking the flag, so a re-check here cannot miss it
+        if (ready())
+        {
+            sleeping.store(0, memory_order_relaxed);
+            return true;
+        }
+        timespec timeout;
+        timeout.tv_sec = sleepMicros / 1000000;
+        timeout.tv_nsec = (sleepMicros % 1000000) * 1000;
+        syscall(SYS_futex, futexWord(wakeups), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+        sleeping.store(0, memory_order_relaxed);
+    }
+    return true;
+}
+
+// Description: Wakes the peer if it is parked on this ring
+// Input: None
+// Output: None
+// Side Effects: Bumps the futex word and issues a wake syscall
+void ShmRing::wake()
+{
+    if (sleeping.load(memory_order_seq_cst))
+    {
+        wakeups.fetch_add(1, memory_order_seq_cst);
+        syscall(SYS_futex, futexWord(wakeups), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
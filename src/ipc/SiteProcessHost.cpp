@@ -0,0 +1,373 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:34:10
+ */
+
+#include "SiteProcessHost.h"
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+namespace
+{
+    // How long the coordinator waits on a ring before checking that the site process is alive
+    const long LIVENESS_CHECK_MICROS = 10000;
+
+    string variableName(int variableIndex)
+    {
+        return "x" + to_string(variableIndex);
+    }
+}
+
+// Description: Creates a host with no running site processes
+// Input: placement - sites holding each variable
+// Output: None
+// Side Effects: None
+SiteProcessHost::SiteProcessHost(const ReplicaLists &placement) : placement(placement), stats{0, 0, 0, 0, 0.0}
+{
+}
+
+// Description: Asks every site process to exit and reaps it
+// Input: None
+// Output: None
+// Side Effects: Terminates child processes, unmaps shared memory
+SiteProcessHost::~SiteProcessHost()
+{
+    for (auto &entry : channels)
+    {
+        SiteMessage *slot = entry.second.requests->reserve();
+        if (slot)
+        {
+            slot->type = SiteMessageType::SHUTDOWN;
+            entry.second.requests->publish();
+        }
+        else
+        {
+            kill(entry.second.pid, SIGKILL);
+        }
+        release(entry.second);
+    }
+}
+
+// Description: Spawns a site process connected by a fresh pair of rings
+// Input: site - coordinator's image of the site, copied into the new process
+// Output: None
+// Side Effects: Creates a shared memory segment and a child process, queues seed writes
+void SiteProcessHost::start(Site &site)
+{
+    int siteId = site.getId();
+    if (isRunning(siteId))
+    {
+        return;
+    }
+
+    // The name only lives until both sides have mapped the segment
+    string name = "/repcrec-" + to_string(getpid()) + "-site" + to_string(siteId);
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        throw runtime_error("Cannot create shared memory for site " + to_string(siteId));
+    }
+    shm_unlink(name.c_str());
+    size_t size = 2 * sizeof(ShmRing);
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+    {
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw runtime_error("Cannot map shared memory for site " + to_string(siteId));
+    }
+
+    Channel channel;
+    channel.mapping = mapping;
+    channel.requests = new (mapping) ShmRing();
+    channel.replies = new (static_cast<char *>(mapping) + sizeof(ShmRing)) ShmRing();
+    channel.pid = fork();
+    if (channel.pid < 0)
+    {
+        munmap(mapping, size);
+        throw runtime_error("Cannot start process for site " + to_string(siteId));
+    }
+    if (channel.pid == 0)
+    {
+        // Do not outlive the coordinator
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        serve(siteId, placement, channel.requests, channel.replies);
+    }
+    channels[siteId] = channel;
+    ++stats.processesStarted;
+
+    // Seed the new process with the site's durable image; initial values come from its constructor
+    map<string, long> everything;
+    for (int i = 1; i <= 20; ++i)
+    {
+        if (site.hasVariable(variableName(i)))
+        {
+            everything[variableName(i)] = 0;
+        }
+    }
+    for (const auto &tail : site.collectVersionTails(everything))
+    {
+        int variableIndex = stoi(tail.first.substr(1));
+        for (const auto &version : tail.second)
+        {
+            queueWrite(siteId, variableIndex, version.value, version.commitTime);
+        }
+    }
+    flush();
+}
+
+// Description: Kills a site process, as a crash of the site would
+// Input: siteId
+// Output: None
+// Side Effects: Sends SIGKILL, reaps the child, unmaps its rings
+void SiteProcessHost::stop(int siteId)
+{
+    auto it = channels.find(siteId);
+    if (it == channels.end())
+    {
+        return;
+    }
+    kill(it->second.pid, SIGKILL);
+    release(it->second);
+    channels.erase(it);
+}
+
+// Description: Checks that a site process exists and has not exited on its own
+// Input: siteId
+// Output: bool - true if the process is alive
+// Side Effects: Cleans up after a process that died
+bool SiteProcessHost::isRunning(int siteId)
+{
+    auto it = channels.find(siteId);
+    if (it == channels.end())
+    {
+        return false;
+    }
+    if (waitpid(it->second.pid, nullptr, WNOHANG) == 0)
+    {
+        return true;
+    }
+    it->second.pid = -1;
+    release(it->second);
+    channels.erase(it);
+    return false;
+}
+
+// Description: Writes an APPLY_WRITE request into a site's ring without publishing it
+// Input: siteId, variableIndex, value, commitTime
+// Output: None
+// Side Effects: Ignored when the site has no process (it is down)
+void SiteProcessHost::queueWrite(int siteId, int variableIndex, int value, long commitTime)
+{
+    auto it = channels.find(siteId);
+    if (it == channels.end())
+    {
+        return;
+    }
+    SiteMessage *slot = reserveRequest(siteId, it->second);
+    slot->type = SiteMessageType::APPLY_WRITE;
+    slot->variableIndex = variableIndex;
+    slot->value = value;
+    slot->timestamp = commitTime;
+}
+
+// Description: Publishes the queued requests of every site
+// Input: None
+// Output: None
+// Side Effects: Wakes site processes that have new work
+void SiteProcessHost::flush()
+{
+    for (auto &entry : channels)
+    {
+        publish(entry.second);
+    }
+}
+
+// Description: Reads variables from a site process with one request batch and one reply batch
+// Input: siteId, variableIndices, timestamp - snapshot time
+// Output: Versions in the order of variableIndices
+// Side Effects: Publishes pending writes first; throws if the process is gone or a read fails
+vector<Version> SiteProcessHost::readVersions(int siteId, const vector<int> &variableIndices, long timestamp)
+{
+    auto start = chrono::steady_clock::now();
+    vector<Version> versions;
+    versions.reserve(variableIndices.size());
+    size_t sent = 0;
+    while (versions.size() < variableIndices.size())
+    {
+        auto it = channels.find(siteId);
+        if (it == channels.end())
+        {
+            throw runtime_error("Site " + to_string(siteId) + " has no running process");
+        }
+        Channel &channel = it->second;
+
+        // Send as many reads as the reply ring can hold, then collect their answers
+        size_t batchEnd = sent + ShmRing::CAPACITY;
+        if (batchEnd > variableIndices.size())
+        {
+            batchEnd = variableIndices.size();
+        }
+        for (; sent < batchEnd; ++sent)
+        {
+            SiteMessage *slot = reserveRequest(siteId, channel);
+            slot->type = SiteMessageType::READ;
+            slot->variableIndex = variableIndices[sent];
+            slot->timestamp = timestamp;
+        }
+        publish(channel);
+
+        bool failed = false;
+        while (versions.size() < sent)
+        {
+            if (!channel.replies->waitForMessages(LIVENESS_CHECK_MICROS))
+            {
+                if (!isRunning(siteId))
+                {
+                    throw runtime_error("Site " + to_string(siteId) + " process exited");
+                }
+                continue;
+            }
+            uint32_t count = channel.replies->available();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const SiteMessage &reply = channel.replies->peek(i);
+                failed = failed || reply.type == SiteMessageType::READ_FAILED;
+                versions.push_back(Version{reply.value, reply.timestamp});
+            }
+            channel.replies->release(count);
+        }
+        if (failed)
+        {
+            throw runtime_error("Site " + to_string(siteId) + " could not serve the read");
+        }
+    }
+    ++stats.readRoundTrips;
+    stats.totalReadMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    return versions;
+}
+
+// Description: Returns cross-process traffic counters
+// Input: None
+// Output: SiteProcessStats
+// Side Effects: None
+const SiteProcessStats &SiteProcessHost::getStats() const
+{
+    return stats;
+}
+
+// Description: Counts site processes currently started
+// Input: None
+// Output: size_t - number of processes
+// Side Effects: None
+size_t SiteProcessHost::getRunningCount() const
+{
+    return channels.size();
+}
+
+// Description: Gets a free request slot, draining the ring through the site if it is full
+// Input: siteId, channel
+// Output: SiteMessage* - slot to fill
+// Side Effects: May publish early and block; throws if the process died meanwhile
+SiteMessage *SiteProcessHost::reserveRequest(int siteId, Channel &channel)
+{
+    SiteMessage *slot = channel.requests->reserve();
+    while (!slot)
+    {
+        publish(channel);
+        if (!channel.requests->waitForSpace(LIVENESS_CHECK_MICROS) && !isRunning(siteId))
+        {
+            throw runtime_error("Site " + to_string(siteId) + " process exited");
+        }
+        slot = channel.requests->reserve();
+    }
+    ++stats.messagesSent;
+    return slot;
+}
+
+// Description: Publishes one site's request ring
+// Input: channel
+// Output: None
+// Side Effects: Counts a batch when something was pending
+void SiteProcessHost::publish(Channel &channel)
+{
+    if (channel.requests->unpublished() > 0)
+    {
+        channel.requests->publish();
+        ++stats.batchesPublished;
+    }
+}
+
+// Description: Reaps a site process and unmaps its rings
+// Input: channel
+// Output: None
+// Side Effects: Blocks until the process has exited
+void SiteProcessHost::release(Channel &channel)
+{
+    if (channel.pid > 0)
+    {
+        waitpid(channel.pid, nullptr, 0);
+    }
+    munmap(channel.mapping, 2 * sizeof(ShmRing));
+}
+
+// Description: Serves requests for one site until told to shut down
+// Input: siteId, placement, requests, replies - rings shared with the coordinator
+// Output: None (exits the process)
+// Side Effects: Owns the site's data inside this process
+void SiteProcessHost::serve(int siteId, const ReplicaLists &placement, ShmRing *requests, ShmRing *replies)
+{
+    Site site(siteId, placement);
+    while (true)
+    {
+        requests->waitForMessages(-1);
+        uint32_t count = requests->available();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const SiteMessage &request = requests->peek(i);
+            if (request.type == SiteMessageType::SHUTDOWN)
+            {
+                _exit(0);
+            }
+            if (request.type == SiteMessageType::APPLY_WRITE)
+            {
+                site.writeVariable(variableName(request.variableIndex), request.value, request.timestamp);
+                continue;
+            }
+
+            SiteMessage *reply = replies->reserve();
+            while (!reply)
+            {
+                replies->publish();
+                replies->waitForSpace(-1);
+                reply = replies->reserve();
+            }
+            try
+            {
+                Version version = site.readVersion(variableName(request.variableIndex), request.timestamp);
+                reply->type = SiteMessageType::READ_REPLY;
+                reply->value = version.value;
+                reply->timestamp = version.commitTime;
+            }
+            catch (const runtime_error &)
+            {
+                reply->type = SiteMessageType::READ_FAILED;
+            }
+            reply->variableIndex = request.variableIndex;
+        }
+        requests->release(count);
+        replies->publish();
+    }
+}
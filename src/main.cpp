@@ -5,14 +5,15 @@
  */
 
 // Description: Main entry point for distributed database system. Handles command input
-// processing from either stdin or file input, and coordinates system components.
+// processing from either stdin or file input and runs it against the library, printing
+// its messages. Files are parsed by parallel threads ahead of execution.
 #include <iostream>
-#include <fstream>
 #include <memory>
+#include <stdexcept>
 #include <string>
-#include "TransactionManager.h"
-#include "DataManager.h"
 #include "CommandParser.h"
+#include "Database.h"
+#include "TraceReader.h"
 using namespace std;
 
 // Description: Main program entry point
@@ -20,36 +21,38 @@ using namespace std;
 // Output: int - 0 for success, 1 for file error
 // Side Effects: Processes commands, manages database state
 int main(int argc, char* argv[]) {
-    auto dataManager = make_shared<DataManager>();
-    TransactionManager transactionManager(dataManager);
-    CommandParser parser(transactionManager);
+    Database database;
+    database.setOutput(&cout);
 
-    istream* input = &cin;
-    ifstream inputFile;
     if (argc > 1) {
-        inputFile.open(argv[1]);
-        if (!inputFile.is_open()) {
+        // Parser threads work ahead on the mapped file while commands execute in file order
+        unique_ptr<TraceReader> reader;
+        try {
+            reader.reset(new TraceReader(argv[1]));
+        } catch (const runtime_error&) {
             cerr << "Failed to open input file '" << argv[1] << "'.\n";
             return 1;
         }
-        input = &inputFile;
+        Command command;
+        while (reader->next(command)) {
+            database.execute(command);
+            // Flush output after each command to ensure sequential output
+            cout.flush();
+        }
+        return 0;
     }
 
     string command;
-    while (getline(*input, command)) {
+    while (getline(cin, command)) {
         // Skip empty lines or comments
-        if (command.empty() || command[0] == '/') {
+        if (CommandParser::isSkipped(command.data(), command.size())) {
             continue;
         }
         // Process each command immediately
-        parser.parseCommand(command);
+        database.execute(command);
         // Flush output after each command to ensure sequential output
         cout.flush();
     }
 
-    if (inputFile.is_open()) {
-        inputFile.close();
-    }
-
     return 0;
 }
\ No newline at end of file
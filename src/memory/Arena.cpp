@@ -0,0 +1,79 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:14:20
+ */
+
+#include "Arena.h"
+#include <cstdint>
+using namespace std;
+
+// Description: Creates an arena positioned at its inline buffer
+// Input: blockSize (size_t) - minimum size of overflow blocks
+// Output: None
+// Side Effects: None
+Arena::Arena(size_t blockSize)
+    : cursor(inlineBuffer),
+      limit(inlineBuffer + INLINE_BYTES),
+      blocks(nullptr),
+      blockSize(blockSize),
+      overflowBlocks(0) {}
+
+// Description: Destroys the arena
+// Input: None
+// Output: None
+// Side Effects: Frees all overflow blocks
+Arena::~Arena()
+{
+    reset();
+}
+
+// Description: Bump-allocates aligned storage, chaining a new block when full
+// Input: bytes (size_t), alignment (size_t) - power of two
+// Output: void* - storage valid until reset()
+// Side Effects: May allocate an overflow block from the heap
+void *Arena::allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (aligned + bytes > reinterpret_cast<uintptr_t>(limit))
+    {
+        size_t size = bytes + alignment > blockSize ? bytes + alignment : blockSize;
+        void *raw = ::operator new(sizeof(Block) + size);
+        Block *block = static_cast<Block *>(raw);
+        block->next = blocks;
+        block->size = size;
+        blocks = block;
+        ++overflowBlocks;
+        cursor = reinterpret_cast<unsigned char *>(block + 1);
+        limit = cursor + size;
+        aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    cursor = reinterpret_cast<unsigned char *>(aligned + bytes);
+    return reinterpret_cast<void *>(aligned);
+}
+
+// Description: Releases everything allocated from the arena in one step
+// Input: None
+// Output: None
+// Side Effects: Frees overflow blocks, rewinds to the inline buffer
+void Arena::reset()
+{
+    while (blocks)
+    {
+        Block *next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+    overflowBlocks = 0;
+    cursor = inlineBuffer;
+    limit = inlineBuffer + INLINE_BYTES;
+}
+
+// Description: Returns how many heap blocks the arena currently holds
+// Input: None
+// Output: size_t - overflow block count
+// Side Effects: None
+size_t Arena::getOverflowBlockCount() const
+{
+    return overflowBlocks;
+}
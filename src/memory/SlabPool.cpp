@@ -0,0 +1,117 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:14:35
+ */
+
+#include "SlabPool.h"
+using namespace std;
+
+// Description: Creates an empty pool; pages are allocated on first use
+// Input: chunkSize (size_t), chunksPerPage (size_t)
+// Output: None
+// Side Effects: None
+SlabPool::SlabPool(size_t chunkSize, size_t chunksPerPage)
+    : chunkSize(0),
+      chunksPerPage(chunksPerPage ? chunksPerPage : 1),
+      freeList(nullptr),
+      liveChunks(0),
+      reservedBytes(0)
+{
+    // Chunks must hold a free-list link and keep every chunk max-aligned
+    size_t align = alignof(max_align_t);
+    size_t size = chunkSize < sizeof(FreeChunk) ? sizeof(FreeChunk) : chunkSize;
+    this->chunkSize = (size + align - 1) / align * align;
+}
+
+// Description: Destroys the pool
+// Input: None
+// Output: None
+// Side Effects: Frees every page, including chunks still handed out
+SlabPool::~SlabPool()
+{
+    for (unsigned char *page : pages)
+    {
+        ::operator delete(page);
+    }
+}
+
+// Description: Hands out one chunk
+// Input: None
+// Output: void* - chunk of getChunkSize() bytes
+// Side Effects: May allocate a new page
+void *SlabPool::allocate()
+{
+    if (!freeList)
+    {
+        grow();
+    }
+    FreeChunk *chunk = freeList;
+    freeList = chunk->next;
+    ++liveChunks;
+    return chunk;
+}
+
+// Description: Returns a chunk to the free list
+// Input: chunk (void*) - pointer previously returned by allocate
+// Output: None
+// Side Effects: Updates free list
+void SlabPool::deallocate(void *chunk)
+{
+    if (!chunk)
+    {
+        return;
+    }
+    FreeChunk *node = static_cast<FreeChunk *>(chunk);
+    node->next = freeList;
+    freeList = node;
+    --liveChunks;
+}
+
+// Description: Returns the size of each chunk
+// Input: None
+// Output: size_t - bytes per chunk
+// Side Effects: None
+size_t SlabPool::getChunkSize() const
+{
+    return chunkSize;
+}
+
+// Description: Returns the number of chunks in use
+// Input: None
+// Output: size_t - live chunk count
+// Side Effects: None
+size_t SlabPool::getLiveChunks() const
+{
+    return liveChunks;
+}
+
+// Description: Returns the number of bytes reserved by the pool
+// Input: None
+// Output: size_t - page bytes
+// Side Effects: None
+size_t SlabPool::getReservedBytes() const
+{
+    return reservedBytes;
+}
+
+// Description: Allocates a page and pushes its chunks onto the free list
+// Input: None
+// Output: None
+// Side Effects: Allocates heap memory, doubles the next page size, throws bad_alloc on failure
+void SlabPool::grow()
+{
+    unsigned char *page = static_cast<unsigned char *>(::operator new(chunkSize * chunksPerPage));
+    pages.push_back(page);
+    reservedBytes += chunkSize * chunksPerPage;
+    for (size_t i = chunksPerPage; i-- > 0;)
+    {
+        FreeChunk *node = reinterpret_cast<FreeChunk *>(page + i * chunkSize);
+        node->next = freeList;
+        freeList = node;
+    }
+    if (chunksPerPage < MAX_PAGE_CHUNKS)
+    {
+        chunksPerPage *= 2;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:55:00
+ */
+
+#include "SpillFile.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+using namespace std;
+
+// Description: Creates and unlinks the segment file
+// Input: segmentBytes - size of every segment
+// Output: None
+// Side Effects: Throws runtime_error if the file cannot be created
+SpillFile::SpillFile(size_t segmentBytes)
+    : fd(-1), segmentBytes(segmentBytes), fileEnd(0), stats{0, 0, 0, 0}
+{
+    const char *directory = getenv("TMPDIR");
+    string path = string(directory && *directory ? directory : "/tmp") + "/repcrec-spill-XXXXXX";
+    fd = mkstemp(&path[0]);
+    if (fd < 0)
+    {
+        throw runtime_error("Cannot create spill file " + path);
+    }
+    // Nothing else needs the name, and the space is reclaimed however the process ends
+    unlink(path.c_str());
+}
+
+// Description: Closes the file
+// Input: None
+// Output: None
+// Side Effects: The system frees the unlinked file
+SpillFile::~SpillFile()
+{
+    close(fd);
+}
+
+// Description: Spills one segment
+// Input: segment - segmentBytes to write
+// Output: long - offset to read it back from
+// Side Effects: Takes a free slot or extends the file; throws runtime_error on a short write
+long SpillFile::write(const void *segment)
+{
+    lock_guard<mutex> lock(fileMutex);
+    long offset;
+    if (!freeSlots.empty())
+    {
+        offset = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        offset = fileEnd;
+        fileEnd += static_cast<long>(segmentBytes);
+    }
+    if (pwrite(fd, segment, segmentBytes, offset) != static_cast<ssize_t>(segmentBytes))
+    {
+        freeSlots.push_back(offset);
+        throw runtime_error("Cannot write spill file");
+    }
+    ++stats.segmentsWritten;
+    ++stats.segmentsHeld;
+    return offset;
+}
+
+// Description: Pages a segment back in
+// Input: offset - as returned by write; segment - receives segmentBytes
+// Output: None
+// Side Effects: Frees the slot; throws runtime_error on a short read
+void SpillFile::read(long offset, void *segment)
+{
+    lock_guard<mutex> lock(fileMutex);
+    if (pread(fd, segment, segmentBytes, offset) != static_cast<ssize_t>(segmentBytes))
+    {
+        throw runtime_error("Cannot read spill file");
+    }
+    freeSlots.push_back(offset);
+    ++stats.segmentsRead;
+    --stats.segmentsHeld;
+}
+
+// Description: Drops a spilled segment without reading it
+// Input: offset - as returned by write
+// Output: None
+// Side Effects: Frees the slot
+void SpillFile::release(long offset)
+{
+    lock_guard<mutex> lock(fileMutex);
+    freeSlots.push_back(offset);
+    --stats.segmentsHeld;
+}
+
+// Description: Returns the segment size
+// Input: None
+// Output: size_t - bytes per segment
+// Side Effects: None
+size_t SpillFile::getSegmentBytes() const
+{
+    return segmentBytes;
+}
+
+// Description: Returns the counters
+// Input: None
+// Output: SpillStats
+// Side Effects: None
+SpillStats SpillFile::getStats() const
+{
+    lock_guard<mutex> lock(fileMutex);
+    SpillStats current = stats;
+    current.fileBytes = static_cast<size_t>(fileEnd);
+    return current;
+}
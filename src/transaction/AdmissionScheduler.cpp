@@ -0,0 +1,161 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:44:50
+ */
+
+#include "AdmissionScheduler.h"
+using namespace std;
+
+// Description: Creates a scheduler with no heat and no claims
+// Input: hotThreshold, decay - see the header
+// Output: None
+// Side Effects: None
+AdmissionScheduler::AdmissionScheduler(double hotThreshold, double decay)
+    : hotThreshold(hotThreshold), decay(decay), stats{0, 0, 0, 0}
+{
+}
+
+// Description: Decides whether a transaction may start
+// Input: transactionName, accessSet - declared or predicted variables,
+//        blockingVariable - receives the hot variable that is in use
+// Output: bool - true if admitted, in which case its hot variables are claimed
+// Side Effects: Updates claims and counters
+bool AdmissionScheduler::tryAdmit(const string &transactionName, const vector<string> &accessSet,
+                                  string &blockingVariable)
+{
+    for (const auto &variableName : accessSet)
+    {
+        auto claim = claims.find(variableName);
+        if (isHot(variableName) && claim != claims.end() && claim->second != transactionName)
+        {
+            blockingVariable = variableName;
+            return false;
+        }
+    }
+    ++stats.admitted;
+    claimed[transactionName];
+    this->claim(transactionName, accessSet);
+    return true;
+}
+
+// Description: Remembers that a transaction was held so its outcome is counted separately
+// Input: transactionName
+// Output: None
+// Side Effects: Updates counters
+void AdmissionScheduler::markHeld(const string &transactionName)
+{
+    if (heldTransactions.insert(transactionName).second)
+    {
+        ++stats.held;
+    }
+}
+
+// Description: Extends the claims of an admitted transaction
+// Input: transactionName, variables - variables it is using
+// Output: None
+// Side Effects: Hot variables nobody claims become claimed by the transaction
+void AdmissionScheduler::claim(const string &transactionName, const vector<string> &variables)
+{
+    auto owner = claimed.find(transactionName);
+    if (owner == claimed.end())
+    {
+        return;
+    }
+    for (const auto &variableName : variables)
+    {
+        if (isHot(variableName) && !claims.count(variableName))
+        {
+            claims[variableName] = transactionName;
+            owner->second.insert(variableName);
+        }
+    }
+}
+
+// Description: Learns from a finished transaction and lets go of its claims
+// Input: transactionName, committed - outcome, variables - everything it read or wrote
+// Output: None
+// Side Effects: Cools all variables, heats those of an abort, updates counters
+void AdmissionScheduler::finish(const string &transactionName, bool committed, const vector<string> &variables)
+{
+    for (auto it = heat.begin(); it != heat.end();)
+    {
+        it->second *= decay;
+        // Forget variables that have cooled off completely
+        it = it->second < 0.01 ? heat.erase(it) : next(it);
+    }
+    bool wasHeld = heldTransactions.erase(transactionName) > 0;
+    if (!committed)
+    {
+        for (const auto &variableName : variables)
+        {
+            heat[variableName] += 1.0;
+        }
+        if (wasHeld)
+        {
+            ++stats.heldAborts;
+        }
+        else
+        {
+            ++stats.otherAborts;
+        }
+    }
+
+    auto owner = claimed.find(transactionName);
+    if (owner == claimed.end())
+    {
+        return;
+    }
+    for (const auto &variableName : owner->second)
+    {
+        claims.erase(variableName);
+    }
+    claimed.erase(owner);
+}
+
+// Description: Checks if a variable keeps showing up in recent aborts
+// Input: variableName
+// Output: bool - true if its heat is at or above the threshold
+// Side Effects: None
+bool AdmissionScheduler::isHot(const string &variableName) const
+{
+    auto it = heat.find(variableName);
+    return it != heat.end() && it->second >= hotThreshold;
+}
+
+// Description: Looks up who claims a variable
+// Input: variableName
+// Output: string - transaction name, "" if unclaimed
+// Side Effects: None
+string AdmissionScheduler::getClaimant(const string &variableName) const
+{
+    auto it = claims.find(variableName);
+    return it == claims.end() ? "" : it->second;
+}
+
+// Description: Changes the hot threshold
+// Input: threshold
+// Output: None
+// Side Effects: Affects later admissions
+void AdmissionScheduler::setHotThreshold(double threshold)
+{
+    hotThreshold = threshold;
+}
+
+// Description: Returns the heat of variables
+// Input: None
+// Output: Variable -> heat
+// Side Effects: None
+const map<string, double> &AdmissionScheduler::getHeat() const
+{
+    return heat;
+}
+
+// Description: Returns admission counters
+// Input: None
+// Output: AdmissionStats
+// Side Effects: None
+const AdmissionStats &AdmissionScheduler::getStats() const
+{
+    return stats;
+}
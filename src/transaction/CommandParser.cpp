@@ -6,10 +6,11 @@
 
 #include "CommandParser.h"
 #include "TransactionManager.h"
+#include "Aggregate.h"
 #include <sstream>
-#include <iostream>
 #include <algorithm>
 #include <string>
+#include <stdexcept>
 using namespace std;
 
 // Description: Constructs command parser with transaction manager reference
@@ -70,67 +71,594 @@ vector<string> extractArguments(const string &command)
     return args;
 }
 
+// Description: Expands variable arguments, turning ranges such as "x1..x4" into each variable
+// Input: args (vector<string>) - variable arguments, possibly containing ranges
+// Output: vector<string> - individual variable names in argument order
+// Side Effects: Throws out_of_range if a range is not within x1..x20 or runs backwards
+vector<string> expandVariables(const vector<string> &args)
+{
+    vector<string> variables;
+    for (const auto &arg : args)
+    {
+        size_t dots = arg.find("..");
+        if (dots == string::npos)
+        {
+            variables.push_back(arg);
+            continue;
+        }
+        string first = trim(arg.substr(0, dots));
+        string last = trim(arg.substr(dots + 2));
+        if (last.empty() || last[0] != 'x')
+        {
+            last = "x" + last;
+        }
+        int from = stoi(first.substr(1));
+        int to = stoi(last.substr(1));
+        if (from < 1 || to > 20 || from > to)
+        {
+            throw out_of_range("Variable range " + arg);
+        }
+        for (int i = from; i <= to; ++i)
+        {
+            variables.push_back("x" + to_string(i));
+        }
+    }
+    return variables;
+}
+
 // Description: Parses and executes database commands
 // Input: command (string) - command to parse and execute
 // Output: None
 // Side Effects: Executes corresponding transaction manager operations
 void CommandParser::parseCommand(const string &command)
 {
+    execute(parse(command));
+}
+
+// Description: Checks whether main skips an input line without processing it
+// Input: line, length - the line without its newline
+// Output: bool - true for empty lines and lines starting with '/'
+// Side Effects: None
+bool CommandParser::isSkipped(const char *line, size_t length)
+{
+    return length == 0 || line[0] == '/';
+}
+
+// Description: Parses a command into its type and arguments
+// Input: command (string) - command line
+// Output: Command - NONE for blank lines, comments and commands missing arguments, UNKNOWN
+//         (with the line in text) for anything unrecognized or with malformed numbers
+// Side Effects: None; safe to call from several threads at once
+Command CommandParser::parse(const string &command)
+{
+    Command parsed;
+    parsed.type = CommandType::NONE;
+    parsed.number = 0;
+    parsed.secondNumber = 0;
+    parsed.flag = false;
+    parsed.op = AggregateOp::SCAN;
+    parsed.predicate = ScanPredicate::ALL;
+
     string trimmedCommand = trim(command);
     if (trimmedCommand.empty() || trimmedCommand[0] == '/')
-        return;
+        return parsed;
+    parsed.line = trimmedCommand;
 
-    if (trimmedCommand.substr(0, 6) == "begin(")
+    try
     {
-        string txnName = extractArgument(trimmedCommand);
-        transactionManager.beginTransaction(txnName, false);
+        if (trimmedCommand.substr(0, 6) == "begin(")
+        {
+            // begin(T1) or, declaring the variables T1 will use, begin(T1, x2, x4..x6)
+            vector<string> args = extractArguments(trimmedCommand);
+            parsed.type = CommandType::BEGIN;
+            if (args.size() > 1)
+            {
+                parsed.name = args[0];
+                parsed.names = expandVariables(vector<string>(args.begin() + 1, args.end()));
+            }
+            else
+            {
+                parsed.name = extractArgument(trimmedCommand);
+            }
+        }
+        else if (trimmedCommand.substr(0, 8) == "beginRO(")
+        {
+            parsed.type = CommandType::BEGIN_RO;
+            parsed.name = extractArgument(trimmedCommand);
+        }
+        else if (trimmedCommand.substr(0, 10) == "beginAsOf(")
+        {
+            // beginAsOf(T3, S1) reads as of snapshot S1; T2 or a timestamp works in place of S1
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() == 2)
+            {
+                parsed.type = CommandType::BEGIN_AS_OF;
+                parsed.name = args[0];
+                parsed.text = args[1];
+            }
+        }
+        else if (trimmedCommand.substr(0, 2) == "W(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() >= 2 && args[1].find('=') != string::npos)
+            {
+                // Batch form: W(T1, x2=5, x4=7) or W(T1, x2..x8=0)
+                parsed.type = CommandType::WRITE_BATCH;
+                parsed.name = args[0];
+                for (size_t i = 1; i < args.size(); ++i)
+                {
+                    size_t eq = args[i].find('=');
+                    if (eq == string::npos)
+                    {
+                        continue;
+                    }
+                    int value = stoi(args[i].substr(eq + 1));
+                    for (const auto &var : expandVariables({trim(args[i].substr(0, eq))}))
+                    {
+                        parsed.writes.push_back(make_pair(var, value));
+                    }
+                }
+            }
+            else if (args.size() >= 3)
+            {
+                parsed.type = CommandType::WRITE;
+                parsed.name = args[0];
+                parsed.writes.push_back(make_pair(args[1], stoi(args[2])));
+            }
+        }
+        else if (trimmedCommand.substr(0, 4) == "INC(")
+        {
+            // INC(T1, x2, 5) adds 5 to whatever x2 holds when T1 commits
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() >= 3)
+            {
+                parsed.type = CommandType::INCREMENT;
+                parsed.name = args[0];
+                parsed.writes.push_back(make_pair(args[1], stoi(args[2])));
+            }
+        }
+        else if (trimmedCommand.substr(0, 2) == "R(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() > 2 || (args.size() == 2 && args[1].find("..") != string::npos))
+            {
+                // Batch form: R(T1, x1, x2, x4) or R(T1, x1..x6)
+                parsed.type = CommandType::READ_BATCH;
+                parsed.name = args[0];
+                parsed.names = expandVariables(vector<string>(args.begin() + 1, args.end()));
+            }
+            else if (args.size() >= 2)
+            {
+                parsed.type = CommandType::READ;
+                parsed.name = args[0];
+                parsed.names.push_back(args[1]);
+            }
+        }
+        else if (trimmedCommand.substr(0, 4) == "SUM(" || trimmedCommand.substr(0, 4) == "MIN(" ||
+                 trimmedCommand.substr(0, 4) == "MAX(" || trimmedCommand.substr(0, 5) == "SCAN(")
+        {
+            // SUM/MIN/MAX(T1, x1..x20) or SCAN(T1, x1..x20, >100)
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() >= 2)
+            {
+                AggregateOp op = AggregateOp::SCAN;
+                if (trimmedCommand[1] == 'U')
+                    op = AggregateOp::SUM;
+                else if (trimmedCommand[1] == 'I')
+                    op = AggregateOp::MIN;
+                else if (trimmedCommand[1] == 'A')
+                    op = AggregateOp::MAX;
+
+                ScanPredicate predicate = ScanPredicate::ALL;
+                int operand = 0;
+                const string &last = args.back();
+                if (op == AggregateOp::SCAN && !last.empty() && (last[0] == '<' || last[0] == '>' || last[0] == '='))
+                {
+                    predicate = last[0] == '<' ? ScanPredicate::LESS
+                              : last[0] == '>' ? ScanPredicate::GREATER
+                                               : ScanPredicate::EQUAL;
+                    operand = stoi(last.substr(1));
+                    args.pop_back();
+                }
+                parsed.type = CommandType::AGGREGATE;
+                parsed.name = args[0];
+                parsed.names = expandVariables(vector<string>(args.begin() + 1, args.end()));
+                parsed.op = op;
+                parsed.predicate = predicate;
+                parsed.number = operand;
+            }
+        }
+        else if (trimmedCommand.substr(0, 4) == "end(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            parsed.type = CommandType::END;
+            if (args.size() > 1)
+            {
+                parsed.names = args;
+            }
+            else
+            {
+                parsed.name = extractArgument(trimmedCommand);
+            }
+        }
+        else if (trimmedCommand == "dump()")
+        {
+            parsed.type = CommandType::DUMP;
+        }
+        else if (trimmedCommand == "stats()")
+        {
+            parsed.type = CommandType::STATS;
+        }
+        else if (trimmedCommand.substr(0, 9) == "snapshot(")
+        {
+            parsed.type = CommandType::SNAPSHOT;
+            parsed.name = extractArgument(trimmedCommand);
+        }
+        else if (trimmedCommand.substr(0, 8) == "release(")
+        {
+            parsed.type = CommandType::RELEASE;
+            parsed.name = extractArgument(trimmedCommand);
+        }
+        else if (trimmedCommand.substr(0, 10) == "subscribe(")
+        {
+            // subscribe(C1) skips ahead when C1 lags; subscribe(C1, drop) drops it instead
+            vector<string> args = extractArguments(trimmedCommand);
+            if (!args.empty())
+            {
+                parsed.type = CommandType::SUBSCRIBE;
+                parsed.name = args[0];
+                parsed.flag = args.size() > 1 && args[1] == "drop";
+            }
+        }
+        else if (trimmedCommand.substr(0, 5) == "poll(")
+        {
+            parsed.type = CommandType::POLL;
+            parsed.name = extractArgument(trimmedCommand);
+        }
+        else if (trimmedCommand.substr(0, 12) == "unsubscribe(")
+        {
+            parsed.type = CommandType::UNSUBSCRIBE;
+            parsed.name = extractArgument(trimmedCommand);
+        }
+        else if (trimmedCommand.substr(0, 10) == "replicate(" || trimmedCommand.substr(0, 12) == "unreplicate(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() == 2)
+            {
+                parsed.type = trimmedCommand[0] == 'r' ? CommandType::REPLICATE : CommandType::UNREPLICATE;
+                parsed.name = args[0];
+                parsed.number = stoi(args[1]);
+            }
+        }
+        else if (trimmedCommand == "rebalance()")
+        {
+            parsed.type = CommandType::REBALANCE;
+        }
+        else if (trimmedCommand == "prune()")
+        {
+            parsed.type = CommandType::PRUNE;
+        }
+        else if (trimmedCommand.substr(0, 7) == "config(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() >= 2)
+            {
+                parsed.type = CommandType::CONFIG;
+                parsed.name = args[0];
+                parsed.text = args[1];
+            }
+        }
+        else if (trimmedCommand.substr(0, 7) == "quorum(")
+        {
+            vector<string> args = extractArguments(trimmedCommand);
+            if (args.size() == 3)
+            {
+                parsed.type = CommandType::QUORUM;
+                parsed.number = stoi(args[1]);
+                parsed.secondNumber = stoi(args[2]);
+                parsed.names = expandVariables({args[0]});
+            }
+        }
+        else if (trimmedCommand.substr(0, 5) == "fail(")
+        {
+            parsed.type = CommandType::FAIL;
+            parsed.number = stoi(extractArgument(trimmedCommand));
+        }
+        else if (trimmedCommand.substr(0, 8) == "recover(")
+        {
+            parsed.type = CommandType::RECOVER;
+            parsed.number = stoi(extractArgument(trimmedCommand));
+        }
+        else if (trimmedCommand.substr(0, 7) == "DEFINE " || trimmedCommand.substr(0, 5) == "CALL ")
+        {
+            // DEFINE transfer(T, from, to, amount) or CALL transfer(T9, x2, x4, 10)
+            size_t open = trimmedCommand.find('(');
+            size_t nameStart = trimmedCommand[0] == 'D' ? 7 : 5;
+            if (open != string::npos && trimmedCommand.back() == ')')
+            {
+                parsed.type = trimmedCommand[0] == 'D' ? CommandType::DEFINE : CommandType::CALL;
+                parsed.name = trim(trimmedCommand.substr(nameStart, open - nameStart));
+                parsed.names = extractArguments(trimmedCommand);
+            }
+            else
+            {
+                parsed.type = CommandType::UNKNOWN;
+            }
+        }
+        else if (trimmedCommand == "END")
+        {
+            parsed.type = CommandType::DEFINE_END;
+        }
+        else
+        {
+            parsed.type = CommandType::UNKNOWN;
+        }
     }
-    else if (trimmedCommand.substr(0, 8) == "beginRO(")
+    catch (const logic_error &)
     {
-        string txnName = extractArgument(trimmedCommand);
-        transactionManager.beginTransaction(txnName, true);
+        // stoi rejected a number, or a variable range is out of bounds
+        parsed.type = CommandType::INVALID;
     }
-    else if (trimmedCommand.substr(0, 2) == "W(")
+    if (parsed.type == CommandType::UNKNOWN || parsed.type == CommandType::INVALID)
     {
-        vector<string> args = extractArguments(trimmedCommand);
-        if (args.size() >= 3)
-        {
-            transactionManager.write(args[0], args[1], stoi(args[2]));
-        }
+        parsed.text = command;
     }
-    else if (trimmedCommand.substr(0, 2) == "R(")
+    return parsed;
+}
+
+// Description: Executes a parsed command
+// Input: command - result of parse
+// Output: None
+// Side Effects: Executes corresponding transaction manager operations; a command whose
+//               arguments cannot be converted is reported to the manager's output rather than
+//               ending the process
+void CommandParser::execute(const Command &command)
+{
+    try
     {
-        vector<string> args = extractArguments(trimmedCommand);
-        if (args.size() >= 2)
+        switch (command.type)
         {
-            transactionManager.read(args[0], args[1]);
+        case CommandType::NONE:
+            break;
+        case CommandType::UNKNOWN:
+            transactionManager.getOutput() << "Unknown command: " << command.text << endl;
+            break;
+        case CommandType::INVALID:
+            transactionManager.getOutput() << "Invalid command: " << command.text << endl;
+            break;
+        case CommandType::BEGIN:
+            if (command.names.empty())
+            {
+                transactionManager.beginTransaction(command.name, false);
+            }
+            else
+            {
+                transactionManager.beginTransaction(command.name, false, command.names);
+            }
+            break;
+        case CommandType::BEGIN_RO:
+            transactionManager.beginTransaction(command.name, true);
+            break;
+        case CommandType::BEGIN_AS_OF:
+            transactionManager.beginAsOf(command.name, command.text);
+            break;
+        case CommandType::WRITE:
+            transactionManager.write(command.name, command.writes[0].first, command.writes[0].second);
+            break;
+        case CommandType::WRITE_BATCH:
+            transactionManager.writeBatch(command.name, command.writes);
+            break;
+        case CommandType::INCREMENT:
+            transactionManager.increment(command.name, command.writes[0].first, command.writes[0].second);
+            break;
+        case CommandType::READ:
+            transactionManager.read(command.name, command.names[0]);
+            break;
+        case CommandType::READ_BATCH:
+            transactionManager.readBatch(command.name, command.names);
+            break;
+        case CommandType::AGGREGATE:
+            transactionManager.aggregate(command.name, command.op, command.names, command.predicate, command.number);
+            break;
+        case CommandType::END:
+            if (command.names.empty())
+            {
+                transactionManager.endTransaction(command.name);
+            }
+            else
+            {
+                transactionManager.endTransactions(command.names);
+            }
+            break;
+        case CommandType::DUMP:
+            transactionManager.dump();
+            break;
+        case CommandType::STATS:
+            transactionManager.printStats();
+            break;
+        case CommandType::SNAPSHOT:
+            transactionManager.takeSnapshot(command.name);
+            break;
+        case CommandType::RELEASE:
+            transactionManager.releaseSnapshot(command.name);
+            break;
+        case CommandType::SUBSCRIBE:
+            transactionManager.subscribe(command.name, command.flag);
+            break;
+        case CommandType::POLL:
+            transactionManager.pollChanges(command.name);
+            break;
+        case CommandType::UNSUBSCRIBE:
+            transactionManager.unsubscribe(command.name);
+            break;
+        case CommandType::REPLICATE:
+            transactionManager.addReplica(command.name, command.number);
+            break;
+        case CommandType::UNREPLICATE:
+            transactionManager.dropReplica(command.name, command.number);
+            break;
+        case CommandType::REBALANCE:
+            transactionManager.rebalance();
+            break;
+        case CommandType::PRUNE:
+            transactionManager.pruneVersions();
+            break;
+        case CommandType::CONFIG:
+            transactionManager.configure(command.name, command.text);
+            break;
+        case CommandType::QUORUM:
+            for (const auto &var : command.names)
+            {
+                transactionManager.setQuorum(var, command.number, command.secondNumber);
+            }
+            break;
+        case CommandType::FAIL:
+            transactionManager.failSite(command.number);
+            break;
+        case CommandType::RECOVER:
+            transactionManager.recoverSite(command.number);
+            break;
+        case CommandType::DEFINE:
+            transactionManager.beginDefinition(command.name, command.names);
+            break;
+        case CommandType::DEFINE_END:
+            transactionManager.endDefinition();
+            break;
+        case CommandType::CALL:
+            transactionManager.callProcedure(command.name, command.names);
+            break;
         }
     }
-    else if (trimmedCommand.substr(0, 4) == "end(")
+    catch (const logic_error &)
+    {
+        // A number in an argument, such as a variable index, was out of range
+        transactionManager.getOutput() << "Invalid command: " << command.line << endl;
+    }
+}
+
+// Description: Resolves an argument of a procedure operation to a parameter or a literal
+// Input: arg - argument text, parameters - of the procedure, isValue - the argument is a value,
+//        which may also be a negated parameter such as -amount
+// Output: operand - receives the resolution; bool - false if a literal value is not a number
+// Side Effects: None
+bool compileOperand(const string &arg, const vector<string> &parameters, bool isValue, ProcedureOperand &operand)
+{
+    operand.parameter = -1;
+    operand.negated = isValue && arg.size() > 1 && arg[0] == '-';
+    operand.value = 0;
+    string name = operand.negated ? arg.substr(1) : arg;
+    auto parameter = find(parameters.begin(), parameters.end(), name);
+    if (parameter != parameters.end())
+    {
+        operand.parameter = static_cast<int>(parameter - parameters.begin());
+        return true;
+    }
+    operand.negated = false;
+    if (!isValue)
+    {
+        operand.text = arg;
+        return true;
+    }
+    try
     {
-        string txnName = extractArgument(trimmedCommand);
-        transactionManager.endTransaction(txnName);
+        size_t used = 0;
+        operand.value = stoi(arg, &used);
+        return used == arg.size();
     }
-    else if (trimmedCommand == "dump()")
+    catch (const logic_error &)
     {
-        transactionManager.dump();
+        return false;
     }
-    else if (trimmedCommand.substr(0, 5) == "fail(")
+}
+
+// Description: Compiles the body of a stored procedure
+// Input: name, parameters - from the DEFINE line, body - the lines up to END
+// Output: procedure - the compiled operations; bool - false with error set if a line is not
+//         begin, beginRO, R, W, INC or end with the right number of arguments, or a value is
+//         neither a number nor a parameter
+// Side Effects: None
+bool CommandParser::compileProcedure(const string &name, const vector<string> &parameters, const vector<string> &body,
+                                     StoredProcedure &procedure, string &error)
+{
+    procedure.name = name;
+    procedure.parameters = parameters;
+    procedure.variableParameters.assign(parameters.size(), false);
+    procedure.valueParameters.assign(parameters.size(), false);
+    procedure.operations.clear();
+    for (size_t i = 0; i < parameters.size(); ++i)
     {
-        string siteIdStr = extractArgument(trimmedCommand);
-        int siteId = stoi(siteIdStr);
-        transactionManager.failSite(siteId);
+        if (parameters[i].empty() || find(parameters.begin(), parameters.begin() + i, parameters[i]) != parameters.begin() + i)
+        {
+            error = "parameter names must be distinct and non-empty";
+            return false;
+        }
     }
-    else if (trimmedCommand.substr(0, 8) == "recover(")
+
+    for (const auto &bodyLine : body)
     {
-        string siteIdStr = extractArgument(trimmedCommand);
-        int siteId = stoi(siteIdStr);
-        transactionManager.recoverSite(siteId);
+        string line = trim(bodyLine);
+        if (line.empty() || line[0] == '/')
+            continue;
+
+        ProcedureOperation operation;
+        size_t arity = 1;
+        if (line.substr(0, 6) == "begin(")
+        {
+            operation.step = ProcedureStep::BEGIN;
+        }
+        else if (line.substr(0, 8) == "beginRO(")
+        {
+            operation.step = ProcedureStep::BEGIN_RO;
+        }
+        else if (line.substr(0, 2) == "R(")
+        {
+            operation.step = ProcedureStep::READ;
+            arity = 2;
+        }
+        else if (line.substr(0, 2) == "W(" || line.substr(0, 4) == "INC(")
+        {
+            operation.step = line[0] == 'W' ? ProcedureStep::WRITE : ProcedureStep::INCREMENT;
+            arity = 3;
+        }
+        else if (line.substr(0, 4) == "end(")
+        {
+            operation.step = ProcedureStep::END;
+        }
+        else
+        {
+            error = "unsupported command " + line;
+            return false;
+        }
+        vector<string> args = extractArguments(line);
+        if (args.size() != arity)
+        {
+            error = "expected " + to_string(arity) + " argument" + (arity > 1 ? "s" : "") + " in " + line;
+            return false;
+        }
+
+        compileOperand(args[0], parameters, false, operation.transaction);
+        compileOperand(arity > 1 ? args[1] : "", parameters, false, operation.variable);
+        if (operation.variable.parameter >= 0)
+        {
+            procedure.variableParameters[operation.variable.parameter] = true;
+        }
+        if (!compileOperand(arity > 2 ? args[2] : "0", parameters, true, operation.value))
+        {
+            error = args[2] + " is neither a number nor a parameter";
+            return false;
+        }
+        if (operation.value.parameter >= 0)
+        {
+            procedure.valueParameters[operation.value.parameter] = true;
+        }
+        procedure.operations.push_back(operation);
     }
-    else
+    if (procedure.operations.empty())
     {
-        cerr << "Unknown command: " << command << endl;
+        error = "the body is empty";
+        return false;
     }
+    return true;
 }
 
 // Description: Splits string into tokens based on delimiter
@@ -0,0 +1,224 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:36:30
+ */
+
+#include "CommitCoordinator.h"
+#include <iostream>
+using namespace std;
+
+// Description: Creates a coordinator with batching on and a LAN-like latency model
+// Input: dataManager - access to the participant sites
+// Output: None
+// Side Effects: None
+CommitCoordinator::CommitCoordinator(shared_ptr<DataManager> dataManager)
+    : dataManager(dataManager), batching(true), latency{200.0, 2.0}, stats{0, 0, 0, 0, 0, 0.0},
+      prepareFailureSite(-1), decideFailureSite(-1)
+{
+}
+
+// Description: Runs two-phase commit for a group of validated transactions
+// Input: group - transactions with commit times set
+// Output: One outcome per transaction, in input order
+// Side Effects: Sites stage and install writes, decisions are logged, counters advance
+vector<CommitOutcome> CommitCoordinator::commit(const vector<shared_ptr<Transaction>> &group)
+{
+    vector<CommitOutcome> outcomes(group.size(), CommitOutcome{true, -1});
+    if (batching)
+    {
+        runGroup(group, outcomes, 0);
+    }
+    else
+    {
+        for (size_t i = 0; i < group.size(); ++i)
+        {
+            runGroup(vector<shared_ptr<Transaction>>(1, group[i]), outcomes, i);
+        }
+    }
+    return outcomes;
+}
+
+// Description: Prepare phase, decision logging and decide phase for transactions sharing batches
+// Input: group - transactions, outcomes - results to fill, firstOutcome - index of group[0] in outcomes
+// Output: None
+// Side Effects: See commit()
+void CommitCoordinator::runGroup(const vector<shared_ptr<Transaction>> &group, vector<CommitOutcome> &outcomes,
+                                 size_t firstOutcome)
+{
+    vector<map<int, vector<StagedWrite>>> plans;
+    map<int, size_t> prepareBySite;
+    for (const auto &transaction : group)
+    {
+        plans.push_back(dataManager->planCommit(transaction));
+        for (const auto &participant : plans.back())
+        {
+            ++prepareBySite[participant.first];
+        }
+    }
+
+    // Phase 1: every participant votes on its share of each transaction
+    chargePhase(prepareBySite);
+    for (size_t i = 0; i < group.size(); ++i)
+    {
+        CommitOutcome &outcome = outcomes[firstOutcome + i];
+        for (const auto &participant : plans[i])
+        {
+            ++stats.prepareMessages;
+            if (participant.first == prepareFailureSite)
+            {
+                prepareFailureSite = -1;
+                dataManager->failSite(participant.first);
+            }
+            auto site = dataManager->getSite(participant.first);
+            if (!site->prepare(group[i]->getName(), group[i]->getCommitTime(), participant.second))
+            {
+                outcome.committed = false;
+                if (outcome.rejectingSite < 0)
+                {
+                    outcome.rejectingSite = participant.first;
+                }
+            }
+        }
+        // The decision is durable before any participant hears it
+        decisionLog[group[i]->getName()] = outcome.committed;
+        ++stats.transactions;
+        if (!outcome.committed)
+        {
+            ++stats.aborted;
+        }
+    }
+
+    if (decideFailureSite >= 0 && prepareBySite.count(decideFailureSite))
+    {
+        int siteId = decideFailureSite;
+        decideFailureSite = -1;
+        dataManager->failSite(siteId);
+    }
+
+    // Phase 2: reachable participants learn the decision; the others stay in doubt
+    map<int, size_t> decideBySite;
+    for (const auto &plan : plans)
+    {
+        for (const auto &participant : plan)
+        {
+            if (dataManager->getSite(participant.first)->getStatus() != SiteStatus::DOWN)
+            {
+                ++decideBySite[participant.first];
+            }
+        }
+    }
+    chargePhase(decideBySite);
+    for (size_t i = 0; i < group.size(); ++i)
+    {
+        for (const auto &participant : plans[i])
+        {
+            if (dataManager->getSite(participant.first)->getStatus() != SiteStatus::DOWN)
+            {
+                ++stats.decideMessages;
+                dataManager->deliverDecision(participant.first, group[i]->getName(),
+                                             outcomes[firstOutcome + i].committed);
+            }
+        }
+        if (outcomes[firstOutcome + i].committed)
+        {
+            dataManager->publishCommit(group[i], plans[i]);
+        }
+    }
+}
+
+// Description: Finishes transactions a recovered site prepared but never saw decided
+// Input: siteId - site that just recovered
+// Output: None
+// Side Effects: Installs or discards staged writes, prints each resolution
+void CommitCoordinator::resolveInDoubt(int siteId)
+{
+    auto site = dataManager->getSite(siteId);
+    if (!site)
+    {
+        return;
+    }
+    for (const auto &transactionName : site->getInDoubtTransactions())
+    {
+        // Without a logged decision the transaction never committed anywhere
+        auto it = decisionLog.find(transactionName);
+        bool commit = it != decisionLog.end() && it->second;
+        map<int, size_t> query;
+        query[siteId] = 1;
+        chargePhase(query);
+        ++stats.decideMessages;
+        dataManager->deliverDecision(siteId, transactionName, commit);
+        dataManager->getOutput() << "Site " << siteId << " resolved in-doubt transaction " << transactionName << ": "
+             << (commit ? "commit" : "abort") << endl;
+    }
+}
+
+// Description: Turns batching of prepare and decide messages on or off
+// Input: enabled (bool)
+// Output: None
+// Side Effects: Affects later commits
+void CommitCoordinator::setBatching(bool enabled)
+{
+    batching = enabled;
+}
+
+// Description: Sets the simulated message costs
+// Input: model - round-trip and per-message costs
+// Output: None
+// Side Effects: Affects later commits
+void CommitCoordinator::setLatencyModel(const MessageLatencyModel &model)
+{
+    latency = model;
+}
+
+// Description: Returns the simulated message costs
+// Input: None
+// Output: MessageLatencyModel
+// Side Effects: None
+const MessageLatencyModel &CommitCoordinator::getLatencyModel() const
+{
+    return latency;
+}
+
+// Description: Arms a failure of a site on its next prepare request
+// Input: siteId
+// Output: None
+// Side Effects: The site fails before voting, so the transaction aborts
+void CommitCoordinator::failOnPrepare(int siteId)
+{
+    prepareFailureSite = siteId;
+}
+
+// Description: Arms a failure of a site between its vote and the decision
+// Input: siteId
+// Output: None
+// Side Effects: The site is left in doubt until it recovers
+void CommitCoordinator::failBeforeDecide(int siteId)
+{
+    decideFailureSite = siteId;
+}
+
+// Description: Returns protocol counters
+// Input: None
+// Output: CommitStats
+// Side Effects: None
+const CommitStats &CommitCoordinator::getStats() const
+{
+    return stats;
+}
+
+// Description: Charges a phase to the simulated clock; sites are contacted in parallel
+// Input: messagesBySite - number of messages each site receives in this phase
+// Output: None
+// Side Effects: Adds one round trip per site and the slowest exchange to the simulated time
+void CommitCoordinator::chargePhase(const map<int, size_t> &messagesBySite)
+{
+    double slowest = 0.0;
+    for (const auto &entry : messagesBySite)
+    {
+        double micros = latency.roundTripMicros + latency.perMessageMicros * entry.second;
+        slowest = micros > slowest ? micros : slowest;
+        ++stats.roundTrips;
+    }
+    stats.simulatedMicros += slowest;
+}
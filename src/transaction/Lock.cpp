@@ -0,0 +1,15 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:38:05
+ */
+
+#include "Lock.h"
+
+// Description: Creates a lock of the given type held by the given transactions
+// Input: type - lock mode, transactions - IDs of the holders
+// Output: None
+// Side Effects: None
+Lock::Lock(Lock_type type, set<int> transactions) : type(type), transactions(transactions)
+{
+}
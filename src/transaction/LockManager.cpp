@@ -0,0 +1,251 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:38:05
+ */
+
+#include "LockManager.h"
+#include <algorithm>
+#include <functional>
+
+// Description: Requests a shared or exclusive lock
+// Input: transactionId, siteId, varIndex, type - READ_LOCK or WRITE_LOCK,
+//        queueIfBusy - whether a conflicting request should wait in the queue
+// Output: LockResult - GRANTED, WAITING or BUSY
+// Side Effects: Updates holders or the wait queue of the lock
+LockResult LockManager::acquire(int transactionId, int siteId, int varIndex, Lock_type type, bool queueIfBusy)
+{
+    LockEntry &entry = tables[siteId][varIndex];
+    Lock &lock = entry.lock;
+    bool holds = lock.transactions.count(transactionId) > 0;
+    if (holds && (lock.type == WRITE_LOCK || type == READ_LOCK))
+    {
+        return LockResult::GRANTED;
+    }
+    for (const auto &request : entry.waiting)
+    {
+        if (request.transactionId == transactionId)
+        {
+            return LockResult::WAITING;
+        }
+    }
+
+    LockRequest request = {transactionId, type};
+    // New readers queue behind waiting writers so writers are not starved
+    if (isCompatible(lock, request) && (holds || entry.waiting.empty()))
+    {
+        lock.type = type;
+        lock.transactions.insert(transactionId);
+        touchedEntries[transactionId].insert(std::make_pair(siteId, varIndex));
+        return LockResult::GRANTED;
+    }
+    if (!queueIfBusy)
+    {
+        return LockResult::BUSY;
+    }
+    if (holds)
+    {
+        // Upgrade: only the other readers stand in the way
+        entry.waiting.push_front(request);
+    }
+    else
+    {
+        entry.waiting.push_back(request);
+    }
+    touchedEntries[transactionId].insert(std::make_pair(siteId, varIndex));
+    return LockResult::WAITING;
+}
+
+// Description: Releases a transaction's locks at commit or abort
+// Input: transactionId
+// Output: Transactions whose queued requests were granted as a result
+// Side Effects: Updates holders and wait queues
+std::vector<int> LockManager::releaseAll(int transactionId)
+{
+    std::vector<int> granted;
+    auto touched = touchedEntries.find(transactionId);
+    if (touched == touchedEntries.end())
+    {
+        return granted;
+    }
+    for (const auto &key : touched->second)
+    {
+        auto site = tables.find(key.first);
+        if (site == tables.end())
+        {
+            continue;
+        }
+        auto it = site->second.find(key.second);
+        if (it == site->second.end())
+        {
+            continue;
+        }
+        LockEntry &entry = it->second;
+        entry.lock.transactions.erase(transactionId);
+        if (entry.lock.transactions.empty())
+        {
+            entry.lock.type = NO_LOCK;
+        }
+        entry.waiting.erase(std::remove_if(entry.waiting.begin(), entry.waiting.end(),
+                                           [transactionId](const LockRequest &request)
+                                           { return request.transactionId == transactionId; }),
+                            entry.waiting.end());
+        std::vector<int> newHolders = grantWaiting(entry);
+        granted.insert(granted.end(), newHolders.begin(), newHolders.end());
+    }
+    touchedEntries.erase(touched);
+    return granted;
+}
+
+// Description: Forgets all locks at a failed site
+// Input: siteId
+// Output: Transactions that were waiting at the site; they retry against the empty table
+// Side Effects: Removes the site's lock table
+std::vector<int> LockManager::clearSite(int siteId)
+{
+    auto site = tables.find(siteId);
+    std::vector<int> woken;
+    if (site == tables.end())
+    {
+        return woken;
+    }
+    for (const auto &variable : site->second)
+    {
+        for (const auto &request : variable.second.waiting)
+        {
+            woken.push_back(request.transactionId);
+        }
+        for (int holder : variable.second.lock.transactions)
+        {
+            touchedEntries[holder].erase(std::make_pair(siteId, variable.first));
+        }
+    }
+    for (int waiter : woken)
+    {
+        auto &touched = touchedEntries[waiter];
+        for (auto it = touched.begin(); it != touched.end();)
+        {
+            it = it->first == siteId ? touched.erase(it) : std::next(it);
+        }
+    }
+    tables.erase(site);
+    return woken;
+}
+
+// Description: Looks for a cycle in the wait-for graph
+// Input: None
+// Output: ID of the youngest transaction on a cycle, -1 if none
+// Side Effects: None
+int LockManager::findDeadlockVictim() const
+{
+    // Each waiter waits for incompatible holders and for every request queued ahead of it
+    std::map<int, std::set<int>> waitsFor;
+    for (const auto &site : tables)
+    {
+        for (const auto &variable : site.second)
+        {
+            const LockEntry &entry = variable.second;
+            for (size_t i = 0; i < entry.waiting.size(); ++i)
+            {
+                const LockRequest &request = entry.waiting[i];
+                std::set<int> &edges = waitsFor[request.transactionId];
+                if (request.type == WRITE_LOCK || entry.lock.type == WRITE_LOCK)
+                {
+                    for (int holder : entry.lock.transactions)
+                    {
+                        if (holder != request.transactionId)
+                        {
+                            edges.insert(holder);
+                        }
+                    }
+                }
+                for (size_t j = 0; j < i; ++j)
+                {
+                    if (entry.waiting[j].transactionId != request.transactionId)
+                    {
+                        edges.insert(entry.waiting[j].transactionId);
+                    }
+                }
+            }
+        }
+    }
+
+    std::set<int> done;
+    std::vector<int> path;
+    int victim = -1;
+    std::function<bool(int)> visit = [&](int transactionId) -> bool
+    {
+        auto onPath = std::find(path.begin(), path.end(), transactionId);
+        if (onPath != path.end())
+        {
+            victim = *std::max_element(onPath, path.end());
+            return true;
+        }
+        if (done.count(transactionId))
+        {
+            return false;
+        }
+        path.push_back(transactionId);
+        auto edges = waitsFor.find(transactionId);
+        if (edges != waitsFor.end())
+        {
+            for (int next : edges->second)
+            {
+                if (visit(next))
+                {
+                    return true;
+                }
+            }
+        }
+        path.pop_back();
+        done.insert(transactionId);
+        return false;
+    };
+    for (const auto &node : waitsFor)
+    {
+        if (visit(node.first))
+        {
+            return victim;
+        }
+    }
+    return -1;
+}
+
+// Description: Checks lock compatibility
+// Input: lock - current state, request - requested mode
+// Output: bool - true if the request can be held together with the current holders
+// Side Effects: None
+bool LockManager::isCompatible(const Lock &lock, const LockRequest &request)
+{
+    if (lock.transactions.empty())
+    {
+        return true;
+    }
+    bool soleHolder = lock.transactions.size() == 1 && lock.transactions.count(request.transactionId);
+    if (request.type == WRITE_LOCK)
+    {
+        return soleHolder;
+    }
+    return lock.type == READ_LOCK || soleHolder;
+}
+
+// Description: Grants queued requests in FIFO order until one conflicts
+// Input: entry - lock whose holders changed
+// Output: Transactions that now hold the lock
+// Side Effects: Moves requests from the queue to the holders
+std::vector<int> LockManager::grantWaiting(LockEntry &entry)
+{
+    std::vector<int> granted;
+    while (!entry.waiting.empty() && isCompatible(entry.lock, entry.waiting.front()))
+    {
+        LockRequest request = entry.waiting.front();
+        entry.waiting.pop_front();
+        if (request.type == WRITE_LOCK || entry.lock.type == NO_LOCK)
+        {
+            entry.lock.type = request.type;
+        }
+        entry.lock.transactions.insert(request.transactionId);
+        granted.push_back(request.transactionId);
+    }
+    return granted;
+}
@@ -0,0 +1,140 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:40:15
+ */
+
+#include "OccTable.h"
+#include <algorithm>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+// Description: Allocates one version word per variable
+// Input: numVariables - highest variable index
+// Output: None
+// Side Effects: All words start unlocked at version 0
+OccTable::OccTable(int numVariables) : numVariables(numVariables), words(new atomic<uint64_t>[numVariables + 1])
+{
+    for (int i = 0; i <= numVariables; ++i)
+    {
+        words[i].store(0, memory_order_relaxed);
+    }
+}
+
+// Description: Reads the committed version of a variable
+// Input: varIndex
+// Output: uint64_t - TID of the latest committed write, 0 if none
+// Side Effects: Yields while another committer holds the word
+uint64_t OccTable::readVersion(int varIndex) const
+{
+    const atomic<uint64_t> &versionWord = word(varIndex);
+    uint64_t current = versionWord.load(memory_order_acquire);
+    while (current & LOCK_BIT)
+    {
+        sched_yield();
+        current = versionWord.load(memory_order_acquire);
+    }
+    return current;
+}
+
+// Description: Locks the version words of a write set
+// Input: sortedIndices - variables written, in ascending order without duplicates
+// Output: None
+// Side Effects: Blocks until every word is held by the caller
+void OccTable::lockWrites(const vector<int> &sortedIndices)
+{
+    for (int varIndex : sortedIndices)
+    {
+        atomic<uint64_t> &versionWord = word(varIndex);
+        uint64_t current = versionWord.load(memory_order_relaxed);
+        while ((current & LOCK_BIT) ||
+               !versionWord.compare_exchange_weak(current, current | LOCK_BIT, memory_order_acquire,
+                                                  memory_order_relaxed))
+        {
+            if (current & LOCK_BIT)
+            {
+                sched_yield();
+                current = versionWord.load(memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// Description: Validates a read set once the write set is locked
+// Input: reads - (variable, version observed), sortedWrites - the caller's locked write set
+// Output: bool - true if no read was overwritten or is being overwritten by another committer
+// Side Effects: None
+bool OccTable::validateReads(const vector<pair<int, uint64_t>> &reads, const vector<int> &sortedWrites) const
+{
+    for (const auto &read : reads)
+    {
+        uint64_t current = word(read.first).load(memory_order_acquire);
+        if ((current & ~LOCK_BIT) != read.second)
+        {
+            return false;
+        }
+        if ((current & LOCK_BIT) && !binary_search(sortedWrites.begin(), sortedWrites.end(), read.first))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Description: Picks the commit TID so versions keep increasing along every read and write
+// Input: reads, sortedWrites - the caller's locked write set, minimumTid - usually the commit clock
+// Output: uint64_t - TID for install()
+// Side Effects: None
+uint64_t OccTable::chooseTid(const vector<pair<int, uint64_t>> &reads, const vector<int> &sortedWrites,
+                             uint64_t minimumTid) const
+{
+    uint64_t tid = minimumTid;
+    for (const auto &read : reads)
+    {
+        tid = max(tid, read.second + 1);
+    }
+    for (int varIndex : sortedWrites)
+    {
+        tid = max(tid, (word(varIndex).load(memory_order_relaxed) & ~LOCK_BIT) + 1);
+    }
+    return tid;
+}
+
+// Description: Installs a commit in the version words
+// Input: sortedWrites - locked write set, tid - from chooseTid()
+// Output: None
+// Side Effects: Readers and validators see the new version; the words are unlocked
+void OccTable::install(const vector<int> &sortedWrites, uint64_t tid)
+{
+    for (int varIndex : sortedWrites)
+    {
+        word(varIndex).store(tid & ~LOCK_BIT, memory_order_release);
+    }
+}
+
+// Description: Releases a write set after a failed validation
+// Input: sortedWrites - locked write set
+// Output: None
+// Side Effects: The words are unlocked at their old versions
+void OccTable::unlock(const vector<int> &sortedWrites)
+{
+    for (int varIndex : sortedWrites)
+    {
+        word(varIndex).fetch_and(~LOCK_BIT, memory_order_release);
+    }
+}
+
+// Description: Looks up the word of a variable
+// Input: varIndex - 1..numVariables
+// Output: Reference to the word
+// Side Effects: Throws if the index is out of range
+atomic<uint64_t> &OccTable::word(int varIndex) const
+{
+    if (varIndex < 1 || varIndex > numVariables)
+    {
+        throw runtime_error("Invalid variable index " + to_string(varIndex));
+    }
+    return words[varIndex];
+}
@@ -0,0 +1,199 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:54:30
+ */
+
+#include "SerializationGraph.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <algorithm>
+using namespace std;
+
+namespace
+{
+    // Description: Tests whether two bitsets share a set bit
+    // Input: a, b - word arrays, words - words to compare
+    // Output: bool - true if some bit is set in both
+    // Side Effects: None
+    bool intersects(const uint64_t *a, const uint64_t *b, size_t words)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128i any = _mm_setzero_si128();
+        for (; i + 2 <= words; i += 2)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            any = _mm_or_si128(any, _mm_and_si128(x, y));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return true;
+        }
+#endif
+        for (; i < words; ++i)
+        {
+            if (a[i] & b[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Description: Finds the first bit set in a row but not in a mask, from a starting word on
+    // Input: row, mask - word arrays, words - words in row (mask is at least as long), from - first word
+    // Output: int - bit index, or -1 if every set bit of the row is also in the mask
+    // Side Effects: None
+    int firstOutside(const uint64_t *row, const uint64_t *mask, size_t words, size_t &from)
+    {
+        for (; from < words; ++from)
+        {
+            uint64_t bits = row[from] & ~mask[from];
+            if (bits)
+            {
+                return static_cast<int>(from * 64 + __builtin_ctzll(bits));
+            }
+        }
+        return -1;
+    }
+}
+
+// Description: Creates an empty graph
+// Input: None
+// Output: None
+// Side Effects: None
+SerializationGraph::SerializationGraph() : edges(0) {}
+
+// Description: Gives a transaction a slot the first time it appears in a dependency
+// Input: transactionName
+// Output: int - its slot
+// Side Effects: May add a slot with an empty row
+int SerializationGraph::slotOf(const string &transactionName)
+{
+    auto it = slots.find(transactionName);
+    if (it != slots.end())
+    {
+        return it->second;
+    }
+    int slot = static_cast<int>(successors.size());
+    slots[transactionName] = slot;
+    successors.push_back(vector<uint64_t>());
+    return slot;
+}
+
+// Description: Records a dependency edge
+// Input: from - the dependent transaction, to - the transaction it depends on
+// Output: None
+// Side Effects: Sets a bit in from's row, growing the row to reach to's slot
+void SerializationGraph::addDependency(const string &from, const string &to)
+{
+    int source = slotOf(from);
+    int target = slotOf(to);
+    vector<uint64_t> &row = successors[source];
+    size_t word = static_cast<size_t>(target) / 64;
+    if (row.size() <= word)
+    {
+        row.resize(word + 1, 0);
+    }
+    uint64_t bit = uint64_t(1) << (target % 64);
+    if (!(row[word] & bit))
+    {
+        row[word] |= bit;
+        ++edges;
+    }
+}
+
+// Description: Drops the edges leaving a transaction
+// Input: transactionName
+// Output: None
+// Side Effects: Empties its row; edges into it stay, so a restarted attempt inherits them
+void SerializationGraph::clearDependencies(const string &transactionName)
+{
+    auto it = slots.find(transactionName);
+    if (it == slots.end())
+    {
+        return;
+    }
+    vector<uint64_t> &row = successors[it->second];
+    for (uint64_t word : row)
+    {
+        edges -= __builtin_popcountll(word);
+    }
+    row.clear();
+}
+
+// Description: Depth-first search from a transaction for a back edge
+// Input: transactionName
+// Output: bool - true if the part of the graph reachable from it contains a cycle
+// Side Effects: None
+bool SerializationGraph::reachesCycle(const string &transactionName) const
+{
+    auto it = slots.find(transactionName);
+    if (it == slots.end())
+    {
+        // Never part of a dependency, so on no path at all
+        return false;
+    }
+    size_t words = (successors.size() + 63) / 64;
+    vector<uint64_t> visited(words, 0);
+    vector<uint64_t> onStack(words, 0);
+
+    // Each frame keeps the word its child scan got to, so a row is scanned once per visit
+    struct Frame
+    {
+        int slot;
+        size_t word;
+    };
+    vector<Frame> stack;
+    int start = it->second;
+    visited[start / 64] |= uint64_t(1) << (start % 64);
+    onStack[start / 64] |= uint64_t(1) << (start % 64);
+    stack.push_back(Frame{start, 0});
+    // A node's ancestors stay on the stack while it is, so a back edge shows up when it is entered
+    if (intersects(successors[start].data(), onStack.data(), successors[start].size()))
+    {
+        return true;
+    }
+    while (!stack.empty())
+    {
+        Frame &frame = stack.back();
+        const vector<uint64_t> &row = successors[frame.slot];
+        int child = firstOutside(row.data(), visited.data(), row.size(), frame.word);
+        if (child < 0)
+        {
+            onStack[frame.slot / 64] &= ~(uint64_t(1) << (frame.slot % 64));
+            stack.pop_back();
+            continue;
+        }
+        visited[child / 64] |= uint64_t(1) << (child % 64);
+        onStack[child / 64] |= uint64_t(1) << (child % 64);
+        const vector<uint64_t> &childRow = successors[child];
+        if (intersects(childRow.data(), onStack.data(), childRow.size()))
+        {
+            return true;
+        }
+        stack.push_back(Frame{child, 0});
+    }
+    return false;
+}
+
+// Description: Counts transactions holding a slot
+// Input: None
+// Output: size_t
+// Side Effects: None
+size_t SerializationGraph::getSlotCount() const
+{
+    return successors.size();
+}
+
+// Description: Counts recorded dependencies
+// Input: None
+// Output: size_t
+// Side Effects: None
+size_t SerializationGraph::getEdgeCount() const
+{
+    return edges;
+}
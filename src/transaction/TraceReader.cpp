@@ -0,0 +1,211 @@
+/**
+ * @   Author: Ke Wang & Siwen Tao
+ * @   Email: kw3484@nyu.edu & st5297@nyu.edu
+ * @   Modified time: 2024-12-08 22:52:30
+ */
+
+#include "TraceReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// Description: Maps the file, cuts it into chunks and starts the parser threads
+// Input: path, parserThreads - 0 for one per hardware thread, chunkBytes - target chunk size,
+//        windowChunks - chunks that may be parsed ahead of the caller
+// Output: None
+// Side Effects: Throws runtime_error if the file cannot be opened or mapped
+TraceReader::TraceReader(const string &path, int parserThreads, size_t chunkBytes, size_t windowChunks)
+    : data(nullptr), size(0), window(max<size_t>(windowChunks, 1)), nextChunk(0), takenChunks(0), stopping(false),
+      position(0), stats{0, 0, 0, 0, 0.0, 0.0}
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw runtime_error("Cannot read " + path);
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0)
+    {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("Cannot map " + path);
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    close(fd);
+
+    for (Slot &slot : window)
+    {
+        slot.ready = false;
+    }
+    splitChunks(max<size_t>(chunkBytes, 1));
+    if (parserThreads <= 0)
+    {
+        parserThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    }
+    // More parsers than chunks that may be in flight would only wait
+    parserThreads = static_cast<int>(min<size_t>(parserThreads, window.size()));
+    stats.bytes = size;
+    stats.chunks = chunkStarts.size() - 1;
+    stats.parserThreads = parserThreads;
+    for (int i = 0; i < parserThreads; ++i)
+    {
+        parsers.push_back(thread(&TraceReader::parseLoop, this));
+    }
+}
+
+// Description: Stops parsing and releases the file
+// Input: None
+// Output: None
+// Side Effects: Joins the parser threads, unmaps the file
+TraceReader::~TraceReader()
+{
+    {
+        lock_guard<mutex> lock(windowMutex);
+        stopping = true;
+    }
+    slotFree.notify_all();
+    for (thread &parser : parsers)
+    {
+        parser.join();
+    }
+    if (data)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+// Description: Records where each chunk starts
+// Input: chunkBytes - target chunk size
+// Output: None
+// Side Effects: Fills chunkStarts; every chunk but the last ends just after a newline
+void TraceReader::splitChunks(size_t chunkBytes)
+{
+    size_t start = 0;
+    while (start < size)
+    {
+        chunkStarts.push_back(start);
+        size_t end = start + chunkBytes;
+        if (end >= size)
+        {
+            break;
+        }
+        const void *newline = memchr(data + end, '\n', size - end);
+        if (!newline)
+        {
+            break;
+        }
+        start = static_cast<const char *>(newline) - data + 1;
+    }
+    chunkStarts.push_back(size);
+}
+
+// Description: Claims chunks in order and parses each into its slot
+// Input: None
+// Output: None
+// Side Effects: Fills window slots, waiting while the window is full
+void TraceReader::parseLoop()
+{
+    size_t chunkCount = chunkStarts.size() - 1;
+    vector<Command> parsed;
+    while (true)
+    {
+        size_t chunk;
+        {
+            unique_lock<mutex> lock(windowMutex);
+            slotFree.wait(lock, [this, chunkCount]()
+            {
+                return stopping || nextChunk >= chunkCount || nextChunk < takenChunks + window.size();
+            });
+            if (stopping || nextChunk >= chunkCount)
+            {
+                return;
+            }
+            chunk = nextChunk++;
+        }
+
+        // Lines are parsed exactly as main reads them: getline without the newline
+        auto start = chrono::steady_clock::now();
+        const char *line = data + chunkStarts[chunk];
+        const char *end = data + chunkStarts[chunk + 1];
+        while (line < end)
+        {
+            const char *newline = static_cast<const char *>(memchr(line, '\n', end - line));
+            const char *lineEnd = newline ? newline : end;
+            if (!CommandParser::isSkipped(line, lineEnd - line))
+            {
+                parsed.push_back(CommandParser::parse(string(line, lineEnd)));
+            }
+            line = lineEnd + 1;
+        }
+        double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+        {
+            lock_guard<mutex> lock(windowMutex);
+            Slot &slot = window[chunk % window.size()];
+            slot.commands.swap(parsed);
+            slot.ready = true;
+            stats.parseMicros += micros;
+        }
+        chunkReady.notify_all();
+        parsed.clear();
+    }
+}
+
+// Description: Hands out the next command in file order
+// Input: None
+// Output: command - receives the command; bool - false once every command has been handed out
+// Side Effects: Takes parsed chunks from the window, freeing their slots for further chunks
+bool TraceReader::next(Command &command)
+{
+    while (position == current.size())
+    {
+        unique_lock<mutex> lock(windowMutex);
+        if (takenChunks == chunkStarts.size() - 1)
+        {
+            return false;
+        }
+        Slot &slot = window[takenChunks % window.size()];
+        if (!slot.ready)
+        {
+            auto start = chrono::steady_clock::now();
+            chunkReady.wait(lock, [&slot]() { return slot.ready; });
+            stats.stallMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+        current.clear();
+        current.swap(slot.commands);
+        slot.ready = false;
+        position = 0;
+        ++takenChunks;
+        lock.unlock();
+        slotFree.notify_all();
+    }
+    command = std::move(current[position++]);
+    ++stats.commands;
+    return true;
+}
+
+// Description: Returns the ingestion counters
+// Input: None
+// Output: TraceReaderStats
+// Side Effects: None
+TraceReaderStats TraceReader::getStats() const
+{
+    lock_guard<mutex> lock(windowMutex);
+    return stats;
+}
@@ -16,8 +16,16 @@ Transaction::Transaction(const string &name, bool isReadOnly)
     : name(name),
       readOnly(isReadOnly),
       status(TransactionStatus::ACTIVE),
+      abortReason(AbortReason::NONE),
+      lastRead(0),
+      readsReturned(0),
       startTime(chrono::system_clock::now().time_since_epoch().count()),
-      commitTime(0) {}
+      commitTime(0),
+      readSet(std::less<string>(), ArenaAllocator<string>(arena)),
+      writeSet(std::less<string>(), ArenaAllocator<pair<const string, int>>(arena)),
+      incrementSet(std::less<string>(), ArenaAllocator<pair<const string, int>>(arena)),
+      sitesWrittenTo(std::less<int>(), ArenaAllocator<int>(arena)),
+      readVersions(std::less<int>(), ArenaAllocator<pair<const int, uint64_t>>(arena)) {}
 
 // Description: Returns transaction identifier
 // Input: None
@@ -50,6 +58,40 @@ void Transaction::setStatus(TransactionStatus newStatus)
     }
 }
 
+// Description: Records why the transaction is being aborted
+// Input: reason (AbortReason)
+// Output: None
+// Side Effects: Updates abort reason
+void Transaction::setAbortReason(AbortReason reason) { abortReason = reason; }
+
+// Description: Returns why the transaction was aborted
+// Input: None
+// Output: AbortReason - NONE unless aborted
+// Side Effects: None
+AbortReason Transaction::getAbortReason() const { return abortReason; }
+
+// Description: Records the value a single-variable read returned
+// Input: value (int)
+// Output: None
+// Side Effects: Updates last read value and read count
+void Transaction::setLastRead(int value)
+{
+    lastRead = value;
+    ++readsReturned;
+}
+
+// Description: Returns the value of the latest single-variable read
+// Input: None
+// Output: int - value read
+// Side Effects: None
+int Transaction::getLastRead() const { return lastRead; }
+
+// Description: Returns how many single-variable reads returned a value
+// Input: None
+// Output: size_t - read count
+// Side Effects: None
+size_t Transaction::getReadsReturned() const { return readsReturned; }
+
 // Description: Returns transaction start timestamp
 // Input: None
 // Output: long - start time
@@ -62,23 +104,67 @@ long Transaction::getStartTime() const { return startTime; }
 // Side Effects: Updates read set
 void Transaction::addReadVariable(const string &variableName) { readSet.insert(variableName); }
 
+// Description: Records the version a read observed; later reads of the variable keep the first one
+// Input: varIndex (int) - variable read, version (uint64_t) - its version word at the time
+// Output: None
+// Side Effects: Updates read versions
+void Transaction::addReadVersion(int varIndex, uint64_t version) { readVersions.insert(make_pair(varIndex, version)); }
+
+// Description: Returns versions observed by reads
+// Input: None
+// Output: const ReadVersionMap& - variable index to version
+// Side Effects: None
+const ReadVersionMap &Transaction::getReadVersions() const { return readVersions; }
+
 // Description: Records write operation for later commit
 // Input: variableName (string) - variable to write, value (int) - new value
 // Output: None
 // Side Effects: Updates write set
-void Transaction::addWriteVariable(const string &variableName, int value) { writeSet[variableName] = value; }
+void Transaction::addWriteVariable(const string &variableName, int value)
+{
+    // An absolute value replaces increments buffered before it
+    incrementSet.erase(variableName);
+    writeSet[variableName] = value;
+}
+
+// Description: Records an increment to apply on top of the latest committed value
+// Input: variableName (string) - variable to change, delta (int) - amount to add
+// Output: None
+// Side Effects: Updates the increment set, or the write set if the variable was already written
+void Transaction::addIncrement(const string &variableName, int delta)
+{
+    auto written = writeSet.find(variableName);
+    if (written != writeSet.end())
+    {
+        written->second += delta;
+        return;
+    }
+    incrementSet[variableName] += delta;
+}
+
+// Description: Returns increments waiting for commit
+// Input: None
+// Output: const WriteSet& - variable to accumulated delta
+// Side Effects: None
+const WriteSet &Transaction::getIncrementSet() const { return incrementSet; }
 
 // Description: Returns set of variables read by transaction
 // Input: None
-// Output: const set<string>& - read variable set
+// Output: const ReadSet& - read variable set
 // Side Effects: None
-const set<string> &Transaction::getReadSet() const { return readSet; }
+const ReadSet &Transaction::getReadSet() const { return readSet; }
 
 // Description: Returns map of variables and values to be written
 // Input: None
-// Output: const map<string, int>& - write variable map
+// Output: const WriteSet& - write variable map
 // Side Effects: None
-const map<string, int> &Transaction::getWriteSet() const { return writeSet; }
+const WriteSet &Transaction::getWriteSet() const { return writeSet; }
+
+// Description: Pins the transaction's snapshot to a given time
+// Input: time (long) - snapshot timestamp
+// Output: None
+// Side Effects: Later reads are served as of time
+void Transaction::setStartTime(long time) { startTime = time; }
 
 // Description: Sets transaction commit timestamp
 // Input: time (long) - commit timestamp
@@ -106,27 +192,24 @@ void Transaction::addSitesWritten(const vector<int> &siteIds)
 
 // Description: Returns set of sites written to by transaction
 // Input: None
-// Output: const unordered_set<int>& - set of site IDs
+// Output: const SiteSet& - set of site IDs
 // Side Effects: None
-const unordered_set<int> &Transaction::getSitesWrittenTo() const
+const SiteSet &Transaction::getSitesWrittenTo() const
 {
     return sitesWrittenTo;
 }
 
-// Description: Adds dependency on another transaction
-// Input: transactionName (string) - name of dependency
-// Output: None
-// Side Effects: Updates dependency set
-void Transaction::addDependency(const string &transactionName)
-{
-    dependencySet.insert(transactionName);
-}
-
-// Description: Returns set of transaction dependencies
+// Description: Releases the transaction's read/write bookkeeping in one step
 // Input: None
-// Output: const set<string>& - set of dependent transaction names
-// Side Effects: None
-const set<string> &Transaction::getDependencies() const
+// Output: None
+// Side Effects: Empties read set, write set and sites written; resets the arena
+void Transaction::retire()
 {
-    return dependencySet;
+    readSet.clear();
+    writeSet.clear();
+    incrementSet.clear();
+    sitesWrittenTo.clear();
+    readVersions.clear();
+    // Node-based containers keep no arena memory once empty, so the region can go in one step
+    arena.reset();
 }
\ No newline at end of file
@@ -6,10 +6,18 @@
 
 #include "TransactionManager.h"
 #include "CommandParser.h"
+#include <algorithm>
 #include <iostream>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <chrono>
 #include <string>
 #include <regex>
+#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -18,17 +26,50 @@ using namespace std;
 // Output: None
 // Side Effects: Sets up transaction manager state
 TransactionManager::TransactionManager(shared_ptr<DataManager> dm)
-    : dataManager(dm) {}
+    : transactionPool(sizeof(Transaction) + 64), dataManager(dm), concurrencyMode(ConcurrencyMode::SSI),
+      stats{0, 0, 0, 0, 0}, out(&cout), occTable(20), retryEnabled(false), retryLimit(5), retryBackoff(2), commandCount(0),
+      replaying(false), retryRandom(1), retryStats{0, 0, 0, 0, 0}, retentionEnabled(false), commitsAtLastPrune(0),
+      commitsAtLastRebalance(0), commitsAtLastBudgetCheck(0), defining(false), procedureStats{0, 0, 0} {}
 
 namespace
 {
+    // Largest backoff ceiling, in commands, however many attempts failed
+    const int MAX_RETRY_BACKOFF = 64;
+
+    // Commits between two automatic prunes while retention is on
+    const size_t RETENTION_INTERVAL = 64;
+
+    // Commits between two runs of the placement policy while adaptive replication is on
+    const size_t PLACEMENT_INTERVAL = 64;
+
+    // Commits between two checks of version storage against the memory budget
+    const size_t MEMORY_CHECK_INTERVAL = 16;
+
+    // Description: Lists every variable a transaction read, wrote or incremented
+    // Input: transaction - not yet retired
+    // Output: Variable names
+    // Side Effects: None
+    vector<string> accessedVariables(const shared_ptr<Transaction> &transaction)
+    {
+        set<string> variables(transaction->getReadSet().begin(), transaction->getReadSet().end());
+        for (const auto &write : transaction->getWriteSet())
+        {
+            variables.insert(write.first);
+        }
+        for (const auto &increment : transaction->getIncrementSet())
+        {
+            variables.insert(increment.first);
+        }
+        return vector<string>(variables.begin(), variables.end());
+    }
+
     // Description: Extracts numeric index from variable name
     // Input: varName - string (e.g., "x3")
     // Output: integer index or -1 if invalid
     // Side Effects: None    
     int getVarIndex(const string &varName)
     {
-        regex rx("x(\\d+)");
+        static const regex rx("x(\\d+)");
         smatch match;
         if (regex_match(varName, match, rx))
         {
@@ -36,57 +77,294 @@ namespace
         }
         return -1;
     }
+
+    // Description: Parses a whole option value as an integer
+    // Input: value - text to parse, minimum, maximum - accepted range
+    // Output: number - receives the integer; bool - false if value is not an integer in range
+    // Side Effects: None
+    bool parseInteger(const string &value, long minimum, long maximum, long &number)
+    {
+        char *end = nullptr;
+        errno = 0;
+        long parsed = strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || errno == ERANGE || parsed < minimum || parsed > maximum)
+        {
+            return false;
+        }
+        number = parsed;
+        return true;
+    }
+
+    // Description: Parses a whole option value as a finite real number
+    // Input: value - text to parse, minimum - smallest value accepted
+    // Output: number - receives the value; bool - false if value is not such a number
+    // Side Effects: None
+    bool parseReal(const string &value, double minimum, double &number)
+    {
+        char *end = nullptr;
+        errno = 0;
+        double parsed = strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || errno == ERANGE || !isfinite(parsed) || parsed < minimum)
+        {
+            return false;
+        }
+        number = parsed;
+        return true;
+    }
+
+    // Description: Checks whether a name is one of the variables x1..x20
+    // Input: varName
+    // Output: bool
+    // Side Effects: None
+    bool isVariableName(const string &varName)
+    {
+        int index = getVarIndex(varName);
+        return index >= 1 && index <= 20;
+    }
+}
+
+// Description: Parses and runs one command, then admits held transactions and starts retries
+//              that have become due
+// Input: command - one line of input
+// Output: None
+// Side Effects: Executes the command; advances the command clock
+void TransactionManager::processCommand(const string &command)
+{
+    processCommand(CommandParser::parse(command));
+}
+
+// Description: Executes a command parsed ahead of time, e.g. by a TraceReader
+// Input: command - parsed command
+// Output: None
+// Side Effects: Executes command, or adds it to the body of the procedure being defined; may
+//               modify system state, advances the command clock
+void TransactionManager::processCommand(const Command &command)
+{
+    if (defining && command.type != CommandType::DEFINE_END)
+    {
+        // Part of a procedure body; it runs when the procedure is called
+        definitionBody.push_back(command.line);
+    }
+    else
+    {
+        CommandParser parser(*this);
+        parser.execute(command);
+    }
+    advanceClock();
+}
+
+// Description: Counts one command on the clock that admission and retry backoff run on
+// Input: None
+// Output: None
+// Side Effects: Increments the command count, admits held transactions, starts due retries
+void TransactionManager::advanceClock()
+{
+    ++commandCount;
+    admitHeldTransactions();
+    runDueRetries();
+}
+
+// Description: Redirects the messages of the transaction and data managers
+// Input: stream - where messages go from now on
+// Output: None
+// Side Effects: Later messages, including those of the data manager, are written to stream
+void TransactionManager::setOutput(ostream &stream)
+{
+    out = &stream;
+    dataManager->setOutput(stream);
+}
+
+// Description: Returns the stream messages go to
+// Input: None
+// Output: ostream&
+// Side Effects: None
+ostream &TransactionManager::getOutput() const
+{
+    return *out;
+}
+
+// Description: Looks up a transaction, active or finished
+// Input: transactionName
+// Output: shared_ptr<const Transaction> - null if no transaction has the name
+// Side Effects: None
+shared_ptr<const Transaction> TransactionManager::getTransaction(const string &transactionName) const
+{
+    auto it = transactions.find(transactionName);
+    return it == transactions.end() ? nullptr : it->second;
+}
+
+// Description: Checks if operations of a transaction are queued rather than done
+// Input: transactionName
+// Output: bool - true if blocked on a lock, not admitted yet, or backing off before a retry
+// Side Effects: None
+bool TransactionManager::isWaiting(const string &transactionName) const
+{
+    auto pending = pendingOperations.find(transactionName);
+    if (pending != pendingOperations.end() && !pending->second.empty())
+    {
+        return true;
+    }
+    auto retry = retries.find(transactionName);
+    return unadmitted.count(transactionName) || (retry != retries.end() && retry->second.dueAt >= 0);
 }
 
 // Description: Starts a new transaction
-// Input: transactionName - identifier, isReadOnly - read-only flag
+// Input: transactionName - identifier, isReadOnly - read-only flag,
+//        accessSet - variables the transaction declares it will use (may be empty)
 // Output: None
-// Side Effects: Creates new transaction or prints error if exists
-void TransactionManager::beginTransaction(const string &transactionName, bool isReadOnly)
+// Side Effects: Creates new transaction or prints error if exists; with the scheduler on, a
+//               read-write transaction only starts once admitted
+void TransactionManager::beginTransaction(const string &transactionName, bool isReadOnly,
+                                          const vector<string> &accessSet)
 {
-    if (transactions.find(transactionName) != transactions.end())
+    if (transactions.find(transactionName) != transactions.end() || unadmitted.count(transactionName))
+    {
+        *out << "Transaction " << transactionName << " already exists.\n";
+        return;
+    }
+    if (scheduler && !isReadOnly && !replaying)
     {
-        cout << "Transaction " << transactionName << " already exists.\n";
+        if (retryEnabled)
+        {
+            retries[transactionName] = RetryState{false, vector<function<void()>>(), 1, -1};
+        }
+        // Without a declared access set, the first operation predicts it
+        unadmitted[transactionName] = UnadmittedTransaction{accessSet, vector<function<void()>>(), false};
+        if (!accessSet.empty())
+        {
+            tryAdmission(transactionName);
+        }
         return;
     }
 
-    auto transaction = make_shared<Transaction>(transactionName, isReadOnly);
+    // One pooled chunk holds the transaction, its control block and its inline arena
+    auto transaction = allocate_shared<Transaction>(PoolAllocator<Transaction>(transactionPool), transactionName, isReadOnly);
     transactions[transactionName] = transaction;
-    cout << "Transaction " << transactionName << " started"
+    int lockId = static_cast<int>(lockNames.size()) + 1;
+    lockIds[transactionName] = lockId;
+    lockNames[lockId] = transactionName;
+    if (retryEnabled && !replaying)
+    {
+        retries[transactionName] = RetryState{isReadOnly, vector<function<void()>>(), 1, -1};
+    }
+    *out << "Transaction " << transactionName << " started"
          << (isReadOnly ? " (Read-Only)" : "") << ".\n";
 }
 
+// Description: Starts a read-only transaction whose snapshot lies in the past
+// Input: transactionName, asOf - registered snapshot, committed transaction (its commit time) or
+//        timestamp in system clock ticks
+// Output: None
+// Side Effects: Adds the transaction, prints its start or why it cannot start
+void TransactionManager::beginAsOf(const string &transactionName, const string &asOf)
+{
+    if (transactions.find(transactionName) != transactions.end() || unadmitted.count(transactionName))
+    {
+        *out << "Transaction " << transactionName << " already exists.\n";
+        return;
+    }
+    long timestamp = 0;
+    if (!resolveSnapshotTime(transactionName, asOf, timestamp))
+    {
+        return;
+    }
+    bool registered = false;
+    for (const auto &snapshot : snapshots)
+    {
+        registered = registered || snapshot.second == timestamp;
+    }
+    if (!registered && !dataManager->isHistoryRetained(timestamp))
+    {
+        *out << "Cannot begin " << transactionName << " as of " << asOf
+             << ": versions of that time were pruned." << endl;
+        return;
+    }
+
+    // Reads are served as of the pinned time like any read-only snapshot; an abort is not retried
+    auto transaction = allocate_shared<Transaction>(PoolAllocator<Transaction>(transactionPool), transactionName, true);
+    transaction->setStartTime(timestamp);
+    transactions[transactionName] = transaction;
+    *out << "Transaction " << transactionName << " started (Read-Only, as of " << asOf << ").\n";
+}
+
+// Description: Turns a beginAsOf argument into a timestamp
+// Input: transactionName - transaction being begun, asOf - snapshot name, transaction name or number
+// Output: timestamp - the time named; bool - false if asOf names no usable time
+// Side Effects: Prints why the time cannot be used
+bool TransactionManager::resolveSnapshotTime(const string &transactionName, const string &asOf, long &timestamp) const
+{
+    long now = chrono::system_clock::now().time_since_epoch().count();
+    auto snapshot = snapshots.find(asOf);
+    auto transaction = transactions.find(asOf);
+    if (snapshot != snapshots.end())
+    {
+        timestamp = snapshot->second;
+    }
+    else if (transaction != transactions.end())
+    {
+        if (transaction->second->getStatus() != TransactionStatus::COMMITTED || transaction->second->isReadOnly())
+        {
+            *out << "Cannot begin " << transactionName << " as of " << asOf << ": it has not committed writes."
+                 << endl;
+            return false;
+        }
+        timestamp = transaction->second->getCommitTime();
+    }
+    else if (!asOf.empty() && all_of(asOf.begin(), asOf.end(), [](unsigned char c) { return isdigit(c) != 0; }))
+    {
+        timestamp = stol(asOf);
+    }
+    else
+    {
+        *out << "Unknown snapshot: " << asOf << endl;
+        return false;
+    }
+    if (timestamp > now)
+    {
+        *out << "Cannot begin " << transactionName << " as of " << asOf << ": that time is in the future." << endl;
+        return false;
+    }
+    return true;
+}
+
 // Description: Executes read operation for transaction
 // Input: transactionName - transaction ID, variableName - variable to read
 // Output: None
 // Side Effects: Updates read sets, prints value or errors, may abort transaction
 void TransactionManager::read(const string& transactionName, const string& variableName) {
+    if (interceptOperation(transactionName, {variableName}, [=]() { read(transactionName, variableName); })) {
+        return;
+    }
     auto it = transactions.find(transactionName);
     if (it == transactions.end() || it->second->getStatus() != TransactionStatus::ACTIVE) {
-        cout << "Transaction " << transactionName << " is not active.\n";
+        *out << "Transaction " << transactionName << " is not active.\n";
         return;
     }
 
     auto transaction = it->second;
     int varIndex = getVarIndex(variableName);
     if (varIndex < 1 || varIndex > 20) {
-        cout << "Invalid variable name: " << variableName << endl;
-        abortTransaction(transaction);
+        *out << "Invalid variable name: " << variableName << endl;
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+        return;
+    }
+    if (usesLocking(transaction)) {
+        submitOperation(transaction, PendingOperation{PendingOperation::READ, variableName, 0});
         return;
     }
 
     try {
-        int value = dataManager->read(transactionName, variableName, transaction->getStartTime());
-        transaction->addReadVariable(variableName);
-        cout << variableName << ": " << value << endl;
-        readTable[variableName].insert(transaction->getName());
+        int value = dataManager->read(transactionName, variableName, readTimeOf(transaction));
+        recordRead(transaction, variableName);
+        transaction->setLastRead(value);
+        *out << variableName << ": " << value << endl;
     }
     catch (const runtime_error& e) {
         string errorMsg = e.what();
         if (errorMsg == "Transaction must wait") {
             return;  
         }
-        abortTransaction(transaction);
+        abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
     }
 }
 
@@ -96,272 +374,2056 @@ void TransactionManager::read(const string& transactionName, const string& varia
 // Side Effects: Buffers write, updates site lists, may abort transaction
 void TransactionManager::write(const string &transactionName, const string &variableName, int value)
 {
+    if (interceptOperation(transactionName, {variableName}, [=]() { write(transactionName, variableName, value); }))
+    {
+        return;
+    }
     auto it = transactions.find(transactionName);
     if (it == transactions.end() || it->second->getStatus() != TransactionStatus::ACTIVE)
     {
-        cout << "Transaction " << transactionName << " is not active.\n";
+        *out << "Transaction " << transactionName << " is not active.\n";
         return;
     }
 
     auto transaction = it->second;
     if (transaction->isReadOnly())
     {
-        cout << "Read-only transaction " << transactionName << " cannot perform writes.\n";
-        abortTransaction(transaction);
+        *out << "Read-only transaction " << transactionName << " cannot perform writes.\n";
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
         return;
     }
 
     int varIndex = getVarIndex(variableName);
     if (varIndex < 1 || varIndex > 20)
     {
-        cout << "Invalid variable name: " << variableName << endl;
-        abortTransaction(transaction);
+        *out << "Invalid variable name: " << variableName << endl;
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
         return;
     }
-
-    std::vector<int> siteIdsToWrite;
-    if (varIndex % 2 == 0)
-    { // Even variable, replicated
-        for (const auto &site : dataManager->getAllSites())
-        {
-            if (site->getStatus() == SiteStatus::UP)
-            {
-                if (site->hasVariable(variableName))
-                {
-                    siteIdsToWrite.push_back(site->getId());
-                }
-            }
-        }
-    }
-    else
-    { // Odd variable, located at one site
-        int siteId = 1 + (varIndex % 10);
-        auto site = dataManager->getSite(siteId);
-        if (site && site->getStatus() == SiteStatus::UP)
-        {
-            if (site->hasVariable(variableName))
-            {
-                siteIdsToWrite.push_back(siteId);
-            }
-        }
+    if (usesLocking(transaction))
+    {
+        submitOperation(transaction, PendingOperation{PendingOperation::WRITE, variableName, value});
+        return;
     }
 
+    std::vector<int> siteIdsToWrite = collectWriteSites(variableName, getUpSites());
     transaction->addSitesWritten(siteIdsToWrite);
 
     transaction->addWriteVariable(variableName, value);
-    cout << "Write of " << value << " to " << variableName
+    *out << "Write of " << value << " to " << variableName
          << " buffered for transaction " << transactionName << endl;
 }
 
-// Description: Completes transaction execution
-// Input: transactionName - transaction to end
+// Description: Buffers an increment for transaction
+// Input: transactionName - transaction ID, variableName - variable to change, delta - amount to add
 // Output: None
-// Side Effects: Validates and commits/aborts transaction
-void TransactionManager::endTransaction(const string &transactionName)
+// Side Effects: Buffers the increment, updates site lists, may abort transaction
+void TransactionManager::increment(const string &transactionName, const string &variableName, int delta)
 {
-    auto it = transactions.find(transactionName);
-    if (it == transactions.end())
+    if (interceptOperation(transactionName, {variableName},
+                           [=]() { increment(transactionName, variableName, delta); }))
+    {
+        return;
+    }
+    auto transaction = findActiveTransaction(transactionName);
+    if (!transaction)
     {
-        cout << "Transaction " << transactionName << " not found.\n";
         return;
     }
 
-    auto transaction = it->second;
-    if (transaction->getStatus() != TransactionStatus::ACTIVE)
+    if (transaction->isReadOnly())
     {
-        cout << "Transaction " << transactionName << " is not active.\n";
+        *out << "Read-only transaction " << transactionName << " cannot perform writes.\n";
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
         return;
     }
 
-    validateAndCommit(transaction);
+    int varIndex = getVarIndex(variableName);
+    if (varIndex < 1 || varIndex > 20)
+    {
+        *out << "Invalid variable name: " << variableName << endl;
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+        return;
+    }
+    if (usesLocking(transaction))
+    {
+        submitOperation(transaction, PendingOperation{PendingOperation::INCREMENT, variableName, delta});
+        return;
+    }
 
+    transaction->addSitesWritten(collectWriteSites(variableName, getUpSites()));
+    transaction->addIncrement(variableName, delta);
+    *out << "Increment of " << delta << " to " << variableName
+         << " buffered for transaction " << transactionName << endl;
 }
 
-// Description: Validates transaction and attempts to commit
-// Input: transaction - pointer to transaction
-// Output: None
-// Side Effects: Updates transaction status, commits changes or aborts
-void TransactionManager::validateAndCommit(shared_ptr<Transaction> transaction)
+// Description: Looks up a transaction that can still accept operations
+// Input: transactionName - transaction ID
+// Output: Pointer to the active transaction, or null if missing or finished
+// Side Effects: Prints a message when the transaction is not active
+shared_ptr<Transaction> TransactionManager::findActiveTransaction(const string &transactionName)
 {
-    // first checking if the transaction is readonly
-    if (transaction->isReadOnly())
+    auto it = transactions.find(transactionName);
+    if (it == transactions.end() || it->second->getStatus() != TransactionStatus::ACTIVE)
     {
-        transaction->setStatus(TransactionStatus::COMMITTED);
-        cout << transaction->getName() << " committed (Read-Only)." << endl;
-        return;
+        *out << "Transaction " << transactionName << " is not active.\n";
+        return nullptr;
     }
+    return it->second;
+}
 
-    long transactionStartTime = transaction->getStartTime();
-    long transactionCommitTime = std::chrono::system_clock::now().time_since_epoch().count();
-
-    for (int siteId : transaction->getSitesWrittenTo())
+// Description: Returns every site that is currently up
+// Input: None
+// Output: vector of site pointers with status UP
+// Side Effects: None
+vector<shared_ptr<Site>> TransactionManager::getUpSites() const
+{
+    vector<shared_ptr<Site>> upSites;
+    for (const auto &site : dataManager->getAllSites())
     {
-        auto site = dataManager->getSite(siteId);
-        if (site)
+        if (site->getStatus() == SiteStatus::UP)
         {
-            const auto &failureTimes = site->getFailureTimes();
-            for (const auto &[failTime, recoverTime] : failureTimes)
-            {
-                if (failTime <= transactionCommitTime &&
-                    (recoverTime == -1 || recoverTime >= transactionStartTime))
-                {
-                    cout << transaction->getName() << " aborts due to failure of site " << siteId << endl;
-                    abortTransaction(transaction);
-                    return;
-                }
-            }
+            upSites.push_back(site);
         }
     }
+    return upSites;
+}
 
-    // Check write-write conflicts (first-committer wins)
-    bool hasConflict = false;
-    const auto &writeSet = transaction->getWriteSet();
-    long startTime = transaction->getStartTime();
-
-    for (auto it = writeSet.begin(); it != writeSet.end(); ++it)
+// Description: Determines the sites a write to a variable would be applied to
+// Input: variableName - variable name, upSites - sites currently up
+// Output: vector of site IDs holding the variable
+// Side Effects: None
+vector<int> TransactionManager::collectWriteSites(const string &variableName, const vector<shared_ptr<Site>> &upSites) const
+{
+    vector<int> siteIds;
+    if (dataManager->hasQuorum(variableName))
+    { // Quorum writes only need W live replicas at commit, site failures are not fatal
+        return siteIds;
+    }
+    // Every up copy: all replicas, or the one site holding an unreplicated variable
+    for (const auto &site : upSites)
     {
-        const string &variableName = it->first;
-        if (dataManager->hasCommittedWrite(variableName, startTime))
+        if (site->hasVariable(variableName))
         {
-            cout << "Write-write conflict detected on " << variableName
-                 << " for transaction " << transaction->getName() << endl;
-            hasConflict = true;
-            break;
+            siteIds.push_back(site->getId());
         }
     }
+    return siteIds;
+}
 
-    if (hasConflict)
+// Description: Executes a batch of reads for one transaction
+// Input: transactionName - transaction ID, variableNames - variables to read
+// Output: None
+// Side Effects: Updates read sets, prints all values as one block, may abort transaction
+void TransactionManager::readBatch(const string &transactionName, const vector<string> &variableNames)
+{
+    if (interceptOperation(transactionName, variableNames, [=]() { readBatch(transactionName, variableNames); }))
+    {
+        return;
+    }
+    auto transaction = findActiveTransaction(transactionName);
+    if (!transaction)
     {
-        abortTransaction(transaction);
         return;
     }
 
-    for (const auto &variableName : transaction->getReadSet())
+    for (const auto &variableName : variableNames)
     {
-        readTable[variableName].insert(transaction->getName());
+        int varIndex = getVarIndex(variableName);
+        if (varIndex < 1 || varIndex > 20)
+        {
+            *out << "Invalid variable name: " << variableName << endl;
+            abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+            return;
+        }
     }
 
-    for (const auto &[variableName, value] : transaction->getWriteSet())
+    if (usesLocking(transaction))
     {
-        for (const auto &readerTransactionName : readTable[variableName])
+        // Each read takes its own shared lock and may block on it
+        for (const auto &variableName : variableNames)
         {
-            if (readerTransactionName != transaction->getName())
-            {
-                auto readerTransaction = transactions[readerTransactionName];
-                readerTransaction->addDependency(transaction->getName());
-            }
+            submitOperation(transaction, PendingOperation{PendingOperation::READ, variableName, 0});
         }
-        writeTable[variableName].insert(transaction->getName());
+        return;
     }
 
-    for (const auto &variableName : transaction->getReadSet())
+    vector<BatchRead> results = dataManager->readBatch(transactionName, variableNames, readTimeOf(transaction));
+    for (const auto &result : results)
     {
-        for (const auto &writerTransactionName : writeTable[variableName])
+        if (result.status == ReadStatus::ABORT)
         {
-            if (writerTransactionName != transaction->getName())
-            {
-                auto writerTransaction = transactions[writerTransactionName];
-                if (writerTransaction->getCommitTime() == 0 || writerTransaction->getCommitTime() > transaction->getStartTime())
-                {
-                    transaction->addDependency(writerTransactionName);
-                }
-            }
+            abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
+            return;
         }
     }
 
-    // Detect cycles
-    if (detectCycle(transaction->getName()))
+    ostringstream block;
+    for (const auto &result : results)
+    {
+        if (result.status != ReadStatus::OK)
+        {
+            continue;
+        }
+        recordRead(transaction, result.variableName);
+        block << result.variableName << ": " << result.value << "\n";
+    }
+    *out << block.str();
+    out->flush();
+}
+
+// Description: Buffers a batch of writes for one transaction
+// Input: transactionName - transaction ID, writes - (variable, value) pairs
+// Output: None
+// Side Effects: Buffers writes, updates site lists, may abort transaction
+void TransactionManager::writeBatch(const string &transactionName, const vector<pair<string, int>> &writes)
+{
+    vector<string> writtenNames;
+    for (const auto &write : writes)
+    {
+        writtenNames.push_back(write.first);
+    }
+    if (interceptOperation(transactionName, writtenNames, [=]() { writeBatch(transactionName, writes); }))
+    {
+        return;
+    }
+    auto transaction = findActiveTransaction(transactionName);
+    if (!transaction)
     {
-        std::cout << transaction->getName() << " aborts due to cycle in dependency graph." << std::endl;
-        abortTransaction(transaction);
         return;
     }
 
-    // If no conflicts, commit the transaction
-    long commitTime = chrono::system_clock::now().time_since_epoch().count();
-    transaction->setCommitTime(commitTime);
+    if (transaction->isReadOnly())
+    {
+        *out << "Read-only transaction " << transactionName << " cannot perform writes.\n";
+        abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+        return;
+    }
+
+    vector<int> varIndices;
+    varIndices.reserve(writes.size());
+    for (const auto &write : writes)
+    {
+        int varIndex = getVarIndex(write.first);
+        if (varIndex < 1 || varIndex > 20)
+        {
+            *out << "Invalid variable name: " << write.first << endl;
+            abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+            return;
+        }
+        varIndices.push_back(varIndex);
+    }
 
-    dataManager->commitTransaction(transaction);
+    if (usesLocking(transaction))
+    {
+        for (const auto &write : writes)
+        {
+            submitOperation(transaction, PendingOperation{PendingOperation::WRITE, write.first, write.second});
+        }
+        return;
+    }
 
-    transaction->setStatus(TransactionStatus::COMMITTED);
-    cout << transaction->getName() << " committed." << endl;
+    // Site status cannot change inside a batch, so resolve the up sites once
+    vector<shared_ptr<Site>> upSites = getUpSites();
+    for (size_t i = 0; i < writes.size(); ++i)
+    {
+        transaction->addSitesWritten(collectWriteSites(writes[i].first, upSites));
+        transaction->addWriteVariable(writes[i].first, writes[i].second);
+        *out << "Write of " << writes[i].second << " to " << writes[i].first
+             << " buffered for transaction " << transactionName << endl;
+    }
 }
 
-// Description: Aborts a transaction
-// Input: transaction - pointer to transaction to abort
+// Description: Evaluates SUM/MIN/MAX/SCAN over a set of variables at the transaction's snapshot
+// Input: transactionName - transaction ID, op - aggregate to run, variableNames - inputs,
+//        predicate/operand - SCAN filter
 // Output: None
-// Side Effects: Sets status to ABORTED, prints message
-void TransactionManager::abortTransaction(shared_ptr<Transaction> transaction)
+// Side Effects: Updates read sets, prints the result, may abort transaction
+void TransactionManager::aggregate(const string &transactionName, AggregateOp op, const vector<string> &variableNames,
+                                   ScanPredicate predicate, int operand)
 {
-    transaction->setStatus(TransactionStatus::ABORTED);
-    cout << "Transaction " << transaction->getName() << " aborted.\n";
-}
+    if (interceptOperation(transactionName, variableNames,
+                           [=]() { aggregate(transactionName, op, variableNames, predicate, operand); }))
+    {
+        return;
+    }
+    auto transaction = findActiveTransaction(transactionName);
+    if (!transaction)
+    {
+        return;
+    }
 
-// Description: Outputs current database state
-// Input: None
+    for (const auto &variableName : variableNames)
+    {
+        int varIndex = getVarIndex(variableName);
+        if (varIndex < 1 || varIndex > 20)
+        {
+            *out << "Invalid variable name: " << variableName << endl;
+            abortTransaction(transaction, AbortReason::INVALID_OPERATION);
+            return;
+        }
+    }
+    if (variableNames.empty())
+    {
+        return;
+    }
+
+    // Under 2PL the aggregate reads current values once it holds every shared lock, waiting for them in
+    // the transaction's queue like a read does
+    if (usesLocking(transaction))
+    {
+        PendingOperation operation{PendingOperation::AGGREGATE, "", operand};
+        operation.variableNames = variableNames;
+        operation.op = op;
+        operation.predicate = predicate;
+        submitOperation(transaction, operation);
+        return;
+    }
+    printAggregate(transaction, op, variableNames, predicate, operand, readTimeOf(transaction));
+}
+
+// Description: Computes and prints an aggregate over a transaction's reads
+// Input: transaction - active, op, variableNames, predicate, operand - as for aggregate,
+//        timestamp - time the values are read at
 // Output: None
-// Side Effects: Prints site information to console
-void TransactionManager::dump() const
+// Side Effects: Records the reads of a read-write transaction, prints the result; aborts the
+//               transaction if a variable has no valid version
+void TransactionManager::printAggregate(const shared_ptr<Transaction> &transaction, AggregateOp op,
+                                        const vector<string> &variableNames, ScanPredicate predicate, int operand,
+                                        long timestamp)
 {
-    dataManager->dump();
+    const string &transactionName = transaction->getName();
+    vector<int> values;
+    string blockingVariable;
+    ReadStatus status = dataManager->gatherSnapshot(variableNames, timestamp, values, blockingVariable);
+    if (status == ReadStatus::ABORT)
+    {
+        abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
+        return;
+    }
+    if (status == ReadStatus::WAIT)
+    {
+        *out << aggregateName(op) << " for transaction " << transactionName << " skipped: "
+             << blockingVariable << " has no readable copy yet" << endl;
+        return;
+    }
+
+    if (!transaction->isReadOnly())
+    {
+        for (const auto &variableName : variableNames)
+        {
+            recordRead(transaction, variableName);
+        }
+    }
+
+    ostringstream block;
+    switch (op)
+    {
+    case AggregateOp::SUM:
+        block << "SUM: " << sumValues(values.data(), values.size()) << "\n";
+        break;
+    case AggregateOp::MIN:
+        block << "MIN: " << minValue(values.data(), values.size()) << "\n";
+        break;
+    case AggregateOp::MAX:
+        block << "MAX: " << maxValue(values.data(), values.size()) << "\n";
+        break;
+    case AggregateOp::SCAN:
+    {
+        vector<uint32_t> matches;
+        filterValues(values.data(), values.size(), predicate, operand, matches);
+        for (uint32_t i : matches)
+        {
+            block << variableNames[i] << ": " << values[i] << "\n";
+        }
+        block << "SCAN: " << matches.size() << " of " << values.size() << " variables matched\n";
+        break;
+    }
+    }
+    *out << block.str();
+    out->flush();
 }
 
-// Description: Marks site as failed
-// Input: siteId - ID of site to fail 
+// Description: Completes transaction execution
+// Input: transactionName - transaction to end
 // Output: None
-// Side Effects: Updates site status, may affect transactions
-void TransactionManager::failSite(int siteId)
+// Side Effects: Validates and commits/aborts transaction
+void TransactionManager::endTransaction(const string &transactionName)
 {
-    dataManager->failSite(siteId);
+    if (interceptOperation(transactionName, vector<string>(), [=]() { endTransaction(transactionName); }))
+    {
+        return;
+    }
+    auto it = transactions.find(transactionName);
+    if (it == transactions.end())
+    {
+        *out << "Transaction " << transactionName << " not found.\n";
+        return;
+    }
+
+    auto transaction = it->second;
+    if (transaction->getStatus() != TransactionStatus::ACTIVE)
+    {
+        *out << "Transaction " << transactionName << " is not active.\n";
+        return;
+    }
+    if (usesLocking(transaction))
+    {
+        submitOperation(transaction, PendingOperation{PendingOperation::END, "", 0});
+        return;
+    }
+
+    validateAndCommit(transaction);
+
 }
 
-// Description: Recovers failed site
-// Input: siteId - ID of site to recover
+// Description: Ends several transactions together so two-phase commit can batch their messages
+// Input: transactionNames - transactions to end, validated in the given order
 // Output: None
-// Side Effects: Updates site status, processes pending reads
-void TransactionManager::recoverSite(int siteId)
+// Side Effects: Validates each transaction, then commits the survivors as one group
+void TransactionManager::endTransactions(const vector<string> &transactionNames)
 {
-    dataManager->recoverSite(siteId);
+    vector<shared_ptr<Transaction>> group;
+    set<string> groupWrites;
+    for (const auto &transactionName : transactionNames)
+    {
+        // A member waiting to retry ends with its next attempt instead
+        if (interceptOperation(transactionName, vector<string>(), [=]() { endTransaction(transactionName); }))
+        {
+            continue;
+        }
+        auto it = transactions.find(transactionName);
+        if (it == transactions.end())
+        {
+            *out << "Transaction " << transactionName << " not found.\n";
+            continue;
+        }
+        if (it->second->getStatus() != TransactionStatus::ACTIVE)
+        {
+            *out << "Transaction " << transactionName << " is not active.\n";
+            continue;
+        }
+        if (usesLocking(it->second))
+        {
+            submitOperation(it->second, PendingOperation{PendingOperation::END, "", 0});
+            continue;
+        }
+        if (validateForCommit(it->second, &groupWrites))
+        {
+            group.push_back(it->second);
+        }
+    }
+    commitValidated(group);
 }
 
-// Description: Checks for cycles in transaction dependencies
-// Input: transactionName - starting transaction for check
-// Output: bool - true if cycle found
-// Side Effects: None
-bool TransactionManager::detectCycle(const std::string &transactionName)
+// Description: Validates transaction and attempts to commit
+// Input: transaction - pointer to transaction
+// Output: None
+// Side Effects: Updates transaction status, commits changes or aborts
+void TransactionManager::validateAndCommit(shared_ptr<Transaction> transaction)
 {
-    std::set<std::string> visited;
-    std::set<std::string> recursionStack;
-    return dfs(transactionName, visited, recursionStack);
+    if (validateForCommit(transaction, nullptr))
+    {
+        commitValidated(vector<shared_ptr<Transaction>>(1, transaction));
+    }
 }
 
-// Description: Performs DFS for cycle detection
-// Input: transactionName - current node, visited/recursionStack - tracking sets
-// Output: bool - true if cycle found
-// Side Effects: Updates tracking sets
-bool TransactionManager::dfs(const std::string &transactionName, std::set<std::string> &visited, std::set<std::string> &recursionStack)
+// Description: Runs the commit-time checks of a transaction
+// Input: transaction - pointer to transaction, groupWrites - variables written by transactions
+//        validated earlier in the same commit group (null outside a group)
+// Output: bool - true if the transaction's writes should now be committed
+// Side Effects: Commits read-only transactions, aborts failing ones, sets the commit time
+bool TransactionManager::validateForCommit(shared_ptr<Transaction> transaction, set<string> *groupWrites)
 {
-    if (recursionStack.count(transactionName))
+    // first checking if the transaction is readonly
+    if (transaction->isReadOnly())
+    {
+        transaction->setStatus(TransactionStatus::COMMITTED);
+        transaction->retire();
+        ++stats.committed;
+        *out << transaction->getName() << " committed (Read-Only)." << endl;
+        finishRetry(transaction);
+        return false;
+    }
+
+    long transactionStartTime = transaction->getStartTime();
+    long transactionCommitTime = std::chrono::system_clock::now().time_since_epoch().count();
+
+    for (int siteId : transaction->getSitesWrittenTo())
+    {
+        auto site = dataManager->getSite(siteId);
+        // Under available copies any failure since the start aborts, whether or not a catch-up healed it
+        if (site && site->wasDownDuring(transactionStartTime, transactionCommitTime, true))
+        {
+            *out << transaction->getName() << " aborts due to failure of site " << siteId << endl;
+            abortTransaction(transaction, AbortReason::SITE_FAILURE);
+            return false;
+        }
+    }
+
+    // Increments write like any other write, except that they never conflict with each other
+    vector<string> written;
+    for (const auto &write : transaction->getWriteSet())
     {
-        // Cycle detected
+        written.push_back(write.first);
+    }
+    for (const auto &increment : transaction->getIncrementSet())
+    {
+        written.push_back(increment.first);
+    }
+
+    for (const auto &variableName : written)
+    {
+        if (!dataManager->canWriteQuorum(variableName))
+        {
+            *out << transaction->getName() << " aborts: write quorum for " << variableName
+                 << " is unavailable" << endl;
+            abortTransaction(transaction, AbortReason::UNAVAILABLE);
+            return false;
+        }
+    }
+
+    for (const auto &increment : transaction->getIncrementSet())
+    {
+        int base;
+        if (!dataManager->readLatestCommitted(increment.first, base))
+        {
+            *out << transaction->getName() << " aborts: no live copy of " << increment.first
+                 << " to increment" << endl;
+            abortTransaction(transaction, AbortReason::UNAVAILABLE);
+            return false;
+        }
+    }
+
+    if (usesLocking(transaction))
+    {
+        // Exclusive locks held until now already rule out conflicting writers and readers
+        transaction->setCommitTime(chrono::system_clock::now().time_since_epoch().count());
         return true;
     }
-    if (visited.count(transactionName))
+    if (usesOcc(transaction))
+    {
+        return validateOptimistic(transaction, groupWrites);
+    }
+
+    // Check write-write conflicts (first-committer wins)
+    bool hasConflict = false;
+    const auto &writeSet = transaction->getWriteSet();
+    long startTime = transaction->getStartTime();
+
+    for (auto it = writeSet.begin(); it != writeSet.end(); ++it)
+    {
+        const string &variableName = it->first;
+        if (dataManager->hasCommittedWrite(variableName, startTime) ||
+            (groupWrites && groupWrites->count(variableName)))
+        {
+            *out << "Write-write conflict detected on " << variableName
+                 << " for transaction " << transaction->getName() << endl;
+            hasConflict = true;
+            break;
+        }
+    }
+
+    if (hasConflict)
     {
-        // Already visited
+        abortTransaction(transaction, AbortReason::WRITE_CONFLICT);
         return false;
     }
-    visited.insert(transactionName);
-    recursionStack.insert(transactionName);
 
-    auto transaction = transactions[transactionName];
-    for (const auto &dep : transaction->getDependencies())
+    for (const auto &variableName : transaction->getReadSet())
+    {
+        readTable[variableName].insert(transaction->getName());
+    }
+
+    for (const auto &variableName : written)
     {
-        if (dfs(dep, visited, recursionStack))
+        for (const auto &readerTransactionName : readTable[variableName])
         {
-            return true;
+            if (readerTransactionName != transaction->getName())
+            {
+                dependencyGraph.addDependency(readerTransactionName, transaction->getName());
+            }
         }
+        writeTable[variableName].insert(transaction->getName());
     }
-    recursionStack.erase(transactionName);
-    return false;
+
+    for (const auto &variableName : transaction->getReadSet())
+    {
+        for (const auto &writerTransactionName : writeTable[variableName])
+        {
+            if (writerTransactionName != transaction->getName())
+            {
+                auto writerTransaction = transactions[writerTransactionName];
+                if (writerTransaction->getCommitTime() == 0 || writerTransaction->getCommitTime() > transaction->getStartTime())
+                {
+                    dependencyGraph.addDependency(transaction->getName(), writerTransactionName);
+                }
+            }
+        }
+    }
+
+    // Detect cycles
+    if (dependencyGraph.reachesCycle(transaction->getName()))
+    {
+        *out << transaction->getName() << " aborts due to cycle in dependency graph." << std::endl;
+        abortTransaction(transaction, AbortReason::DEPENDENCY_CYCLE);
+        return false;
+    }
+
+    // If no conflicts, commit the transaction
+    long commitTime = chrono::system_clock::now().time_since_epoch().count();
+    transaction->setCommitTime(commitTime);
+
+    if (groupWrites)
+    {
+        for (const auto &write : transaction->getWriteSet())
+        {
+            groupWrites->insert(write.first);
+        }
+    }
+    return true;
+}
+
+// Description: Applies the writes of validated transactions, through two-phase commit when enabled
+// Input: group - validated transactions with commit times
+// Output: None
+// Side Effects: Commits or aborts each transaction and prints the result
+void TransactionManager::commitValidated(const vector<shared_ptr<Transaction>> &group)
+{
+    resolveIncrements(group);
+    vector<CommitOutcome> outcomes;
+    if (commitCoordinator)
+    {
+        outcomes = commitCoordinator->commit(group);
+    }
+    for (size_t i = 0; i < group.size(); ++i)
+    {
+        const auto &transaction = group[i];
+        if (!commitCoordinator)
+        {
+            dataManager->commitTransaction(transaction);
+        }
+        else if (!outcomes[i].committed)
+        {
+            releaseOccWrites(transaction, false);
+            *out << transaction->getName() << " aborts: site " << outcomes[i].rejectingSite
+                 << " did not vote to commit" << endl;
+            abortTransaction(transaction, AbortReason::VOTE_REJECTED);
+            continue;
+        }
+        releaseOccWrites(transaction, true);
+        finishAdmission(transaction, true, accessedVariables(transaction));
+        transaction->setStatus(TransactionStatus::COMMITTED);
+        transaction->retire();
+        ++stats.committed;
+        *out << transaction->getName() << " committed." << endl;
+        finishRetry(transaction);
+        releaseLocks(transaction);
+    }
+    if (retentionEnabled && stats.committed - commitsAtLastPrune >= RETENTION_INTERVAL)
+    {
+        applyRetention();
+    }
+    if (dataManager->getMemoryBudget() && stats.committed - commitsAtLastBudgetCheck >= MEMORY_CHECK_INTERVAL)
+    {
+        commitsAtLastBudgetCheck = stats.committed;
+        dataManager->enforceMemoryBudget(getProtectedTimes());
+    }
+    if (dataManager->isAdaptivePlacement() && stats.committed - commitsAtLastRebalance >= PLACEMENT_INTERVAL)
+    {
+        applyPlacement();
+    }
+}
+
+// Description: Computes the values increments install, in commit order
+// Input: group - validated transactions about to commit
+// Output: None
+// Side Effects: Moves each increment into its transaction's write set as an absolute value
+void TransactionManager::resolveIncrements(const vector<shared_ptr<Transaction>> &group)
+{
+    // Values left by earlier members of the group, which have not reached the sites yet
+    map<string, int> groupValues;
+    for (const auto &transaction : group)
+    {
+        vector<pair<string, int>> resolved;
+        for (const auto &increment : transaction->getIncrementSet())
+        {
+            int base = 0;
+            auto earlier = groupValues.find(increment.first);
+            if (earlier != groupValues.end())
+            {
+                base = earlier->second;
+            }
+            else
+            {
+                // Validation made sure a copy is live
+                dataManager->readLatestCommitted(increment.first, base);
+            }
+            resolved.push_back(make_pair(increment.first, base + increment.second));
+        }
+        for (const auto &write : resolved)
+        {
+            transaction->addWriteVariable(write.first, write.second);
+        }
+        for (const auto &write : transaction->getWriteSet())
+        {
+            groupValues[write.first] = write.second;
+        }
+    }
+}
+
+// Description: Validates an optimistic transaction without consulting other transactions
+// Input: transaction - pointer to transaction, groupWrites - variables written by transactions
+//        validated earlier in the same commit group (null outside a group)
+// Output: bool - true if the transaction's writes should now be committed
+// Side Effects: Locks the write set's version words until commitValidated installs or unlocks
+//               them, sets the commit time, aborts on a failed validation
+bool TransactionManager::validateOptimistic(shared_ptr<Transaction> transaction, set<string> *groupWrites)
+{
+    vector<string> written;
+    for (const auto &write : transaction->getWriteSet())
+    {
+        written.push_back(write.first);
+    }
+    for (const auto &increment : transaction->getIncrementSet())
+    {
+        written.push_back(increment.first);
+    }
+
+    vector<int> writes;
+    for (const auto &variableName : written)
+    {
+        // An earlier member of the group still holds the word and would never release it to us
+        if (groupWrites && groupWrites->count(variableName))
+        {
+            *out << "Write-write conflict detected on " << variableName
+                 << " for transaction " << transaction->getName() << endl;
+            abortTransaction(transaction, AbortReason::WRITE_CONFLICT);
+            return false;
+        }
+        writes.push_back(getVarIndex(variableName));
+    }
+    // Variable order is the global lock order
+    sort(writes.begin(), writes.end());
+
+    const ReadVersionMap &readVersions = transaction->getReadVersions();
+    vector<pair<int, uint64_t>> reads(readVersions.begin(), readVersions.end());
+    occTable.lockWrites(writes);
+    if (!occTable.validateReads(reads, writes))
+    {
+        occTable.unlock(writes);
+        ++stats.validationFailures;
+        *out << transaction->getName() << " aborts: a variable it read was overwritten" << endl;
+        abortTransaction(transaction, AbortReason::READ_INVALIDATED);
+        return false;
+    }
+
+    uint64_t now = chrono::system_clock::now().time_since_epoch().count();
+    transaction->setCommitTime(static_cast<long>(occTable.chooseTid(reads, writes, now)));
+    occLockedWrites[transaction->getName()] = writes;
+    if (groupWrites)
+    {
+        groupWrites->insert(written.begin(), written.end());
+    }
+    return true;
+}
+
+// Description: Finishes the version words of an optimistic transaction after commit or abort
+// Input: transaction, committed - true to install the commit time as the new version
+// Output: None
+// Side Effects: Unlocks the words; does nothing for transactions that locked none
+void TransactionManager::releaseOccWrites(const shared_ptr<Transaction> &transaction, bool committed)
+{
+    auto it = occLockedWrites.find(transaction->getName());
+    if (it == occLockedWrites.end())
+    {
+        return;
+    }
+    if (committed)
+    {
+        occTable.install(it->second, static_cast<uint64_t>(transaction->getCommitTime()));
+    }
+    else
+    {
+        occTable.unlock(it->second);
+    }
+    occLockedWrites.erase(it);
+}
+
+// Description: Aborts a transaction
+// Input: transaction - pointer to transaction to abort, reason - why it aborts
+// Output: None
+// Side Effects: Sets status to ABORTED and records the reason, prints message
+void TransactionManager::abortTransaction(shared_ptr<Transaction> transaction, AbortReason reason)
+{
+    finishAdmission(transaction, false, accessedVariables(transaction));
+    transaction->setStatus(TransactionStatus::ABORTED);
+    transaction->setAbortReason(reason);
+    transaction->retire();
+    ++stats.aborted;
+    pendingOperations.erase(transaction->getName());
+    *out << "Transaction " << transaction->getName() << " aborted.\n";
+    scheduleRetry(transaction);
+    releaseLocks(transaction);
+}
+
+// Description: Applies retry logging and admission control to an incoming operation
+// Input: transactionName, variables - variables the operation touches, operation - call that runs it
+// Output: bool - true if the operation was queued (or already run on admission) and must not run now
+// Side Effects: See logOperation and holdOperation
+bool TransactionManager::interceptOperation(const string &transactionName, const vector<string> &variables,
+                                            const function<void()> &operation)
+{
+    return logOperation(transactionName, operation) || holdOperation(transactionName, variables, operation);
+}
+
+// Description: Keeps the operations of a transaction that has not been admitted
+// Input: transactionName, variables, operation
+// Output: bool - true if the transaction is not admitted, so the caller must not run the operation
+// Side Effects: Queues the operation; the first operation predicts the access set and triggers an
+//               admission attempt, which runs the queue if it succeeds. Admitted transactions
+//               claim the hot variables they go on to use
+bool TransactionManager::holdOperation(const string &transactionName, const vector<string> &variables,
+                                       const function<void()> &operation)
+{
+    if (!scheduler || replaying)
+    {
+        return false;
+    }
+    auto it = unadmitted.find(transactionName);
+    if (it == unadmitted.end())
+    {
+        scheduler->claim(transactionName, variables);
+        return false;
+    }
+    it->second.operations.push_back(operation);
+    if (!it->second.held)
+    {
+        if (it->second.accessSet.empty())
+        {
+            it->second.accessSet = variables;
+        }
+        tryAdmission(transactionName);
+    }
+    return true;
+}
+
+// Description: Tries to admit a transaction that has not started
+// Input: transactionName - an entry of unadmitted
+// Output: bool - true if it was admitted and started
+// Side Effects: Starts the transaction and runs its queued operations, or marks it held
+bool TransactionManager::tryAdmission(const string &transactionName)
+{
+    UnadmittedTransaction &entry = unadmitted[transactionName];
+    string blockingVariable;
+    if (!scheduler->tryAdmit(transactionName, entry.accessSet, blockingVariable))
+    {
+        if (!entry.held)
+        {
+            entry.held = true;
+            scheduler->markHeld(transactionName);
+            admissionQueue.push_back(transactionName);
+            *out << "Transaction " << transactionName << " held: " << blockingVariable << " is hot and in use by "
+                 << scheduler->getClaimant(blockingVariable) << endl;
+        }
+        return false;
+    }
+    if (entry.held)
+    {
+        admissionQueue.erase(find(admissionQueue.begin(), admissionQueue.end(), transactionName));
+    }
+
+    UnadmittedTransaction admitted = entry;
+    unadmitted.erase(transactionName);
+    // Queued operations were logged for retry when they arrived; run them as a replay
+    bool wasReplaying = replaying;
+    replaying = true;
+    beginTransaction(transactionName, false);
+    auto transaction = transactions[transactionName];
+    for (const auto &operation : admitted.operations)
+    {
+        if (transaction->getStatus() != TransactionStatus::ACTIVE)
+        {
+            break;
+        }
+        operation();
+    }
+    replaying = wasReplaying;
+    return true;
+}
+
+// Description: Gives held transactions another chance after others finished
+// Input: None
+// Output: None
+// Side Effects: Admits and runs held transactions, oldest first; a held transaction does not
+//               block later ones that do not conflict
+void TransactionManager::admitHeldTransactions()
+{
+    bool admittedAny = true;
+    while (scheduler && admittedAny)
+    {
+        admittedAny = false;
+        vector<string> held(admissionQueue.begin(), admissionQueue.end());
+        for (const auto &transactionName : held)
+        {
+            if (unadmitted.count(transactionName) && tryAdmission(transactionName))
+            {
+                admittedAny = true;
+            }
+        }
+    }
+}
+
+// Description: Tells the scheduler how a read-write transaction ended
+// Input: transaction, committed - outcome, variables - what it read or wrote
+// Output: None
+// Side Effects: Updates conflict heat and releases the transaction's claims
+void TransactionManager::finishAdmission(const shared_ptr<Transaction> &transaction, bool committed,
+                                         const vector<string> &variables)
+{
+    if (scheduler && !transaction->isReadOnly())
+    {
+        scheduler->finish(transaction->getName(), committed, variables);
+    }
+}
+
+// Description: Records an operation of a transaction under automatic retry
+// Input: transactionName, operation - call that repeats the operation
+// Output: bool - true if the transaction is waiting for its next attempt, so the operation
+//         must not run now
+// Side Effects: Appends to the operation log; prints when the operation is deferred
+bool TransactionManager::logOperation(const string &transactionName, const function<void()> &operation)
+{
+    if (!retryEnabled || replaying)
+    {
+        return false;
+    }
+    auto it = retries.find(transactionName);
+    if (it == retries.end())
+    {
+        return false;
+    }
+    it->second.log.push_back(operation);
+    if (it->second.dueAt < 0)
+    {
+        return false;
+    }
+    *out << "Transaction " << transactionName << " is waiting to retry; operation queued." << endl;
+    return true;
+}
+
+// Description: Arranges for an aborted transaction to run again
+// Input: transaction - just aborted
+// Output: None
+// Side Effects: Sets when the next attempt starts, or drops the transaction after its last attempt
+void TransactionManager::scheduleRetry(const shared_ptr<Transaction> &transaction)
+{
+    auto it = retries.find(transaction->getName());
+    if (!retryEnabled || it == retries.end())
+    {
+        return;
+    }
+    RetryState &state = it->second;
+    if (state.attempts >= retryLimit)
+    {
+        ++retryStats.givenUp;
+        *out << transaction->getName() << " gives up after " << state.attempts << " attempt"
+             << (state.attempts == 1 ? "" : "s") << "." << endl;
+        retries.erase(it);
+        return;
+    }
+
+    // Full jitter: wait a uniform number of commands up to a ceiling that doubles per attempt
+    long ceiling = retryBackoff;
+    for (int i = 1; i < state.attempts && ceiling < MAX_RETRY_BACKOFF; ++i)
+    {
+        ceiling *= 2;
+    }
+    ceiling = min(ceiling, (long)MAX_RETRY_BACKOFF);
+    uniform_int_distribution<long> jitter(1, max(ceiling, 1L));
+    long delay = jitter(retryRandom);
+    state.dueAt = commandCount + delay;
+    retryStats.backoffCommands += delay;
+    *out << transaction->getName() << " will retry after " << delay << " command" << (delay == 1 ? "" : "s")
+         << "." << endl;
+}
+
+// Description: Completes retry tracking of a committed transaction
+// Input: transaction - just committed
+// Output: None
+// Side Effects: Updates retry counters
+void TransactionManager::finishRetry(const shared_ptr<Transaction> &transaction)
+{
+    auto it = retries.find(transaction->getName());
+    if (it == retries.end())
+    {
+        return;
+    }
+    ++retryStats.commits;
+    if (it->second.attempts > 1)
+    {
+        ++retryStats.commitsAfterRetry;
+    }
+    retries.erase(it);
+}
+
+// Description: Re-executes transactions whose backoff has elapsed
+// Input: None
+// Output: None
+// Side Effects: Replaces each aborted transaction with a fresh one (new start time) and replays
+//               its log, which prints as the original operations did
+void TransactionManager::runDueRetries()
+{
+    vector<string> due;
+    for (const auto &entry : retries)
+    {
+        if (entry.second.dueAt >= 0 && entry.second.dueAt <= commandCount)
+        {
+            due.push_back(entry.first);
+        }
+    }
+    for (const auto &transactionName : due)
+    {
+        // An earlier replay may have changed this transaction's state
+        auto it = retries.find(transactionName);
+        if (it == retries.end() || it->second.dueAt < 0)
+        {
+            continue;
+        }
+        RetryState &state = it->second;
+        state.dueAt = -1;
+        ++state.attempts;
+        ++retryStats.retries;
+        *out << "Retrying " << transactionName << " (attempt " << state.attempts << ")" << endl;
+        vector<function<void()>> log = state.log;
+        bool readOnly = state.readOnly;
+
+        // The aborted attempt's reads and writes must not put the new one in the dependency graph
+        transactions.erase(transactionName);
+        dependencyGraph.clearDependencies(transactionName);
+        for (auto &readers : readTable)
+        {
+            readers.second.erase(transactionName);
+        }
+        for (auto &writers : writeTable)
+        {
+            writers.second.erase(transactionName);
+        }
+
+        replaying = true;
+        beginTransaction(transactionName, readOnly);
+        auto transaction = transactions[transactionName];
+        for (const auto &operation : log)
+        {
+            if (transaction->getStatus() != TransactionStatus::ACTIVE)
+            {
+                break;
+            }
+            operation();
+        }
+        replaying = false;
+    }
+}
+
+// Description: Tells whether a transaction is validated optimistically
+// Input: transaction
+// Output: bool - true for read-write transactions in OCC mode (read-only ones keep using snapshots)
+// Side Effects: None
+bool TransactionManager::usesOcc(const shared_ptr<Transaction> &transaction) const
+{
+    return concurrencyMode == ConcurrencyMode::OCC && !transaction->isReadOnly();
+}
+
+// Description: Records a successful read for commit-time checks
+// Input: transaction, variableName
+// Output: None
+// Side Effects: Adds to the read set; SSI also registers the reader for the dependency graph,
+//               OCC records the variable's current version (commands run one at a time, so it
+//               is the version the read just saw)
+void TransactionManager::recordRead(const shared_ptr<Transaction> &transaction, const string &variableName)
+{
+    transaction->addReadVariable(variableName);
+    if (usesOcc(transaction))
+    {
+        int varIndex = getVarIndex(variableName);
+        transaction->addReadVersion(varIndex, occTable.readVersion(varIndex));
+        return;
+    }
+    readTable[variableName].insert(transaction->getName());
+}
+
+// Description: Chooses the time a transaction's reads are served at
+// Input: transaction
+// Output: long - start time for snapshot reads, the current time for optimistic reads
+// Side Effects: None
+long TransactionManager::readTimeOf(const shared_ptr<Transaction> &transaction) const
+{
+    if (usesOcc(transaction))
+    {
+        // Optimistic reads see the latest committed value and are checked at commit instead
+        return chrono::system_clock::now().time_since_epoch().count();
+    }
+    return transaction->getStartTime();
+}
+
+// Description: Tells whether a transaction is subject to strict two-phase locking
+// Input: transaction
+// Output: bool - true for read-write transactions in 2PL mode (read-only ones keep using snapshots)
+// Side Effects: None
+bool TransactionManager::usesLocking(const shared_ptr<Transaction> &transaction) const
+{
+    return concurrencyMode == ConcurrencyMode::STRICT_2PL && !transaction->isReadOnly();
+}
+
+// Description: Runs an operation under 2PL, keeping the transaction's operations in order
+// Input: transaction, operation
+// Output: None
+// Side Effects: Queues the operation if an earlier one is still waiting for a lock
+void TransactionManager::submitOperation(shared_ptr<Transaction> transaction, const PendingOperation &operation)
+{
+    auto pending = pendingOperations.find(transaction->getName());
+    if (pending != pendingOperations.end() && !pending->second.empty())
+    {
+        pending->second.push_back(operation);
+        return;
+    }
+    runLockedOperation(transaction, operation);
+}
+
+// Description: Locks what an operation touches and performs it
+// Input: transaction, operation - read, aggregate, buffered write or end
+// Output: bool - false if the operation now waits for a lock at the head of the transaction's queue
+// Side Effects: Reads and aggregates print values, writes are buffered, end commits; waits may trigger
+//               deadlock handling
+bool TransactionManager::runLockedOperation(shared_ptr<Transaction> transaction, const PendingOperation &operation)
+{
+    const string &transactionName = transaction->getName();
+    const string &variableName = operation.variableName;
+    if (operation.kind == PendingOperation::END)
+    {
+        validateAndCommit(transaction);
+        return true;
+    }
+
+    int blockedSite = -1;
+    string blockedVariable = variableName;
+    if (operation.kind == PendingOperation::AGGREGATE)
+    {
+        // Shared locks on the copy each variable is read from, all held before any value is read
+        long now = chrono::system_clock::now().time_since_epoch().count();
+        for (const auto &name : operation.variableNames)
+        {
+            int siteId;
+            try
+            {
+                siteId = dataManager->selectReadSite(name, now);
+            }
+            catch (const runtime_error &)
+            {
+                abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
+                return true;
+            }
+            blockedSite = siteId > 0 ? acquireLocks(transaction, vector<int>(1, siteId), name, READ_LOCK) : -1;
+            if (blockedSite >= 0)
+            {
+                blockedVariable = name;
+                break;
+            }
+        }
+        if (blockedSite < 0)
+        {
+            printAggregate(transaction, operation.op, operation.variableNames, operation.predicate, operation.value,
+                           now);
+            return true;
+        }
+    }
+    else if (operation.kind == PendingOperation::READ)
+    {
+        long now = chrono::system_clock::now().time_since_epoch().count();
+        int siteId;
+        try
+        {
+            siteId = dataManager->selectReadSite(variableName, now);
+        }
+        catch (const runtime_error &)
+        {
+            abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
+            return true;
+        }
+        blockedSite = siteId > 0 ? acquireLocks(transaction, vector<int>(1, siteId), variableName, READ_LOCK) : -1;
+        if (blockedSite < 0)
+        {
+            try
+            {
+                int value = dataManager->read(transactionName, variableName, now);
+                transaction->addReadVariable(variableName);
+                transaction->setLastRead(value);
+                *out << variableName << ": " << value << endl;
+            }
+            catch (const runtime_error &e)
+            {
+                if (string(e.what()) != "Transaction must wait")
+                {
+                    abortTransaction(transaction, AbortReason::NO_VALID_VERSION);
+                }
+            }
+            return true;
+        }
+    }
+    else
+    {
+        // Exclusive locks on every copy that is not down, as available-copies writes need
+        vector<int> siteIds;
+        for (const auto &site : dataManager->getAllSites())
+        {
+            if (site->getStatus() != SiteStatus::DOWN && site->hasVariable(variableName))
+            {
+                siteIds.push_back(site->getId());
+            }
+        }
+        blockedSite = acquireLocks(transaction, siteIds, variableName, WRITE_LOCK);
+        if (blockedSite < 0)
+        {
+            transaction->addSitesWritten(collectWriteSites(variableName, getUpSites()));
+            if (operation.kind == PendingOperation::INCREMENT)
+            {
+                transaction->addIncrement(variableName, operation.value);
+                *out << "Increment of " << operation.value << " to " << variableName
+                     << " buffered for transaction " << transactionName << endl;
+                return true;
+            }
+            transaction->addWriteVariable(variableName, operation.value);
+            *out << "Write of " << operation.value << " to " << variableName
+                 << " buffered for transaction " << transactionName << endl;
+            return true;
+        }
+    }
+
+    pendingOperations[transactionName].push_front(operation);
+    ++stats.lockWaits;
+    *out << "Transaction " << transactionName << " waits for a lock on " << blockedVariable
+         << " at site " << blockedSite << endl;
+    breakDeadlocks();
+    return false;
+}
+
+// Description: Requests the same lock at several sites, stopping at the first that makes it wait
+// Input: transaction, siteIds, variableName, type
+// Output: int - site where the request waits, -1 if every lock is held
+// Side Effects: Updates the lock tables
+int TransactionManager::acquireLocks(shared_ptr<Transaction> transaction, const vector<int> &siteIds,
+                                     const string &variableName, Lock_type type)
+{
+    int lockId = lockIds[transaction->getName()];
+    int varIndex = getVarIndex(variableName);
+    for (int siteId : siteIds)
+    {
+        if (lockManager.acquire(lockId, siteId, varIndex, type) != LockResult::GRANTED)
+        {
+            return siteId;
+        }
+    }
+    return -1;
+}
+
+// Description: Resolves deadlocks by aborting the youngest transaction on each cycle
+// Input: None
+// Output: None
+// Side Effects: Aborts transactions, which releases their locks
+void TransactionManager::breakDeadlocks()
+{
+    int victim;
+    while ((victim = lockManager.findDeadlockVictim()) >= 0)
+    {
+        ++stats.deadlocks;
+        auto transaction = transactions[lockNames[victim]];
+        *out << "Deadlock detected, aborting youngest transaction " << transaction->getName() << endl;
+        abortTransaction(transaction, AbortReason::DEADLOCK);
+    }
+}
+
+// Description: Releases the locks of a committed or aborted transaction
+// Input: transaction
+// Output: None
+// Side Effects: Lets waiting transactions continue
+void TransactionManager::releaseLocks(const shared_ptr<Transaction> &transaction)
+{
+    auto it = lockIds.find(transaction->getName());
+    if (it != lockIds.end())
+    {
+        resumeTransactions(lockManager.releaseAll(it->second));
+    }
+}
+
+// Description: Continues transactions that were waiting for a lock
+// Input: lockIdsToResume - lock table IDs of transactions granted a lock they waited for
+// Output: None
+// Side Effects: Runs queued operations until each transaction blocks again or runs out of work
+void TransactionManager::resumeTransactions(const vector<int> &lockIdsToResume)
+{
+    for (int lockId : lockIdsToResume)
+    {
+        auto transaction = transactions[lockNames[lockId]];
+        while (transaction->getStatus() == TransactionStatus::ACTIVE)
+        {
+            auto pending = pendingOperations.find(transaction->getName());
+            if (pending == pendingOperations.end() || pending->second.empty())
+            {
+                break;
+            }
+            PendingOperation operation = pending->second.front();
+            pending->second.pop_front();
+            if (!runLockedOperation(transaction, operation))
+            {
+                break;
+            }
+        }
+    }
+}
+
+// Description: Outputs current database state
+// Input: None
+// Output: None
+// Side Effects: Prints site information to console
+void TransactionManager::dump() const
+{
+    dataManager->dump();
+}
+
+// Description: Marks site as failed
+// Input: siteId - ID of site to fail 
+// Output: None
+// Side Effects: Updates site status, may affect transactions
+void TransactionManager::failSite(int siteId)
+{
+    dataManager->failSite(siteId);
+    // Locks at a failed site are lost; transactions queued there retry elsewhere
+    resumeTransactions(lockManager.clearSite(siteId));
+}
+
+// Description: Recovers failed site
+// Input: siteId - ID of site to recover
+// Output: None
+// Side Effects: Updates site status, processes pending reads
+void TransactionManager::recoverSite(int siteId)
+{
+    if (!commitCoordinator)
+    {
+        dataManager->recoverSite(siteId);
+        return;
+    }
+    CommitCoordinator *coordinator = commitCoordinator.get();
+    dataManager->recoverSite(siteId, [coordinator, siteId]() { coordinator->resolveInDoubt(siteId); });
+}
+
+// Description: Applies a runtime configuration option
+// Input: option - option name, value - new setting ("on"/"off" for switches)
+// Output: None
+// Side Effects: Changes system behavior, prints confirmation or an error
+void TransactionManager::configure(const string &option, const string &value)
+{
+    bool on = value == "on" || value == "1" || value == "true";
+    if (option == "catchup")
+    {
+        dataManager->setCatchUpEnabled(on);
+    }
+    else if (option == "lazyreplication")
+    {
+        dataManager->setLazyReplication(on);
+    }
+    else if (option == "compression")
+    {
+        dataManager->setCompression(on);
+    }
+    else if (option == "cdc" || option == "cdccapacity")
+    {
+        long capacity = 1024;
+        if (option == "cdccapacity" && !parseInteger(value, 1, LONG_MAX, capacity))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        // A new feed starts empty, so subscriptions to the old one end
+        subscribers.clear();
+        dataManager->setChangeCapture(on || option == "cdccapacity", static_cast<size_t>(capacity));
+    }
+    else if (dataManager->getChangeFeed() && option == "cdcfile")
+    {
+        if (value == "off")
+        {
+            dataManager->getChangeFeed()->closeSink();
+        }
+        else if (!dataManager->getChangeFeed()->openSink(value))
+        {
+            *out << "Cannot open change file " << value << endl;
+            return;
+        }
+    }
+    else if (option == "processes")
+    {
+        dataManager->setSiteProcesses(on);
+    }
+    else if (option == "placement")
+    {
+        for (const auto &entry : transactions)
+        {
+            if (entry.second->getStatus() == TransactionStatus::ACTIVE)
+            {
+                *out << "Option placement cannot change while transactions are active." << endl;
+                return;
+            }
+        }
+        // A trailing number is the copies of every variable, e.g. hash3
+        size_t digits = value.find_first_of("0123456789");
+        string policy = value.substr(0, digits);
+        int numSites = dataManager->getSiteCount();
+        long count = 1;
+        if (digits != string::npos && !parseInteger(value.substr(digits), 1, numSites, count))
+        {
+            *out << "Invalid copies for placement " << value << ": expected 1 to " << numSites << endl;
+            return;
+        }
+        int copies = static_cast<int>(count);
+        ReplicaLists placement;
+        if (policy == "parity")
+        {
+            placement = placeVariables(defaultPlacement(numSites), 20);
+        }
+        else if (policy == "modulo")
+        {
+            placement = placeVariables(ModuloPlacement(numSites, copies), 20);
+        }
+        else if (policy == "range")
+        {
+            placement = placeVariables(RangePlacement(numSites, 20, copies), 20);
+        }
+        else if (policy == "hash")
+        {
+            placement = placeVariables(ConsistentHashPlacement(numSites, copies), 20);
+        }
+        else if (policy == "all")
+        {
+            placement = placeVariables(ReplicateAllPlacement(numSites), 20);
+        }
+        else
+        {
+            *out << "Unknown placement: " << value << endl;
+            return;
+        }
+        string error;
+        if (!dataManager->setPlacement(placement, error))
+        {
+            *out << "Cannot change placement: " << error << endl;
+            return;
+        }
+    }
+    else if (option == "adaptive")
+    {
+        dataManager->setAdaptivePlacement(on);
+        commitsAtLastRebalance = stats.committed;
+    }
+    else if (option == "hotaccesses")
+    {
+        long accesses;
+        if (!parseInteger(value, 1, LONG_MAX, accesses))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        PlacementPolicy policy = dataManager->getPlacementPolicy();
+        policy.hotAccesses = static_cast<uint64_t>(accesses);
+        dataManager->setPlacementPolicy(policy);
+    }
+    else if (option == "retention")
+    {
+        retentionEnabled = on;
+    }
+    else if (option == "memory")
+    {
+        long budget = 0;
+        if (value != "off" && !parseInteger(value, 1, LONG_MAX, budget))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        string error;
+        if (!dataManager->setMemoryBudget(static_cast<size_t>(budget), error))
+        {
+            *out << "Cannot set memory budget: " << error << endl;
+            return;
+        }
+    }
+    else if (option == "retry")
+    {
+        retryEnabled = on;
+        if (!on)
+        {
+            retries.clear();
+        }
+    }
+    else if (option == "retrylimit" || option == "retrybackoff")
+    {
+        long number;
+        if (!parseInteger(value, 1, INT_MAX, number))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        if (option == "retrylimit")
+        {
+            retryLimit = static_cast<int>(number);
+        }
+        else
+        {
+            retryBackoff = static_cast<int>(number);
+        }
+    }
+    else if (option == "scheduler")
+    {
+        if (!unadmitted.empty())
+        {
+            *out << "Option scheduler cannot change while transactions wait for admission." << endl;
+            return;
+        }
+        if (on && !scheduler)
+        {
+            scheduler.reset(new AdmissionScheduler());
+        }
+        else if (!on)
+        {
+            scheduler.reset();
+        }
+    }
+    else if (scheduler && option == "hotthreshold")
+    {
+        double threshold;
+        if (!parseReal(value, 0, threshold) || threshold == 0)
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        scheduler->setHotThreshold(threshold);
+    }
+    else if (option == "concurrency")
+    {
+        for (const auto &entry : transactions)
+        {
+            if (entry.second->getStatus() == TransactionStatus::ACTIVE)
+            {
+                *out << "Option concurrency cannot change while transactions are active." << endl;
+                return;
+            }
+        }
+        if (value == "2pl")
+        {
+            concurrencyMode = ConcurrencyMode::STRICT_2PL;
+        }
+        else if (value == "occ")
+        {
+            concurrencyMode = ConcurrencyMode::OCC;
+        }
+        else if (value == "ssi")
+        {
+            concurrencyMode = ConcurrencyMode::SSI;
+        }
+        else
+        {
+            *out << "Unknown concurrency mode: " << value << endl;
+            return;
+        }
+    }
+    else if (option == "twophasecommit")
+    {
+        if (on && !commitCoordinator)
+        {
+            commitCoordinator.reset(new CommitCoordinator(dataManager));
+        }
+        else if (!on)
+        {
+            commitCoordinator.reset();
+        }
+    }
+    else if (commitCoordinator && option == "commitbatching")
+    {
+        commitCoordinator->setBatching(on);
+    }
+    else if (commitCoordinator && option == "messagelatency")
+    {
+        MessageLatencyModel model = commitCoordinator->getLatencyModel();
+        if (!parseReal(value, 0, model.roundTripMicros))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        commitCoordinator->setLatencyModel(model);
+    }
+    else if (commitCoordinator && (option == "failonprepare" || option == "failbeforedecide"))
+    {
+        long siteId;
+        if (!parseInteger(value, 1, dataManager->getSiteCount(), siteId))
+        {
+            *out << "Invalid value for option " << option << ": " << value << endl;
+            return;
+        }
+        if (option == "failonprepare")
+        {
+            commitCoordinator->failOnPrepare(static_cast<int>(siteId));
+        }
+        else
+        {
+            commitCoordinator->failBeforeDecide(static_cast<int>(siteId));
+        }
+    }
+    else
+    {
+        *out << "Unknown option: " << option << endl;
+        return;
+    }
+    *out << "Option " << option << " set to " << value << "." << endl;
+}
+
+// Description: Sets or clears the read/write quorum of a replicated variable
+// Input: variableName, readQuorum (R), writeQuorum (W) - both 0 to clear
+// Output: None
+// Side Effects: Changes replication of the variable, prints confirmation or an error
+void TransactionManager::setQuorum(const string &variableName, int readQuorum, int writeQuorum)
+{
+    if (getVarIndex(variableName) == -1)
+    {
+        *out << "Invalid variable name: " << variableName << endl;
+        return;
+    }
+    if (readQuorum == 0 && writeQuorum == 0)
+    {
+        dataManager->clearQuorum(variableName);
+        *out << "Quorum for " << variableName << " cleared." << endl;
+        return;
+    }
+    string error;
+    if (!dataManager->setQuorum(variableName, readQuorum, writeQuorum, error))
+    {
+        *out << "Cannot set quorum for " << variableName << ": " << error << endl;
+        return;
+    }
+    *out << "Quorum for " << variableName << " set to R=" << readQuorum << ", W=" << writeQuorum
+         << "." << endl;
+}
+
+// Description: Registers a named snapshot at the current time
+// Input: snapshotName
+// Output: None
+// Side Effects: Retention keeps the versions visible at this time until the snapshot is released
+void TransactionManager::takeSnapshot(const string &snapshotName)
+{
+    if (snapshots.count(snapshotName) || transactions.count(snapshotName))
+    {
+        *out << "Snapshot " << snapshotName << " already exists." << endl;
+        return;
+    }
+    snapshots[snapshotName] = chrono::system_clock::now().time_since_epoch().count();
+    *out << "Snapshot " << snapshotName << " taken." << endl;
+}
+
+// Description: Unregisters a named snapshot
+// Input: snapshotName
+// Output: None
+// Side Effects: The next prune may drop versions only this snapshot needed
+void TransactionManager::releaseSnapshot(const string &snapshotName)
+{
+    if (!snapshots.erase(snapshotName))
+    {
+        *out << "Unknown snapshot: " << snapshotName << endl;
+        return;
+    }
+    *out << "Snapshot " << snapshotName << " released." << endl;
+}
+
+// Description: Runs the retention policy on request
+// Input: None
+// Output: None
+// Side Effects: Prunes versions at every site, prints the number dropped and kept
+void TransactionManager::pruneVersions()
+{
+    size_t pruned = applyRetention();
+    *out << "Pruned " << pruned << " versions; " << dataManager->getRetentionStats().versionsKept << " kept." << endl;
+}
+
+// Description: Prunes every version that no protected snapshot reads
+// Input: None
+// Output: size_t - versions dropped
+// Side Effects: Shrinks histories at the sites
+size_t TransactionManager::applyRetention()
+{
+    commitsAtLastPrune = stats.committed;
+    return dataManager->pruneVersions(getProtectedTimes());
+}
+
+// Description: Collects the timestamps whose snapshots must stay readable
+// Input: None
+// Output: vector<long> - unordered, possibly with repeats
+// Side Effects: None
+vector<long> TransactionManager::getProtectedTimes() const
+{
+    vector<long> protectedTimes;
+    for (const auto &snapshot : snapshots)
+    {
+        protectedTimes.push_back(snapshot.second);
+    }
+    // Active transactions still read at their start times (as-of transactions at their pinned time)
+    for (const auto &entry : transactions)
+    {
+        if (entry.second->getStatus() == TransactionStatus::ACTIVE)
+        {
+            protectedTimes.push_back(entry.second->getStartTime());
+        }
+    }
+    return protectedTimes;
+}
+
+// Description: Adds a replica of a variable on request
+// Input: variableName, siteId
+// Output: None
+// Side Effects: Copies the variable's history to the site, prints confirmation or an error
+void TransactionManager::addReplica(const string &variableName, int siteId)
+{
+    string error;
+    if (!dataManager->addReplica(variableName, siteId, error))
+    {
+        *out << "Cannot add a replica of " << variableName << " at site " << siteId << ": " << error << endl;
+        return;
+    }
+    *out << "Added a replica of " << variableName << " at site " << siteId << "." << endl;
+}
+
+// Description: Drops a replica of a variable on request
+// Input: variableName, siteId
+// Output: None
+// Side Effects: Removes the site's copy, prints confirmation or an error
+void TransactionManager::dropReplica(const string &variableName, int siteId)
+{
+    string error;
+    if (!dataManager->dropReplica(variableName, siteId, error))
+    {
+        *out << "Cannot drop the replica of " << variableName << " at site " << siteId << ": " << error << endl;
+        return;
+    }
+    *out << "Dropped the replica of " << variableName << " at site " << siteId << "." << endl;
+}
+
+// Description: Runs the placement policy on request
+// Input: None
+// Output: None
+// Side Effects: Adds and drops replicas, prints each move or that nothing changed
+void TransactionManager::rebalance()
+{
+    if (applyPlacement() == 0)
+    {
+        *out << "Placement unchanged." << endl;
+    }
+}
+
+// Description: Lets the placement policy move replicas according to recent accesses
+// Input: None
+// Output: size_t - replicas added or dropped
+// Side Effects: Changes placement, prints each move
+size_t TransactionManager::applyPlacement()
+{
+    commitsAtLastRebalance = stats.committed;
+    vector<PlacementMove> moves = dataManager->rebalance();
+    for (const PlacementMove &move : moves)
+    {
+        *out << (move.add ? "Added a replica of x" : "Dropped the replica of x") << move.variableIndex
+             << " at site " << move.siteId << " (reads " << move.reads << ", writes " << move.writes << ")." << endl;
+    }
+    return moves.size();
+}
+
+// Description: Adds a named subscriber to the change feed
+// Input: subscriberName, drop - drop the subscriber when it lags instead of skipping ahead
+// Output: None
+// Side Effects: The subscriber sees changes committed from now on; prints confirmation or an error
+void TransactionManager::subscribe(const string &subscriberName, bool drop)
+{
+    if (!dataManager->getChangeFeed())
+    {
+        *out << "Change capture is off." << endl;
+        return;
+    }
+    if (subscribers.count(subscriberName))
+    {
+        *out << "Subscriber " << subscriberName << " already exists." << endl;
+        return;
+    }
+    subscribers.emplace(subscriberName,
+                        ChangeSubscriber(*dataManager->getChangeFeed(), drop ? LagPolicy::DROP : LagPolicy::REPORT));
+    *out << "Subscriber " << subscriberName << " subscribed" << (drop ? " (dropped if it lags)" : "") << "." << endl;
+}
+
+// Description: Delivers pending changes to a named subscriber
+// Input: subscriberName
+// Output: None
+// Side Effects: Prints each change, or that the subscriber lagged or was dropped
+void TransactionManager::pollChanges(const string &subscriberName)
+{
+    auto it = subscribers.find(subscriberName);
+    if (it == subscribers.end())
+    {
+        *out << "Unknown subscriber: " << subscriberName << endl;
+        return;
+    }
+    vector<ChangeRecord> changes;
+    uint64_t missedBefore = it->second.getMissed();
+    PollStatus status = it->second.poll(changes);
+    if (status == PollStatus::DROPPED)
+    {
+        *out << subscriberName << " was dropped for lagging." << endl;
+        return;
+    }
+    if (status == PollStatus::LAGGED)
+    {
+        *out << subscriberName << " lagged: " << it->second.getMissed() - missedBefore << " changes missed." << endl;
+    }
+    for (const auto &change : changes)
+    {
+        *out << subscriberName << ": #" << change.sequence << " " << change.transaction << " wrote x"
+             << change.variableIndex << "=" << change.value << " at sites";
+        for (int siteId = 1; siteId <= 64; ++siteId)
+        {
+            if (change.siteMask & (uint64_t(1) << (siteId - 1)))
+            {
+                *out << " " << siteId;
+            }
+        }
+        *out << endl;
+    }
+    if (changes.empty() && status == PollStatus::OK)
+    {
+        *out << subscriberName << ": no new changes." << endl;
+    }
+}
+
+// Description: Removes a named subscriber
+// Input: subscriberName
+// Output: None
+// Side Effects: Prints confirmation or an error
+void TransactionManager::unsubscribe(const string &subscriberName)
+{
+    if (!subscribers.erase(subscriberName))
+    {
+        *out << "Unknown subscriber: " << subscriberName << endl;
+        return;
+    }
+    *out << "Subscriber " << subscriberName << " unsubscribed." << endl;
+}
+
+// Description: Starts collecting the body of a stored procedure
+// Input: procedureName, parameters - names the body refers to, bound by each CALL in order
+// Output: None
+// Side Effects: Following commands are recorded instead of executed until END
+void TransactionManager::beginDefinition(const string &procedureName, const vector<string> &parameters)
+{
+    defining = true;
+    definitionName = procedureName;
+    definitionParameters = parameters;
+    definitionBody.clear();
+}
+
+// Description: Compiles the procedure whose body was collected and registers it
+// Input: None
+// Output: None
+// Side Effects: Replaces any procedure of the same name; prints the outcome
+void TransactionManager::endDefinition()
+{
+    if (!defining)
+    {
+        *out << "No procedure is being defined." << endl;
+        return;
+    }
+    defining = false;
+    StoredProcedure procedure;
+    string error;
+    bool compiled = CommandParser::compileProcedure(definitionName, definitionParameters, definitionBody, procedure, error);
+    for (const auto &operation : procedure.operations)
+    {
+        bool usesVariable = operation.step == ProcedureStep::READ || operation.step == ProcedureStep::WRITE ||
+                            operation.step == ProcedureStep::INCREMENT;
+        if (compiled && usesVariable && operation.variable.parameter < 0 && !isVariableName(operation.variable.text))
+        {
+            compiled = false;
+            error = "invalid variable name " + operation.variable.text;
+        }
+    }
+    definitionBody.clear();
+    if (!compiled)
+    {
+        *out << "Cannot define procedure " << definitionName << ": " << error << endl;
+        return;
+    }
+    procedures[definitionName] = procedure;
+    *out << "Procedure " << definitionName << " defined with " << procedure.operations.size() << " operations." << endl;
+}
+
+// Description: Runs a stored procedure
+// Input: procedureName, arguments - one per parameter
+// Output: None
+// Side Effects: Checks and converts every argument first, then runs each operation as if its
+//               command had been read, printing the usual output; nothing runs if an argument is bad
+void TransactionManager::callProcedure(const string &procedureName, const vector<string> &arguments)
+{
+    auto found = procedures.find(procedureName);
+    if (found == procedures.end())
+    {
+        *out << "Unknown procedure: " << procedureName << endl;
+        ++procedureStats.rejected;
+        return;
+    }
+    const StoredProcedure &procedure = found->second;
+    if (arguments.size() != procedure.parameters.size())
+    {
+        *out << "Procedure " << procedureName << " takes " << procedure.parameters.size() << " arguments." << endl;
+        ++procedureStats.rejected;
+        return;
+    }
+    vector<int> values(arguments.size(), 0);
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        if (procedure.variableParameters[i] && !isVariableName(arguments[i]))
+        {
+            *out << "Argument " << procedure.parameters[i] << " of " << procedureName << " must be a variable: "
+                 << arguments[i] << endl;
+            ++procedureStats.rejected;
+            return;
+        }
+        if (procedure.valueParameters[i])
+        {
+            size_t used = 0;
+            try
+            {
+                values[i] = stoi(arguments[i], &used);
+            }
+            catch (const logic_error &)
+            {
+                used = 0;
+            }
+            if (used == 0 || used != arguments[i].size())
+            {
+                *out << "Argument " << procedure.parameters[i] << " of " << procedureName << " must be a number: "
+                     << arguments[i] << endl;
+                ++procedureStats.rejected;
+                return;
+            }
+        }
+    }
+
+    for (const auto &operation : procedure.operations)
+    {
+        const ProcedureOperand &transaction = operation.transaction;
+        const ProcedureOperand &variable = operation.variable;
+        const ProcedureOperand &value = operation.value;
+        const string &transactionName = transaction.parameter < 0 ? transaction.text : arguments[transaction.parameter];
+        const string &variableName = variable.parameter < 0 ? variable.text : arguments[variable.parameter];
+        int operand = value.parameter < 0 ? value.value : (value.negated ? -values[value.parameter] : values[value.parameter]);
+        switch (operation.step)
+        {
+        case ProcedureStep::BEGIN:
+            beginTransaction(transactionName, false);
+            break;
+        case ProcedureStep::BEGIN_RO:
+            beginTransaction(transactionName, true);
+            break;
+        case ProcedureStep::READ:
+            read(transactionName, variableName);
+            break;
+        case ProcedureStep::WRITE:
+            write(transactionName, variableName, operand);
+            break;
+        case ProcedureStep::INCREMENT:
+            increment(transactionName, variableName, operand);
+            break;
+        case ProcedureStep::END:
+            endTransaction(transactionName);
+            break;
+        }
+    }
+    ++procedureStats.calls;
+    procedureStats.operations += procedure.operations.size();
+}
+
+// Description: Prints metrics from the transaction and data managers
+// Input: None
+// Output: None
+// Side Effects: Prints to console
+void TransactionManager::printStats() const
+{
+    if (commitCoordinator)
+    {
+        const CommitStats &stats = commitCoordinator->getStats();
+        *out << "Two-phase commit: " << stats.transactions << " transactions (" << stats.aborted
+             << " voted down), " << stats.prepareMessages << " prepare and " << stats.decideMessages
+             << " decide messages in " << stats.roundTrips << " round trips, simulated messaging "
+             << stats.simulatedMicros << " us" << endl;
+    }
+    if (concurrencyMode == ConcurrencyMode::STRICT_2PL)
+    {
+        *out << "Strict 2PL: " << stats.lockWaits << " lock waits, " << stats.deadlocks << " deadlocks" << endl;
+    }
+    if (concurrencyMode == ConcurrencyMode::OCC)
+    {
+        *out << "OCC: " << stats.validationFailures << " failed validations" << endl;
+    }
+    if (scheduler)
+    {
+        const AdmissionStats &admission = scheduler->getStats();
+        *out << "Scheduler: " << admission.admitted << " admitted, " << admission.held << " held, aborts: "
+             << admission.heldAborts << " held, " << admission.otherAborts << " others; hot:";
+        for (const auto &entry : scheduler->getHeat())
+        {
+            if (scheduler->isHot(entry.first))
+            {
+                *out << " " << entry.first << " (" << entry.second << ")";
+            }
+        }
+        *out << endl;
+    }
+    if (!snapshots.empty())
+    {
+        *out << "Snapshots:";
+        for (const auto &snapshot : snapshots)
+        {
+            *out << " " << snapshot.first;
+        }
+        *out << endl;
+    }
+    if (procedureStats.calls + procedureStats.rejected > 0)
+    {
+        *out << "Procedures: " << procedures.size() << " defined, " << procedureStats.calls << " calls ran "
+             << procedureStats.operations << " operations, " << procedureStats.rejected << " calls rejected" << endl;
+    }
+    if (retryEnabled)
+    {
+        *out << "Retry: " << retryStats.retries << " retries, " << retryStats.commits << " commits ("
+             << retryStats.commitsAfterRetry << " after retrying, "
+             << (retryStats.commits ? (double)retryStats.retries / retryStats.commits : 0.0)
+             << " retries per commit), " << retryStats.givenUp << " gave up, " << retryStats.backoffCommands
+             << " commands of backoff" << endl;
+    }
+    dataManager->printStats();
+}
+
+// Description: Returns outcome and locking counters
+// Input: None
+// Output: TransactionStats
+// Side Effects: None
+const TransactionStats &TransactionManager::getTransactionStats() const
+{
+    return stats;
+}
+
+// Description: Returns counters of the automatic retry mode
+// Input: None
+// Output: RetryStats
+// Side Effects: None
+const RetryStats &TransactionManager::getRetryStats() const
+{
+    return retryStats;
 }
\ No newline at end of file